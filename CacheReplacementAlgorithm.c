@@ -21,62 +21,391 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <limits.h>
+#include <math.h>
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/queue.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 #include "CacheReplacementAlgorithm.h"
 
 // Configuration variables
 
-#define PRIVILEGED_PARTITION_SIZE 5
-#define UNPRIVILEGED_PARTITION_SIZE 5
+#define GCLOCK_MAX 8 // Highest GCLOCK count, a frame survives at most this many laps unreferenced
+#define FRAME_UNROLL_MAX 16 // Largest constant frame count scanned unrolled, larger ones use the --simd kernels
+#define RRIP_MAX 3          // Distant re-reference prediction of a 2-bit RRPV
+#define BRRIP_EPSILON 32    // BRRIP inserts one block in this many at RRIP_MAX - 1, the rest at RRIP_MAX
+#define DRRIP_LEADERS 32    // Sets dedicated to each of SRRIP and BRRIP by DRRIP's set dueling
+#define DRRIP_PSEL_MAX 1023 // Saturation of DRRIP's 10-bit policy selector
+#define LFRU_DEFAULT_RATIO 0.5 // Default share of LFRU frames in the privileged (LRU) partition
 
 int num_frames = 12;                // Number of avaliable pages in page tables, determined by the hardware and the system's memory capacity.  (e.g. 512MB / 4KB = 131072)
 int page_ref_upper_bound = 1048576; // Largest page reference, it depends on the size of the virtual address space. Memory Size (# of Blocks)(e.g. 4GB/4KB = 1048576)
 int max_page_calls = 1000;          // Max number of page reference to test(total number of page references or memory accesses )
 
+#ifdef CRA_SPECIALIZE
+const int debug = 0;     // Compiled out, so every debug branch folds away
+const int printrefs = 0; // Compiled out with debug
+#else
 int debug = 0;     // Debug bool, 1 shows verbose output
 int printrefs = 0; // Print refs bool, 1 shows output after each page ref
+#endif
+
+#define STREAM_CHUNK 4096             // Refs parsed per refill of the streaming ring
+#define STREAM_DEFAULT_WINDOW 65536   // Default --window, OPTIMAL-W's lookahead (and OPTIMAL's in streaming mode)
+#define DEFAULT_BATCH 1024            // Refs per timed block of a run without --batch that pages no ref at a time
+#define STREAM_FILE_BUFFER (1 << 20)  // stdio buffer for the streaming reader
+#define INGEST_MIN_BYTES (1 << 20)    // Text bytes per ingest thread before another one is used
+#define INGEST_MAX_THREADS 64
+
+int stream_mode = 0;      // Stream bool, 1 reads the whole trace in file order with bounded memory
+int batch_size = 0;       // Refs each algorithm replays per block, 0 pages all algorithms one ref at a time (see init())
+int num_threads = 0;      // Worker threads for sweeps and parallel runs, 0 pages on the main thread
+int ingest_threads = 0;   // Threads parsing a text trace, 0 for one per core and INGEST_MIN_BYTES
+int dense_pages = 0;      // Dense bool, 1 numbers the pages 0, 1, 2... in first-seen order
+int *sweep_frames = NULL; // Frame counts to sweep, NULL runs num_frames only
+int num_sweep_frames = 0;
+
+#define MAX_SWEEP_FRAMES 4096 // Frame counts a --frames spec may expand to
+
+#define STACK_DISTANCE_CAPACITY (1 << 20) // Initial time slots of the stack distance tree in streaming mode
+
+// Kernels for the struct-of-arrays scans, chosen by simd_init()
+int (*find_page_kernel)(const int *pages, int n, int page) = &find_page_scalar;
+int (*argmin_kernel)(const uint32_t *values, int n) = &argmin_scalar;
+int (*argmax_kernel)(const uint32_t *values, int n) = &argmax_scalar;
+void (*halve_kernel)(uint32_t *values, int n) = &halve_scalar;
+const char *simd_kernel = "scalar";
+const char *simd_choice = "auto"; // --simd
+
+double lfru_ratio = LFRU_DEFAULT_RATIO; // Share of LFRU frames in the privileged partition, the rest are LFU
+
+int victim_mode = VICTIM_HISTORY_OFF; // What add_victim() keeps, see --victims
+int victim_capacity = 1024;           // Victims a ring history keeps
+
+int mrc_mode = 0; // MRC bool, 1 computes the LRU hit ratio curve for every frame count in one pass
+int lookahead_window = 0; // Refs OPTIMAL-W (and OPTIMAL when streaming) may look ahead, 0 until init() sets it
+int prefetch_kind = PREFETCH_OFF; // --prefetch: prefetcher paired with every online policy
+int prefetch_degree = 1;          // Pages a prefetcher predicts each time it triggers
+int shadow_window = 0;            // --shadow: refs a re-referenced eviction counts as policy-induced for, 0 for no shadow
+
+#define SHARDS_MODULUS (1u << 24) // Page hashes are taken modulo this, the rate is threshold / modulus
+
+double sample_rate = 0;      // SHARDS sampling rate in (0, 1], 0 disables sampling
+int sample_size = 0;         // SHARDS fixed-size budget of tracked pages, 0 keeps the rate fixed
+int sample_error = 0;        // Error bool, 1 also runs exactly and reports the sampled error
+double frame_scale = 1.0;    // Page tables shrink by this when replaying a sampled trace
+
+#define MAX_TENANT_WEIGHTS 256 // pid=weight pairs a --tenants static spec may give
+#define UCP_UNITS 64           // UCP hands frames out in num_frames / UCP_UNITS units, like cache ways
+
+int pid_aware = 0;                 // Pid bool, 1 keys refs by (pid, page) instead of page alone
+int tenant_mode = TENANT_OFF;      // Per-pid results and partitions, see --tenants
+int tenant_weight_pids[MAX_TENANT_WEIGHTS]; // --tenants static weights, pids not listed weigh 1
+int tenant_weights[MAX_TENANT_WEIGHTS];
+int num_tenant_weights = 0;
+int ucp_interval = 0;              // Refs between UCP repartitions, 0 means 16 * num_frames
+
+int assoc_ways = 0;                // Ways per set with --assoc, 0 is one fully associative page table
+int line_shift = 0;                // log2 of --line-size, refs are divided into blocks of this size
+int set_index_mode = SET_INDEX_BITS; // How blocks map to sets, see --set-index
+
+int frame_bytes = 0;     // Bytes per frame with --frame-bytes, caches then hold num_frames * frame_bytes bytes of objects
+int trace_has_sizes = 0; // Sizes bool, 1 once a ref came with an object size
+
+#define LATENCY_CALIBRATION_NS 2000000 // CLOCK_MONOTONIC span the TSC is calibrated over
+
+int latency_report = 0;           // Latency bool, 1 prints ns/ref and hit/miss percentiles per algorithm
+int latency_sample = 64;          // Batched and parallel runs time one ref in this many for the histograms
+double latency_ns_per_tick = 1.0; // From latency_init(), 1 when latency_now() is already nanoseconds
+uint64_t latency_overhead = 0;    // Ticks two back-to-back latency_now() reads take
+
+#define MAX_CONCURRENT_THREADS 256 // Most threads --concurrent may scale to
+#define MAX_PREFETCH_DEGREE 64     // Most pages a prefetcher may predict at once
+#define CONCURRENT_BLOCK 4096      // Refs dealt to each thread at a time when the trace has fewer pids than threads
+#define CONCURRENT_SHARDS 16       // Shards of the --concurrent Sharded_Cache
+
+int concurrent_threads = 0;       // --concurrent: benchmark the concurrent caches on 1, 2, 4... up to this many threads
+
+#define BENCH_SUITE "zipf:0.8,zipf:0.99,zipf:1.2,scan,shift,mix" // Workloads of gen:suite
+#define WORKLOAD_PHASES 8 // Working set moves of a shift workload
+
+uint64_t gen_seed = 1;          // Seed of the workload generators and gen_ref()
+int gen_refs = 1000000;         // Refs a generated (gen:) workload has
+int gen_pages = 65536;          // Distinct pages a generated workload draws from
+const char *bench_path = NULL;  // --bench output, JSON if it ends in .json, else CSV
+
+#define OUTPUT_BUFFER (1 << 20) // stdio buffer of --output, --interval-out and --bench files
+
+const char *output_path = NULL;                // --output: final stats, JSON if it ends in .json, else CSV
+int interval_refs = 0;                         // --interval: refs between time series rows, 0 for none
+const char *interval_path = "intervals.csv";   // --interval-out, JSON if it ends in .json, else CSV
+
+#define CHECKPOINT_MAGIC "CRACKPT\0" // First 8 bytes of a checkpoint file
+#define CHECKPOINT_VERSION 6
+
+const char *checkpoint_path = NULL; // --checkpoint: the selected algorithms' state is saved here at the end
+int64_t checkpoint_every = 0;          // --checkpoint-every: refs between periodic saves, 0 saves at the end only
+int64_t checkpoint_at = 0;          // --checkpoint-at: stop and save once the trace position reaches this, 0 runs to the end
+const char *resume_path = NULL;     // --resume (or --warm) checkpoint loaded before the first ref
+int warm_start = 0;                 // Warm bool, 1 keeps the loaded caches but zeroes their counts and replays from ref 0
+uint64_t tick_base = 0;             // Logical ticks before trace position 0, so a warm start's stamps stay older
+
+#define ADAPTIVE_DEFAULT "LRU,LFRU,ARC,LIRS,W-TinyLFU" // ADAPTIVE's candidates without --adaptive
+#define ADAPTIVE_SAMPLE_RATE (1.0 / 32)  // Share of the pages the ADAPTIVE leaders see
+#define ADAPTIVE_MIN_LEADER_FRAMES 32    // Frames a leader keeps at least, the rate rises for small caches
+#define ADAPTIVE_MARGIN 0.05             // Share fewer misses a candidate needs than the current one to lead
+#define ADAPTIVE_PATIENCE 3              // Epochs in a row a candidate must lead before ADAPTIVE switches to it
+#define ADAPTIVE_HISTORY 16              // Refs per frame ADAPTIVE keeps to warm up the policy it switches to
+
+int adaptive_candidates[ADAPTIVE_MAX_CANDIDATES]; // --adaptive: algos[] indices ADAPTIVE chooses between
+int num_adaptive_candidates = 0;                  // 0 until parse_adaptive() runs
+int adaptive_epoch = 512;                         // --adaptive-epoch: sampled refs between ADAPTIVE's decisions
 
 // Array of algorithm functions that can be enabled
-Algorithm algos[12] = {{"OPTIMAL", &OPTIMAL, 0, NULL},
-                       {"RANDOM", &RANDOM, 0, NULL},
-                       {"FIFO", &FIFO, 0, NULL},
-                       {"LRU", &LRU, 0, NULL},
-                       {"CLOCK", &CLOCK, 0, NULL},
-                       {"NFU", &NFU, 0, NULL},
-                       {"AGING", &AGING, 0, NULL},
-                       {"MRU", &MRU, 0, NULL},
-                       {"NRU", &NRU, 0, NULL},
-                       {"MFU", &MFU, 0, NULL},
-                       {"LFRU", &LFRU, 0, NULL},
-                       {"LFU", &LFU, 0, NULL}};
+Algorithm algos[30] = {{.label = "OPTIMAL", .algo = &OPTIMAL, .setup = &initializeOptimal, .flags = ALGO_OFFLINE, .checkpoint = &checkpointOptimal},
+                       {.label = "RANDOM", .algo = &RANDOM, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "FIFO", .algo = &FIFO, .setup = &initializeRecency},
+                       {.label = "LRU", .algo = &LRU, .setup = &initializeRecency},
+                       {.label = "CLOCK", .algo = &CLOCK, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "NFU", .algo = &NFU, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "AGING", .algo = &AGING, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "MRU", .algo = &MRU, .setup = &initializeRecency},
+                       {.label = "NRU", .algo = &NRU, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "MFU", .algo = &MFU, .setup = &initializeFrequency},
+                       {.label = "LFRU", .algo = &LFRU, .setup = &initializeLFRU, .checkpoint = &checkpointLFRU},
+                       {.label = "LFU", .algo = &LFU, .setup = &initializeFrequency},
+                       {.label = "ARC", .algo = &ARC, .setup = &initializeARC, .checkpoint = &checkpointARC},
+                       {.label = "2Q", .algo = &TWOQ, .setup = &initializeTwoQ, .checkpoint = &checkpointTwoQ},
+                       {.label = "LIRS", .algo = &LIRS, .setup = &initializeLIRS, .checkpoint = &checkpointLIRS},
+                       {.label = "W-TinyLFU", .algo = &WTINYLFU, .setup = &initializeTinyLFU, .checkpoint = &checkpointTinyLFU},
+                       {.label = "GCLOCK", .algo = &GCLOCK, .setup = &initializeFrameArrays, .flags = ALGO_OWN_FRAMES},
+                       {.label = "CLOCK-Pro", .algo = &CLOCKPRO, .setup = &initializeClockPro, .checkpoint = &checkpointClockPro},
+                       {.label = "UCP", .algo = &UCP, .setup = &initializeUCP, .checkpoint = &checkpointUCP},
+                       {.label = "PLRU", .algo = &PLRU, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "BIT-PLRU", .algo = &BITPLRU, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "SRRIP", .algo = &SRRIP, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "BRRIP", .algo = &BRRIP, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "DRRIP", .algo = &DRRIP, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "HW-NRU", .algo = &HWNRU, .setup = &initializeSetCache, .flags = ALGO_SET_LOCAL | ALGO_OWN_FRAMES, .checkpoint = &checkpointSetCache},
+                       {.label = "SIZE-LRU", .algo = &SIZELRU, .setup = &initializeSizeCache, .flags = ALGO_SIZE_AWARE | ALGO_OWN_FRAMES, .checkpoint = &checkpointSizeCache},
+                       {.label = "GDSF", .algo = &GDSF, .setup = &initializeSizeCache, .flags = ALGO_SIZE_AWARE | ALGO_OWN_FRAMES, .checkpoint = &checkpointSizeCache},
+                       {.label = "LRU-2", .algo = &LRU2, .setup = &initializeSizeCache, .flags = ALGO_SIZE_AWARE | ALGO_OWN_FRAMES, .checkpoint = &checkpointSizeCache},
+                       {.label = "OPTIMAL-W", .algo = &OPTIMAL, .setup = &initializeOptimalWindow, .flags = ALGO_OFFLINE, .checkpoint = &checkpointOptimal},
+                       {.label = "ADAPTIVE", .algo = &ADAPTIVE, .setup = &initializeAdaptive, .flags = ALGO_OWN_FRAMES, .checkpoint = &checkpointAdaptive}};
 // LFRU section
 typedef struct
 {
-    Frame *frames; // Array of frames
-    int size;      // Size of the partition
+    Page_Map map;             // page -> frame
+    struct Frame_Queue order; // recency order, head is least recent
+    struct Frame_Queue free;  // frames holding no page
+    int size;                 // Size of the partition
 } Partition;
 
 typedef struct
 {
     Partition privileged;
-    Partition unprivileged;
+    Lfu unprivileged;           // LFU partition, over unprivileged_frames
+    Frame *unprivileged_frames;
 } LFRU_Data;
 
+// OPTIMAL section
+typedef struct
+{
+    Frame **slots;  // Page table frames by index
+    int *heap;      // Max-heap of frame indices keyed by next use
+    int *heap_pos;  // Position of each frame index in heap, -1 if not resident
+    int64_t *next_use; // Next use (ref position) of the page held by each frame
+    int size;       // Number of frames in the heap
+    int window;     // Refs it may look ahead, 0 for the whole trace
+} OPTIMAL_Data;
+
+// Ghost list section, list numbers (LIRS: page states) are kept in Frame.extra
+#define ARC_T1 0  // resident, seen once recently
+#define ARC_T2 1  // resident, seen at least twice recently
+#define ARC_B1 2  // ghosts evicted from T1
+#define ARC_B2 3  // ghosts evicted from T2
+typedef struct
+{
+    Ghost_Cache cache;
+    int p;              // target size of T1, adapted by ghost hits
+} ARC_Data;
+
+#define TWOQ_A1IN 0   // resident, first seen, FIFO
+#define TWOQ_A1OUT 1  // ghosts evicted from A1in, FIFO
+#define TWOQ_AM 2     // resident, seen again after leaving A1in, LRU
+typedef struct
+{
+    Ghost_Cache cache;
+    int kin;            // A1in frames before it gives up its oldest page
+    int kout;           // A1out ghosts
+} TWOQ_Data;
+
+#define LIRS_LIR 0    // resident, low inter-reference recency, on S
+#define LIRS_HIR_S 1  // resident HIR page on S and Q
+#define LIRS_HIR 2    // resident HIR page on Q only
+#define LIRS_GHOST 3  // non-resident HIR page on S and the ghost queue
+typedef struct
+{
+    Ghost_Cache cache;          // lists unused, S and Q are below
+    struct Frame_Queue stack;   // S through Frame.order, head is the bottom (least recent)
+    struct Frame_Queue queue;   // Q through Frame.queue, resident HIR pages, head is evicted first
+    struct Frame_Queue ghosts;  // ghosts on S through Frame.queue, oldest first
+    int lir_size;               // LIR pages
+    int lir_max;                // frames for LIR pages, the rest hold resident HIR pages
+} LIRS_Data;
+
+#define TLFU_WINDOW 0     // admission window, LRU
+#define TLFU_PROBATION 1  // main SLRU segment for pages admitted once
+#define TLFU_PROTECTED 2  // main SLRU segment for pages hit in probation
+typedef struct
+{
+    Ghost_Cache cache;          // no ghosts, only the frames and the page map
+    Count_Min_Sketch sketch;    // frequency of every ref, aged by halving
+    int window_max;
+    int main_max;               // probation + protected
+    int protected_max;
+} TinyLFU_Data;
+
+#define CLOCKPRO_HOT 0x1   // Frame.extra bits: hot (resident) rather than cold
+#define CLOCKPRO_TEST 0x2  // cold page in its test period
+#define CLOCKPRO_REF 0x4   // reference bit, set by a hit
+typedef struct
+{
+    Ghost_Cache cache;          // lists unused, the clock is below
+    struct Frame_Queue clock;   // hot, cold and non-resident cold pages through Frame.order, circular
+    Frame *hand_hot;            // oldest hot page, new pages go in right behind it (the list head)
+    Frame *hand_cold;           // next cold resident page to consider for eviction
+    Frame *hand_test;           // next cold page whose test period may be ended
+    int hot;                    // hot pages
+    int cold;                   // cold resident pages
+    int cold_target;            // m_c, adapted in 1...num_frames by test period outcomes
+} CLOCKPRO_Data;
+
+// UCP section
+typedef struct
+{
+    struct Frame_Queue **lru;   // per tenant, through Frame.order, head is least recent
+    struct Frame_Queue free;    // frames holding no page
+    int *occupancy;             // frames each tenant holds
+    int *quota;                 // frames each tenant may hold, from the last repartition
+    Stack_Distance *monitors;   // UMON: exact LRU stack distances of each tenant's own refs
+    double **utility;           // utility[t][d]: recent refs of t at stack distance d <= num_frames
+    int tenants;                // tenants with state allocated
+    int partitioned;            // 0 until the first repartition, a shared LRU before it
+    int refs;                   // refs since the last repartition
+    int interval;               // refs between repartitions
+} UCP_Data;
+
+// Object size section
+#define SIZE_LRU 0 // policies sharing Size_Data
+#define SIZE_GDSF 1
+#define SIZE_LRU2 2
+typedef struct
+{
+    double key;                 // GDSF: H = L + frequency / size; LRU-2: tick of the second to last ref, 0 if none
+    uint64_t tie;               // tick of the last ref, the older goes first on equal keys
+    Frame *frame;
+} Size_Entry;
+
+typedef struct
+{
+    Page_Map map;               // page -> frame, grown with the objects held
+    Frame_Block *blocks;        // frames, a block at a time so pointers to them stay valid
+    int block_used;             // frames taken from the newest block
+    struct Frame_Queue free;    // frames of evicted objects, reused first
+    struct Frame_Queue lru;     // SIZE-LRU order, head is least recent
+    Size_Entry *heap;           // GDSF and LRU-2 min-heap, Frame.extra is a frame's position
+    int heap_size;
+    int heap_capacity;
+    int objects;                // objects held
+    uint64_t used;              // sum of the held objects' Frame.size
+    uint64_t capacity;          // num_frames * frame_bytes bytes, or num_frames objects
+    double inflation;           // GDSF L, the priority of the last victim
+} Size_Data;
+
 // Runtime variables
-int counter = 0;        // "Time" as number of loops calling page_refs 0...num_refs (used as i in for loop)
-int last_page_ref = -1; // Last ref
+int64_t counter = 0;    // "Time" as number of loops calling page_refs 0...num_refs (used as i in for loop)
 size_t num_algos = 0;   // Number of algorithms in algos, calculated in init()
-int *optimum_find_test;
-int num_refs = 0; // Number of page refs in page_refs list
+int *next_use_index = NULL; // Position of the next ref to the same page for each ref position, INT_MAX if never
+int *prev_use_index = NULL; // Position of the previous ref to the same page for each ref position, -1 if none
+int num_refs = 0; // Number of page refs in the in-memory trace
+Trace_Stream trace_stream; // Streaming reader, used when stream_mode is set
+Trace_Map trace_map;       // Mapped binary trace, if the input file is one
+const uint32_t *trace_pages = NULL; // Trace in get_ref() order when not streaming
+uint32_t *trace_array = NULL;       // trace_pages when it was built from a text trace, generated or made dense
+uint32_t *sample_array = NULL;      // trace_pages after sample_trace() filtered it
+const uint32_t *exact_pages = NULL; // Unsampled trace, kept for --sample-error
+int exact_refs = 0;
+Key_Map ref_keys;                   // (pid, page) -> the key it is paged by, with --pid-aware
+Key_Map tenant_map;                 // pid -> tenant index
+int *tenant_pids = NULL;            // pid of each tenant, in first-seen order
+int num_tenants = 0;
+int *trace_tenants = NULL;          // tenant of each trace_pages ref, with --tenants
+const uint32_t *trace_sizes = NULL; // object size of each trace_pages ref, NULL if the trace has none
+uint32_t *size_array = NULL;        // trace_sizes when it was built from a text trace or sampled
+const char *trace_name = NULL;      // Input file, as given
+const char *workload_specs = NULL;  // Workloads a gen: input names, NULL for a trace file
+Rng gen_rng;                        // gen_ref() and get_ref() stream, seeded by --seed
+FILE *interval_file = NULL;         // --interval rows, shared by every algorithm (and job thread)
+int interval_json = 0;
+int interval_rows = 0;              // rows written, under the interval_file lock
+
+// Logical time of the ref being paged, one tick per ref so stamps are deterministic
+// Ticks start at 1, a stamp of 0 means the frame was never used
+uint64_t current_tick(Algorithm_Data *data)
+{
+    return tick_base + (uint64_t)data->position + 1;
+}
 
+#ifndef CRA_NO_MAIN
 // Run algorithm if given correct arguments, else terminate with error
 int main(int argc, char *argv[])
 {
 
-    if (argc < 5 || argc > 6)
+    if (argc >= 4 && strcmp(argv[1], "--convert") == 0)
+    {
+        int compress = 0, dense = 0;
+        for (int i = 4; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--varint") == 0)
+                compress = 1;
+            else if (strcmp(argv[i], "--dense") == 0)
+                dense = 1;
+            else if (strcmp(argv[i], "--ingest-threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 1)
+                ingest_threads = atoi(argv[++i]);
+            else
+            {
+                print_help(argv[0]);
+                return 1;
+            }
+        }
+        return convert_trace(argv[2], argv[3], compress, dense) == 0 ? 0 : 1;
+    }
+
+    // Positional arguments come first, --options follow them
+    int positional = 1;
+    while (positional < argc && strncmp(argv[positional], "--", 2) != 0)
+        positional++;
+    if (positional < 5 || positional > 6)
+    {
+        print_help(argv[0]);
+        return 1;
+    }
+    if (parse_options(argc - positional, argv + positional) != 0)
     {
         print_help(argv[0]);
         return 1;
@@ -85,8 +414,15 @@ int main(int argc, char *argv[])
     const char *filename = argv[1];
     const char *algorithm = argv[2];
     num_frames = atoi(argv[3]);
-    printrefs = (argc > 4) ? atoi(argv[4]) : 0;
-    debug = (argc > 5) ? atoi(argv[5]) : 0;
+#ifdef CRA_SPECIALIZE
+    if ((positional > 4 && atoi(argv[4])) || (positional > 5 && atoi(argv[5])))
+        printf("show_process and debug are compiled out of this build (-DCRA_SPECIALIZE)\n");
+#else
+    printrefs = (positional > 4) ? atoi(argv[4]) : 0;
+    debug = (positional > 5) ? atoi(argv[5]) : 0;
+#endif
+    if (printrefs || debug)
+        setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER); // Page tables go out in large writes
 
     printf("Attempting to open file: %s\n", filename);
 
@@ -99,8 +435,372 @@ int main(int argc, char *argv[])
     // Calculate number of algos
     num_algos = sizeof(algos) / sizeof(Algorithm);
 
-    char algo_code = algorithm[0]; // Use the first character of the algorithm string
-    switch (algo_code)
+    if (select_algorithms(algorithm) != 0)
+    {
+        printf("Invalid algorithm choice\n");
+        print_help(argv[0]);
+        return 1;
+    }
+
+    if (simd_init(simd_choice) != 0)
+    {
+        printf("SIMD kernel %s is not supported here, using %s\n", simd_choice, simd_kernel);
+    }
+
+    latency_init();
+
+    // Initialize and generate page references
+    init(filename);
+
+    // Run the event loop
+    event_loop();
+
+    // Clean up and exit
+    cleanup();
+    return 0;
+}
+#endif
+
+// Parse --options given after the positional arguments
+int parse_options(int argc, char *argv[])
+{
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--stream") == 0)
+        {
+            stream_mode = 1;
+        }
+        else if (strcmp(argv[i], "--dense") == 0)
+        {
+            dense_pages = 1;
+        }
+        else if (strcmp(argv[i], "--ingest-threads") == 0 && i + 1 < argc)
+        {
+            ingest_threads = atoi(argv[++i]);
+            if (ingest_threads < 1)
+            {
+                printf("Ingest threads must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch_size = atoi(argv[++i]);
+            if (batch_size < 1)
+            {
+                printf("Batch size must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--mrc") == 0)
+        {
+            mrc_mode = 1;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            if (parse_frame_spec(argv[++i]) != 0)
+            {
+                printf("Invalid frame spec: %s (e.g. 1..65536:pow2, 16..256:16 or 8,16,32)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 1)
+            {
+                printf("Number of threads must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc)
+        {
+            sample_rate = atof(argv[++i]);
+            if (!(sample_rate > 0 && sample_rate <= 1))
+            {
+                printf("Sample rate must be in (0, 1]\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sample-size") == 0 && i + 1 < argc)
+        {
+            sample_size = atoi(argv[++i]);
+            if (sample_size < 1)
+            {
+                printf("Sample size must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--sample-error") == 0)
+        {
+            sample_error = 1;
+        }
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+        {
+            simd_choice = argv[++i];
+        }
+        else if (strcmp(argv[i], "--lfru-ratio") == 0 && i + 1 < argc)
+        {
+            lfru_ratio = atof(argv[++i]);
+            if (!(lfru_ratio > 0 && lfru_ratio < 1))
+            {
+                printf("LFRU ratio must be in (0, 1)\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--pid-aware") == 0)
+        {
+            pid_aware = 1;
+        }
+        else if (strcmp(argv[i], "--tenants") == 0 && i + 1 < argc)
+        {
+            if (parse_tenant_mode(argv[++i]) != 0)
+            {
+                printf("Invalid tenant mode: %s (global, static or static:PID=W,PID=W...)\n", argv[i]);
+                return 1;
+            }
+            pid_aware = 1; // Tenants never share a page
+        }
+        else if (strcmp(argv[i], "--ucp-interval") == 0 && i + 1 < argc)
+        {
+            ucp_interval = atoi(argv[++i]);
+            if (ucp_interval < 1)
+            {
+                printf("UCP interval must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--assoc") == 0 && i + 1 < argc)
+        {
+            assoc_ways = atoi(argv[++i]);
+            if (assoc_ways < 1)
+            {
+                printf("Associativity must be at least 1 way\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--line-size") == 0 && i + 1 < argc)
+        {
+            int size = atoi(argv[++i]);
+            if (size < 1 || (size & (size - 1)) != 0)
+            {
+                printf("Line size must be a power of two\n");
+                return 1;
+            }
+            for (line_shift = 0; (1 << line_shift) < size; line_shift++)
+                ;
+        }
+        else if (strcmp(argv[i], "--set-index") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (strcmp(argv[i], "bits") == 0)
+                set_index_mode = SET_INDEX_BITS;
+            else if (strcmp(argv[i], "hash") == 0)
+                set_index_mode = SET_INDEX_HASH;
+            else
+            {
+                printf("Invalid set index: %s (bits or hash)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--frame-bytes") == 0 && i + 1 < argc)
+        {
+            frame_bytes = atoi(argv[++i]);
+            if (frame_bytes < 1)
+            {
+                printf("Frame size must be at least 1 byte\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--concurrent") == 0 && i + 1 < argc)
+        {
+            concurrent_threads = atoi(argv[++i]);
+            if (concurrent_threads < 1 || concurrent_threads > MAX_CONCURRENT_THREADS)
+            {
+                printf("Concurrent threads must be in 1...%d\n", MAX_CONCURRENT_THREADS);
+                return 1;
+            }
+            if (tenant_mode == TENANT_OFF)
+                tenant_mode = TENANT_GLOBAL; // Refs are split over the threads by pid
+            pid_aware = 1;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            gen_seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--gen-refs") == 0 && i + 1 < argc)
+        {
+            gen_refs = atoi(argv[++i]);
+            if (gen_refs < 1)
+            {
+                printf("Generated refs must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--gen-pages") == 0 && i + 1 < argc)
+        {
+            gen_pages = atoi(argv[++i]);
+            if (gen_pages < 2)
+            {
+                printf("Generated pages must be at least 2\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+        {
+            bench_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+        {
+            interval_refs = atoi(argv[++i]);
+            if (interval_refs < 1)
+            {
+                printf("Interval must be at least 1 ref\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--interval-out") == 0 && i + 1 < argc)
+        {
+            interval_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--latency") == 0)
+        {
+            latency_report = 1;
+        }
+        else if (strcmp(argv[i], "--latency-sample") == 0 && i + 1 < argc)
+        {
+            latency_sample = atoi(argv[++i]);
+            if (latency_sample < 1)
+            {
+                printf("Latency sample must be at least 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--victims") == 0 && i + 1 < argc)
+        {
+            if (parse_victim_mode(argv[++i]) != 0)
+            {
+                printf("Invalid victim history: %s (off, ring, ring:N or pool)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc)
+        {
+            if (parse_prefetch(argv[++i]) != 0)
+            {
+                printf("Invalid prefetcher: %s (seq[:D] or stride[:D])\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--adaptive") == 0 && i + 1 < argc)
+        {
+            if (parse_adaptive(argv[++i]) != 0)
+                return 1;
+        }
+        else if (strcmp(argv[i], "--adaptive-epoch") == 0 && i + 1 < argc)
+        {
+            adaptive_epoch = atoi(argv[++i]);
+            if (adaptive_epoch < 1)
+            {
+                printf("Adaptive epoch must be at least 1 sampled ref\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--shadow") == 0 && i + 1 < argc)
+        {
+            shadow_window = atoi(argv[++i]);
+            if (shadow_window < 1)
+            {
+                printf("Shadow window must be at least 1 ref\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpoint_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+        {
+            checkpoint_every = atoll(argv[++i]);
+            if (checkpoint_every < 1)
+            {
+                printf("Checkpoint interval must be at least 1 ref\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--checkpoint-at") == 0 && i + 1 < argc)
+        {
+            checkpoint_at = atoll(argv[++i]);
+            if (checkpoint_at < 1)
+            {
+                printf("Checkpoint position must be at least 1 ref\n");
+                return 1;
+            }
+        }
+        else if ((strcmp(argv[i], "--resume") == 0 || strcmp(argv[i], "--warm") == 0) && i + 1 < argc)
+        {
+            warm_start = strcmp(argv[i], "--warm") == 0;
+            resume_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            lookahead_window = atoi(argv[++i]);
+            if (lookahead_window < 1)
+            {
+                printf("Lookahead window must be at least 1\n");
+                return 1;
+            }
+        }
+        else
+        {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if ((checkpoint_every > 0 || checkpoint_at > 0) && checkpoint_path == NULL)
+    {
+        printf("--checkpoint-every and --checkpoint-at need --checkpoint FILE\n");
+        return 1;
+    }
+    if (sample_error && sample_rate == 0 && sample_size == 0)
+    {
+        printf("--sample-error needs --sample-rate or --sample-size\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Select algorithms by label ("ARC"), a comma-separated list of labels ("LRU,ARC,2Q"), or by
+// the one-letter code of an original algorithm ('a' selects all). Labels ignore case.
+int select_algorithms(const char *spec)
+{
+    char names[256];
+    int matched = 1, count = 0;
+    snprintf(names, sizeof(names), "%s", spec);
+    for (char *save = NULL, *name = strtok_r(names, ",", &save); name != NULL && matched; name = strtok_r(NULL, ",", &save))
+    {
+        matched = 0;
+        count++;
+        for (size_t i = 0; i < num_algos; i++)
+            matched |= (strcasecmp(name, algos[i].label) == 0);
+    }
+    if (matched && count > 0)
+    { // Every name is a label
+        snprintf(names, sizeof(names), "%s", spec);
+        for (char *save = NULL, *name = strtok_r(names, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
+            for (size_t i = 0; i < num_algos; i++)
+                if (strcasecmp(name, algos[i].label) == 0)
+                    algos[i].selected = 1;
+        return 0;
+    }
+    if (strchr(spec, ',') != NULL)
+        return -1;
+
+    switch (spec[0])
     {
     case 'O': // OPTIMAL
         algos[0].selected = 1;
@@ -137,7 +837,7 @@ int main(int argc, char *argv[])
         break;
     case 'f': // LFRU
         algos[11].selected = 1;
-        break;    
+        break;
     case 'a': // ALL
         for (size_t i = 0; i < num_algos; i++)
         {
@@ -145,555 +845,7290 @@ int main(int argc, char *argv[])
         }
         break;
     default:
-        printf("Invalid algorithm choice\n");
-        print_help(argv[0]);
-        return 1;
+        return -1;
     }
-
-    // Initialize and generate page references
-    init(filename);
-
-    // Run the event loop
-    event_loop();
-
-    // Clean up and exit
-    cleanup();
     return 0;
 }
 
-int init(const char *filename)
+// Parse a --frames spec: "lo..hi:pow2" doubles, "lo..hi:step" adds step, "a,b,c" lists counts
+int parse_frame_spec(const char *spec)
 {
-    gen_page_refs(filename);
-    // Calculate number of algos
-    num_algos = sizeof(algos) / sizeof(Algorithm);
+    int lo, hi, step = 1;
+    char kind[8] = "";
+    free(sweep_frames);
+    sweep_frames = malloc(sizeof(int) * MAX_SWEEP_FRAMES);
+    num_sweep_frames = 0;
+    if (!sweep_frames)
+        return -1;
+
+    if (sscanf(spec, "%d..%d:%7s", &lo, &hi, kind) >= 2)
+    {
+        int pow2 = strcmp(kind, "pow2") == 0;
+        if (!pow2 && kind[0] != '\0')
+            step = atoi(kind);
+        if (lo < 1 || hi < lo || step < 1)
+            return -1;
+        for (long f = lo; f <= hi && num_sweep_frames < MAX_SWEEP_FRAMES; f = pow2 ? f * 2 : f + step)
+            sweep_frames[num_sweep_frames++] = (int)f;
+    }
+    else
+    {
+        const char *p = spec;
+        while (*p != '\0' && num_sweep_frames < MAX_SWEEP_FRAMES)
+        {
+            char *end;
+            long f = strtol(p, &end, 10);
+            if (end == p || f < 1 || f > INT_MAX || (*end != ',' && *end != '\0'))
+                return -1;
+            sweep_frames[num_sweep_frames++] = (int)f;
+            p = *end == ',' ? end + 1 : end;
+        }
+    }
+    return num_sweep_frames > 0 ? 0 : -1;
+}
+
+int init(const char *filename)
+{
+    if (tenant_mode != TENANT_OFF && (sample_rate > 0 || sample_size > 0))
+    {
+        printf("--tenants does not combine with sampling\n");
+        exit(1);
+    }
+    if (frame_bytes > 0 && (assoc_ways > 0 || tenant_mode == TENANT_STATIC))
+    {
+        printf("--frame-bytes caches do not split into sets or tenant partitions\n");
+        exit(1);
+    }
+    if (tenant_mode == TENANT_STATIC && assoc_ways > 0)
+    {
+        printf("--tenants static and --assoc both split the page table, use one\n");
+        exit(1);
+    }
+    if (prefetch_kind != PREFETCH_OFF && (assoc_ways > 0 || tenant_mode != TENANT_OFF || frame_bytes > 0))
+    {
+        printf("--prefetch fills one fully associative page table, without tenants or object sizes\n");
+        exit(1);
+    }
+    if (concurrent_threads > 0 && (stream_mode || assoc_ways > 0 || tenant_mode == TENANT_STATIC || frame_bytes > 0))
+    {
+        printf("--concurrent replays one fully associative cache from a trace in memory\n");
+        exit(1);
+    }
+    if ((bench_path != NULL || strncmp(filename, "gen:", 4) == 0) && (stream_mode || sample_rate > 0 || sample_size > 0))
+    {
+        printf("Generated workloads and --bench run on the whole trace in memory, without sampling\n");
+        exit(1);
+    }
+    if (tenant_mode == TENANT_STATIC && stream_mode)
+    {
+        printf("--tenants static needs every tenant known up front, drop --stream\n");
+        exit(1);
+    }
+    if ((checkpoint_path != NULL || resume_path != NULL) &&
+        (sweep_frames != NULL || num_threads > 0 || concurrent_threads > 0 || bench_path != NULL || mrc_mode || sample_error))
+    {
+        printf("Checkpoints save one sequential or --batch run, not sweeps, --threads, --concurrent, --bench or --mrc\n");
+        exit(1);
+    }
+    if (dense_pages && (stream_mode || bench_path != NULL || concurrent_threads > 0 || prefetch_kind != PREFETCH_OFF || warm_start))
+    {
+        printf("--dense renumbers the whole trace in memory, not with --stream, --bench, --concurrent, --prefetch or --warm\n");
+        exit(1);
+    }
+    if (shadow_window > 0 && (sweep_frames != NULL || concurrent_threads > 0 || bench_path != NULL || mrc_mode || sample_error))
+    {
+        printf("--shadow reports on each algorithm of one run, not on sweeps, --concurrent, --bench or --mrc\n");
+        exit(1);
+    }
+    if (warm_start && pid_aware)
+    {
+        printf("--warm replays pages by number, --pid-aware and --tenants keys are ids of one trace\n");
+        exit(1);
+    }
+    if ((pid_aware && key_map_init(&ref_keys, 1024) != 0) || key_map_init(&tenant_map, 16) != 0)
+        exit(1);
+    trace_name = filename;
+    rng_seed(&gen_rng, gen_seed);
+    if (interval_refs > 0)
+    {
+        if (!(interval_file = open_output(interval_path, &interval_json)))
+            exit(1);
+        if (interval_json)
+            fprintf(interval_file, "[");
+        else
+            fprintf(interval_file, "algorithm,frames,refs,hits,misses,hit_ratio,evictions,ns_per_ref,total_hit_ratio\n");
+    }
+    // Without --batch a run still replays blocks, each timed once, unless something needs every
+    // algorithm to page each ref in turn: show_process, debug, or --latency's per-ref percentiles
+    if (batch_size == 0 && !printrefs && !debug && !latency_report && sweep_frames == NULL && num_threads == 0 &&
+        !sample_error)
+        batch_size = DEFAULT_BATCH;
+    if (stream_mode)
+    {
+        // Only OPTIMAL and OPTIMAL-W look ahead, everything else streams with a chunk-sized ring
+        if (algos[0].selected == 0 && algos[28].selected == 0)
+            lookahead_window = 0;
+        else if (lookahead_window == 0)
+            lookahead_window = STREAM_DEFAULT_WINDOW;
+        // A whole block is popped before it is paged, so keep it in the ring
+        if (open_trace_stream(&trace_stream, filename, lookahead_window, batch_size > 0 ? batch_size : 1) != 0)
+            exit(1);
+        // Policies replay only the sampled refs, the --mrc sampler filters for itself
+        if (!mrc_mode && (sample_rate > 0 || sample_size > 0))
+        {
+            if (sample_size > 0 || sample_error)
+            {
+                printf("--sample-size and --sample-error need the trace in memory, use --sample-rate with --stream\n");
+                exit(1);
+            }
+            trace_stream.sample_threshold = sample_threshold_of(sample_rate);
+            frame_scale = (double)trace_stream.sample_threshold / SHARDS_MODULUS;
+        }
+    }
+    else
+    {
+        if (lookahead_window == 0) // OPTIMAL sees the whole trace in memory, OPTIMAL-W only this much of it
+            lookahead_window = STREAM_DEFAULT_WINDOW;
+        int mapped = strncmp(filename, "gen:", 4) == 0 ? 2 : map_trace(&trace_map, filename);
+        if (mapped < 0)
+            exit(1);
+        if (mapped == 2)
+        {
+            workload_specs = strcmp(filename + 4, "suite") == 0 ? BENCH_SUITE : filename + 4;
+            if (bench_path == NULL && strchr(workload_specs, ',') != NULL)
+            {
+                printf("A list of workloads needs --bench\n");
+                exit(1);
+            }
+            if (load_workload(workload_specs) != 0) // The first one, --bench makes the rest
+                exit(1);
+        }
+        else if (mapped == 0)
+        {
+            load_mapped_trace(&trace_map);
+        }
+        else
+        {
+            gen_page_refs(filename);
+        }
+        if (dense_pages && densify_trace() != 0)
+            exit(1);
+        if (!mrc_mode && (sample_rate > 0 || sample_size > 0) && sample_trace() != 0)
+            exit(1);
+        if (shadow_window > 0 && build_prev_use_index() != 0)
+            exit(1);
+    }
+    // Calculate number of algos
+    num_algos = sizeof(algos) / sizeof(Algorithm);
     size_t i = 0;
+    if (frame_bytes > 0)
+    {
+        if (!stream_mode && !trace_has_sizes)
+            printf("The trace gives no object sizes, every object takes 1 byte\n");
+        for (i = 0; i < num_algos; ++i)
+        {
+            if (algos[i].selected == 1 && !(algos[i].flags & ALGO_SIZE_AWARE))
+            {
+                printf("Skipping %s with --frame-bytes, it does not evict by size\n", algos[i].label);
+                algos[i].selected = 0;
+            }
+        }
+    }
     for (i = 0; i < num_algos; ++i)
     {
-        algos[i].data = create_algo_data_store();
+        if (algos[i].selected == 1)
+            algos[i].data = setup_algo_data(&algos[i], scaled_frames(num_frames));
+        else
+            algos[i].data = create_algo_data_store(scaled_frames(num_frames), 0);
     }
+    if (tenant_mode != TENANT_OFF)
+        printf("Tenants: %d pids%s\n", num_tenants, stream_mode ? " so far" : "");
+    if (assoc_ways > 0)
+        printf("Set-associative: %d sets x %d ways, %s set index\n", scaled_frames(num_frames) / assoc_ways, assoc_ways,
+               set_index_mode == SET_INDEX_HASH ? "hashed" : "bit");
     return 0;
 }
 
-// Generate all page refs to use in tests
+// Load a text trace into the in-memory trace arrays
+// Only the last max_page_calls lines are kept, and they are paged last line first
 void gen_page_refs(const char *filename)
 {
     printf("Opening file: %s\n", filename); // Add this line for debugging
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    Text_Trace text;
+    if (read_text_trace(filename, &text) != 0)
+        exit(1);
+    trace_has_sizes = text.first_sized >= 0;
+    int n = text.num_refs < max_page_calls ? text.num_refs : max_page_calls;
+    uint32_t *pages = malloc(sizeof(uint32_t) * (n > 0 ? n : 1));
+    if (!pages || (tenant_mode != TENANT_OFF && !(trace_tenants = malloc(sizeof(int) * (n > 0 ? n : 1)))) ||
+        (trace_has_sizes && !(size_array = malloc(sizeof(uint32_t) * (n > 0 ? n : 1)))))
     {
-        perror("Error opening file");
-        exit(1); // Changed from exit(1) to allow graceful termination.
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        int j = text.num_refs - 1 - i;
+        if (trace_tenants)
+            trace_tenants[i] = tenant_of(text.pids[j]);
+        if (size_array)
+            size_array[i] = text.sizes[j];
+        pages[i] = (uint32_t)ref_key(text.pids[j], text.pages[j]);
     }
+    text_trace_free(&text);
+    num_refs = n;
+    trace_sizes = size_array;
+    trace_pages = trace_array = pages;
+}
 
-    int pid, page;
-    LIST_INIT(&page_refs);
-    while (fscanf(file, "%d %d", &pid, &page) == 2)
+// Number the in-memory trace's pages 0, 1, 2... in the order they are first referenced, so
+// the arrays sized by page_ref_upper_bound (OPTIMAL's last use, stack distances) shrink to the
+// distinct pages and sparse pages past the old bound skip the hash tables
+int densify_trace()
+{
+    uint32_t *pages = trace_array != NULL ? trace_array : trace_map.decoded;
+    if (pages == NULL && !(pages = malloc(sizeof(uint32_t) * (num_refs > 0 ? num_refs : 1))))
+    {
+        fprintf(stderr, "Memory allocation failed for dense pages\n");
+        return -1;
+    }
+    Key_Map ids;
+    if (key_map_init(&ids, 1024) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed for dense pages\n");
+        return -1;
+    }
+    for (int i = 0; i < num_refs; i++)
     {
-        Page_Ref *new_ref = malloc(sizeof(Page_Ref));
-        if (!new_ref)
+        int id = key_map_id(&ids, trace_pages[i]);
+        if (id < 0)
         {
-            fprintf(stderr, "Memory allocation failed\n");
-            fclose(file);
-            return;
+            fprintf(stderr, "Memory allocation failed for dense pages\n");
+            key_map_free(&ids);
+            return -1;
         }
-        new_ref->page_num = page;
-        // Uncomment next line if Page_Ref struct has pid field
-        new_ref->pid = pid;
-        LIST_INSERT_HEAD(&page_refs, new_ref, pages);
-        num_refs++;
+        pages[i] = (uint32_t)id;
     }
+    if (trace_array == NULL && trace_map.decoded == NULL)
+        trace_array = pages; // the trace was used in place from its mmap
+    trace_pages = pages;
+    printf("Dense pages: %d distinct (page_ref_upper_bound %d -> %d)\n", ids.size, page_ref_upper_bound,
+           ids.size > 0 ? ids.size : 1);
+    page_ref_upper_bound = ids.size > 0 ? ids.size : 1;
+    key_map_free(&ids);
+    return 0;
+}
+
+// Ingest section
+// Text traces are parsed by hand rather than with sscanf. A whole trace is mmapped and cut at
+// newlines into one slice per ingest thread; a streamed one is parsed a batch at a time by a
+// reader thread that stays INGEST_BATCHES batches ahead of the simulation.
 
-    fclose(file);
+// Read an optionally signed decimal after blanks, 0 if there is none
+static int parse_text_number(const char **cursor, const char *end, int64_t *value)
+{
+    const char *p = *cursor;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f'))
+        p++;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if (p == end || *p < '0' || *p > '9')
+        return 0;
+    int64_t v = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        if (v < INT64_MAX / 10)
+            v = v * 10 + (*p - '0');
+    }
+    *value = negative ? -v : v;
+    *cursor = p;
+    return 1;
 }
 
-// Generate a random page ref within bounds
-Page_Ref *gen_ref()
+// Pages run from 0 to INT_MAX, -1 marks an empty slot in the page maps and frame arrays, so a
+// trace holding any other page would hit or miss it depending on the data structure
+int check_page(int64_t page)
 {
-    Page_Ref *page = malloc(sizeof(Page_Ref));
-    page->page_num = rand() % page_ref_upper_bound;
-    return page;
+    if (page >= 0 && page <= INT_MAX)
+        return (int)page;
+    fprintf(stderr, "Page %lld is out of range, page numbers run from 0 to %d\n", (long long)page, INT_MAX);
+    exit(1);
 }
 
-// Function to initialize and allocate LFRU partitions
-void initializeLFRUPartitions(Algorithm_Data *data, int privilegedSize, int unprivilegedSize)
+// Parse the "pid page [size]" line at *cursor and move past it, the size defaults to 1
+// Returns 1 for a ref, 0 for a blank line, -1 for a line that ends the trace
+int parse_trace_text(const char **cursor, const char *end, int *pid, int *page, uint32_t *size, int *sized)
 {
-    LFRU_Data *lfru_data = malloc(sizeof(LFRU_Data));
-    if (!lfru_data)
+    const char *line_end = memchr(*cursor, '\n', end - *cursor);
+    const char *p = *cursor;
+    *cursor = line_end != NULL ? line_end + 1 : end;
+    if (line_end == NULL)
+        line_end = end;
+    int64_t v[3];
+    if (!parse_text_number(&p, line_end, &v[0]))
     {
-        // Handle allocation failure
-        fprintf(stderr, "Failed to allocate memory for LFRU data\n");
-        return;
+        while (p < line_end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f'))
+            p++;
+        return p == line_end ? 0 : -1;
     }
+    if (!parse_text_number(&p, line_end, &v[1]))
+        return -1;
+    *pid = (int)v[0];
+    *page = check_page(v[1]);
+    *size = 1;
+    *sized = parse_text_number(&p, line_end, &v[2]);
+    if (*sized && v[2] > 0 && v[2] <= UINT32_MAX)
+        *size = (uint32_t)v[2];
+    return 1;
+}
 
-    // Allocate and initialize privileged partition
-    lfru_data->privileged.frames = calloc(privilegedSize, sizeof(Frame));
-    if (!lfru_data->privileged.frames)
+int text_trace_push(Text_Trace *trace, int pid, int page, uint32_t size)
+{
+    if (trace->num_refs == trace->capacity)
     {
-        // Handle allocation failure
-        fprintf(stderr, "Failed to allocate memory for privileged partition\n");
-        free(lfru_data);
-        return;
+        int capacity = trace->capacity > 0 ? trace->capacity * 2 : 4096;
+        int *pids = realloc(trace->pids, sizeof(int) * capacity);
+        if (pids)
+            trace->pids = pids;
+        int *pages = realloc(trace->pages, sizeof(int) * capacity);
+        if (pages)
+            trace->pages = pages;
+        uint32_t *sizes = realloc(trace->sizes, sizeof(uint32_t) * capacity);
+        if (sizes)
+            trace->sizes = sizes;
+        if (!pids || !pages || !sizes)
+            return -1;
+        trace->capacity = capacity;
     }
-    lfru_data->privileged.size = privilegedSize;
-    for (int i = 0; i < privilegedSize; ++i)
+    trace->pids[trace->num_refs] = pid;
+    trace->pages[trace->num_refs] = page;
+    trace->sizes[trace->num_refs++] = size;
+    return 0;
+}
+
+void text_trace_free(Text_Trace *trace)
+{
+    free(trace->pids);
+    free(trace->pages);
+    free(trace->sizes);
+    memset(trace, 0, sizeof(Text_Trace));
+    trace->first_sized = -1;
+}
+
+// Parse one slice of a mapped text trace
+static void *ingest_worker(void *arg)
+{
+    Ingest_Chunk *chunk = arg;
+    const char *cursor = chunk->begin;
+    int pid, page, sized;
+    uint32_t size;
+    while (cursor < chunk->end)
     {
-        lfru_data->privileged.frames[i].page = -1;
-        lfru_data->privileged.frames[i].frequency = 0;
-        lfru_data->privileged.frames[i].lastUsed = 0;
+        int parsed = parse_trace_text(&cursor, chunk->end, &pid, &page, &size, &sized);
+        if (parsed < 0)
+        {
+            chunk->stopped = 1;
+            break;
+        }
+        if (parsed == 0)
+            continue;
+        if (sized && chunk->refs.first_sized < 0)
+            chunk->refs.first_sized = chunk->refs.num_refs;
+        if (text_trace_push(&chunk->refs, pid, page, size) != 0)
+        {
+            chunk->failed = 1;
+            break;
+        }
     }
+    return NULL;
+}
 
-    // Allocate and initialize unprivileged partition
-    lfru_data->unprivileged.frames = calloc(unprivilegedSize, sizeof(Frame));
-    if (!lfru_data->unprivileged.frames)
+// Parse a whole text trace, on ingest_threads threads (by default one per core and MiB)
+int read_text_trace(const char *filename, Text_Trace *trace)
+{
+    memset(trace, 0, sizeof(Text_Trace));
+    trace->first_sized = -1;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
     {
-        // Handle allocation failure
-        fprintf(stderr, "Failed to allocate memory for unprivileged partition\n");
-        free(lfru_data->privileged.frames);
-        free(lfru_data);
-        return;
+        perror("Error opening file");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror("Error opening file");
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd);
+        return 0;
     }
-    lfru_data->unprivileged.size = unprivilegedSize;
-    for (int i = 0; i < unprivilegedSize; ++i)
+    const char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
     {
-        lfru_data->unprivileged.frames[i].page = -1;
-        lfru_data->unprivileged.frames[i].frequency = 0;
-        lfru_data->unprivileged.frames[i].lastUsed = 0;
+        perror("Error mapping file");
+        return -1;
     }
+    madvise((void *)base, st.st_size, MADV_WILLNEED);
 
-    // Assign the initialized LFRU data to the extra field of Algorithm_Data
-    data->extra = lfru_data;
+    long threads = ingest_threads;
+    if (threads == 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (threads > st.st_size / INGEST_MIN_BYTES)
+            threads = st.st_size / INGEST_MIN_BYTES;
+    }
+    if (threads < 1)
+        threads = 1;
+    if (threads > INGEST_MAX_THREADS)
+        threads = INGEST_MAX_THREADS;
+    Ingest_Chunk *chunks = calloc(threads, sizeof(Ingest_Chunk));
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    int *started = calloc(threads, sizeof(int));
+    if (!chunks || !workers || !started)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(chunks);
+        free(workers);
+        free(started);
+        munmap((void *)base, st.st_size);
+        return -1;
+    }
+    // Each slice ends just past a newline, so no line is split between two threads
+    const char *end = base + st.st_size, *begin = base;
+    for (long t = 0; t < threads; t++)
+    {
+        const char *cut = t == threads - 1 ? end : base + st.st_size / threads * (t + 1);
+        if (cut < begin)
+            cut = begin;
+        if (cut < end && t < threads - 1)
+        {
+            const char *newline = memchr(cut, '\n', end - cut);
+            cut = newline != NULL ? newline + 1 : end;
+        }
+        chunks[t].begin = begin;
+        chunks[t].end = cut;
+        chunks[t].refs.first_sized = -1;
+        begin = cut;
+    }
+    for (long t = 1; t < threads; t++)
+        started[t] = pthread_create(&workers[t], NULL, ingest_worker, &chunks[t]) == 0;
+    ingest_worker(&chunks[0]);
+    for (long t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(workers[t], NULL);
+        else
+            ingest_worker(&chunks[t]);
+    }
+
+    // Join the slices in file order, up to the line that ended the trace
+    int result = 0;
+    long used = 0;
+    int64_t total = 0;
+    while (used < threads)
+    {
+        if (chunks[used].failed)
+            result = -1;
+        total += chunks[used].refs.num_refs;
+        if (chunks[used++].stopped)
+            break;
+    }
+    if (result == 0 && total > INT_MAX)
+    {
+        fprintf(stderr, "Text trace has more than %d refs\n", INT_MAX);
+        result = -2;
+    }
+    if (result == 0 && total > 0)
+    {
+        trace->capacity = (int)total;
+        trace->pids = malloc(sizeof(int) * total);
+        trace->pages = malloc(sizeof(int) * total);
+        trace->sizes = malloc(sizeof(uint32_t) * total);
+        if (!trace->pids || !trace->pages || !trace->sizes)
+            result = -1;
+        for (long t = 0; t < used && result == 0; t++)
+        {
+            Text_Trace *refs = &chunks[t].refs;
+            if (refs->num_refs == 0)
+                continue;
+            if (refs->first_sized >= 0 && trace->first_sized < 0)
+                trace->first_sized = trace->num_refs + refs->first_sized;
+            memcpy(trace->pids + trace->num_refs, refs->pids, sizeof(int) * refs->num_refs);
+            memcpy(trace->pages + trace->num_refs, refs->pages, sizeof(int) * refs->num_refs);
+            memcpy(trace->sizes + trace->num_refs, refs->sizes, sizeof(uint32_t) * refs->num_refs);
+            trace->num_refs += refs->num_refs;
+        }
+    }
+    if (result == -1)
+        fprintf(stderr, "Memory allocation failed for text trace\n");
+    if (result != 0)
+        text_trace_free(trace);
+    for (long t = 0; t < threads; t++)
+        text_trace_free(&chunks[t].refs);
+    free(chunks);
+    free(workers);
+    free(started);
+    munmap((void *)base, st.st_size);
+    return result != 0 ? -1 : 0;
 }
 
-// Creates an empty Algorithm_Data to init an Algorithm
-Algorithm_Data *create_algo_data_store()
+// Reader thread of a streamed text trace, fills free batches until the trace ends
+static void *ingest_reader(void *arg)
 {
-    Algorithm_Data *data = malloc(sizeof(Algorithm_Data));
-    data->hits = 0;
-    data->misses = 0;
-    data->last_victim = NULL;
-    /* Initialize Lists */
-    LIST_INIT(&(data->page_table));
-    LIST_INIT(&(data->victim_list));
-    /* Insert at the page_table. */
-    Frame *framep = create_empty_frame(0);
-    LIST_INSERT_HEAD(&(data->page_table), framep, frames);
-    /* Build the rest of the list. */
-    size_t i = 0;
-    for (i = 1; i < num_frames; ++i)
+    Ingest_Pipe *pipe = arg;
+    char *buffer = malloc(STREAM_FILE_BUFFER);
+    size_t start = 0, held = 0;
+    int eof = 0, ended = buffer == NULL;
+    if (buffer == NULL)
+        fprintf(stderr, "Memory allocation failed for trace reader\n");
+    while (1)
     {
-        LIST_INSERT_AFTER(framep, create_empty_frame(i), frames);
-        framep = framep->frames.le_next;
+        pthread_mutex_lock(&pipe->lock);
+        while (pipe->produced - pipe->consumed == INGEST_BATCHES && !pipe->stop)
+            pthread_cond_wait(&pipe->drained, &pipe->lock);
+        int stop = pipe->stop;
+        pthread_mutex_unlock(&pipe->lock);
+        if (stop)
+            break;
+
+        Text_Trace *batch = &pipe->batches[pipe->produced % INGEST_BATCHES];
+        batch->num_refs = 0;
+        batch->first_sized = -1;
+        while (!ended && batch->num_refs < batch->capacity)
+        {
+            // Parse only whole lines, topping the buffer up when the next one is cut off
+            if (!eof && memchr(buffer + start, '\n', held - start) == NULL && (start > 0 || held < STREAM_FILE_BUFFER))
+            {
+                memmove(buffer, buffer + start, held - start);
+                held -= start;
+                start = 0;
+                size_t n = fread(buffer + held, 1, STREAM_FILE_BUFFER - held, pipe->file);
+                held += n;
+                eof = n == 0;
+                continue;
+            }
+            if (start == held)
+            {
+                ended = 1;
+                break;
+            }
+            const char *cursor = buffer + start;
+            int pid, page, sized;
+            uint32_t size;
+            int parsed = parse_trace_text(&cursor, buffer + held, &pid, &page, &size, &sized);
+            start = cursor - buffer;
+            if (parsed < 0)
+                ended = 1;
+            else if (parsed > 0)
+            {
+                if (sized && batch->first_sized < 0)
+                    batch->first_sized = batch->num_refs;
+                batch->pids[batch->num_refs] = pid;
+                batch->pages[batch->num_refs] = page;
+                batch->sizes[batch->num_refs++] = size;
+            }
+        }
+
+        pthread_mutex_lock(&pipe->lock);
+        if (batch->num_refs > 0)
+            pipe->produced++;
+        pipe->done = ended;
+        pthread_cond_signal(&pipe->filled);
+        pthread_mutex_unlock(&pipe->lock);
+        if (ended)
+            break;
     }
+    free(buffer);
+    return NULL;
+}
 
-    // Specific initialization for LFRU
-    if (algos[10].selected == 1)
+Ingest_Pipe *ingest_pipe_open(const char *filename)
+{
+    Ingest_Pipe *pipe = calloc(1, sizeof(Ingest_Pipe));
+    if (!pipe)
     {
-        initializeLFRUPartitions(data, PRIVILEGED_PARTITION_SIZE, UNPRIVILEGED_PARTITION_SIZE);
+        fprintf(stderr, "Memory allocation failed for trace reader\n");
+        return NULL;
     }
-    data->exec_time = 0; // Initialize execution time
-    return data;
+    pthread_mutex_init(&pipe->lock, NULL);
+    pthread_cond_init(&pipe->filled, NULL);
+    pthread_cond_init(&pipe->drained, NULL);
+    pipe->file = fopen(filename, "r");
+    if (!pipe->file)
+    {
+        perror("Error opening file");
+        ingest_pipe_close(pipe);
+        return NULL;
+    }
+    setvbuf(pipe->file, NULL, _IONBF, 0); // the reader has its own STREAM_FILE_BUFFER
+    for (int b = 0; b < INGEST_BATCHES; b++)
+    {
+        Text_Trace *batch = &pipe->batches[b];
+        batch->capacity = STREAM_CHUNK;
+        batch->pids = malloc(sizeof(int) * STREAM_CHUNK);
+        batch->pages = malloc(sizeof(int) * STREAM_CHUNK);
+        batch->sizes = malloc(sizeof(uint32_t) * STREAM_CHUNK);
+        if (!batch->pids || !batch->pages || !batch->sizes)
+        {
+            fprintf(stderr, "Memory allocation failed for trace reader\n");
+            ingest_pipe_close(pipe);
+            return NULL;
+        }
+    }
+    if (pthread_create(&pipe->thread, NULL, ingest_reader, pipe) != 0)
+    {
+        fprintf(stderr, "Failed to start the trace reader thread\n");
+        ingest_pipe_close(pipe);
+        return NULL;
+    }
+    pipe->running = 1;
+    return pipe;
 }
 
-// Creates an empty Frame for page table list
-Frame *create_empty_frame(int index)
+// Hand out the next parsed ref, giving a batch back to the reader once it is used up
+int ingest_pipe_next(Ingest_Pipe *pipe, int *pid, int *page, uint32_t *size)
 {
-    Frame *framep = malloc(sizeof(Frame));
-    framep->index = index;
-    framep->page = -1;
-    time(&framep->time);
-    framep->extra = 0;
-    return framep;
+    Text_Trace *batch = &pipe->batches[pipe->consumed % INGEST_BATCHES];
+    if (!pipe->holding || pipe->next == batch->num_refs)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        if (pipe->holding)
+        {
+            pipe->consumed++;
+            pipe->holding = 0;
+            pthread_cond_signal(&pipe->drained);
+        }
+        while (pipe->produced == pipe->consumed && !pipe->done)
+            pthread_cond_wait(&pipe->filled, &pipe->lock);
+        int empty = pipe->produced == pipe->consumed;
+        pthread_mutex_unlock(&pipe->lock);
+        if (empty)
+            return 0;
+        batch = &pipe->batches[pipe->consumed % INGEST_BATCHES];
+        pipe->holding = 1;
+        pipe->next = 0;
+    }
+    int i = pipe->next++;
+    if (i == batch->first_sized)
+        trace_has_sizes = 1;
+    *pid = batch->pids[i];
+    *page = batch->pages[i];
+    *size = batch->sizes[i];
+    return 1;
 }
 
-// Comparator function for sorting algorithms by hit ratio
-int compare_hit_ratio(const void *a, const void *b)
+void ingest_pipe_close(Ingest_Pipe *pipe)
 {
-    const Algorithm *algoA = (const Algorithm *)a;
-    const Algorithm *algoB = (const Algorithm *)b;
-    double hitRatioA = (double)algoA->data->hits / (double)(algoA->data->hits + algoA->data->misses);
-    double hitRatioB = (double)algoB->data->hits / (double)(algoB->data->hits + algoB->data->misses);
-
-    // For descending order
-    return (hitRatioB > hitRatioA) - (hitRatioB < hitRatioA);
+    if (pipe == NULL)
+        return;
+    if (pipe->running)
+    {
+        pthread_mutex_lock(&pipe->lock);
+        pipe->stop = 1;
+        pthread_cond_signal(&pipe->drained);
+        pthread_mutex_unlock(&pipe->lock);
+        pthread_join(pipe->thread, NULL);
+    }
+    pthread_mutex_destroy(&pipe->lock);
+    pthread_cond_destroy(&pipe->filled);
+    pthread_cond_destroy(&pipe->drained);
+    for (int b = 0; b < INGEST_BATCHES; b++)
+        text_trace_free(&pipe->batches[b]);
+    if (pipe->file)
+        fclose(pipe->file);
+    free(pipe);
 }
 
-// page all selected algorithms with input ref
-int event_loop()
+// Streaming section
+// Refs are parsed a chunk at a time into a ring indexed by absolute position. The ring keeps
+// at least lookahead_window refs past the one being paged, and links each ref to the next
+// ref to the same page while it is still in the ring.
+
+// Open filename for streaming with room for window refs of lookahead
+// The last retain refs handed out stay readable in the ring until more are handed out
+int open_trace_stream(Trace_Stream *stream, const char *filename, int window, int retain)
 {
-    counter = 0;
-    while (counter < max_page_calls)
+    printf("Streaming file: %s\n", filename);
+    memset(stream, 0, sizeof(Trace_Stream));
+    int mapped = map_trace(&stream->map, filename);
+    if (mapped < 0)
+        return -1;
+    if (mapped == 0)
     {
-        page(get_ref());
-        ++counter;
+        stream->page_cursor = stream->map.page_data;
+        stream->pid_cursor = stream->map.pid_data;
+        stream->size_cursor = stream->map.size_data;
+        trace_has_sizes = stream->map.size_data != NULL;
+    }
+    else
+    {
+        // Text is parsed on a reader thread, so paging starts with the first batch
+        stream->pipe = ingest_pipe_open(filename);
+        if (!stream->pipe)
+            return -1;
     }
 
-    // Sort algorithms by hit ratio in descending order
-    qsort(algos, num_algos, sizeof(Algorithm), compare_hit_ratio);
-
-    // Print the sorted results
-    for (size_t i = 0; i < num_algos; i++)
+    stream->window = window;
+    stream->retain = retain;
+    stream->capacity = 1;
+    while (stream->capacity < window + retain + STREAM_CHUNK)
+        stream->capacity <<= 1;
+    stream->ring = malloc(sizeof(Trace_Ref) * stream->capacity);
+    if (!stream->ring || ((window > 0 || shadow_window > 0) && page_values_init(&stream->last_seen, -1) != 0))
     {
-        if (algos[i].selected == 1)
-        {
-            print_summary(algos[i]);
-        }
+        fprintf(stderr, "Failed to allocate memory for trace stream\n");
+        close_trace_stream(stream);
+        return -1;
     }
     return 0;
 }
 
-// get a random ref
-int get_ref()
+// Read the next (pid, page, size) from the text file or the mapped binary trace, 1 on success
+int read_trace_stream(Trace_Stream *stream, int *pid, int *page, uint32_t *size)
 {
-    if (page_refs.lh_first != NULL)
-    { // pop Page_Ref off page_refs
-        int page_num = page_refs.lh_first->page_num;
-        LIST_REMOVE(page_refs.lh_first, pages);
-        return page_num;
+    if (stream->pipe)
+        return ingest_pipe_next(stream->pipe, pid, page, size);
+    Trace_Map *map = &stream->map;
+    if ((uint64_t)stream->read >= map->header->num_refs)
+        return 0;
+    *size = 1;
+    if (map->header->flags & TRACE_FLAG_VARINT)
+    {
+        stream->prev_page += decode_zigzag(&stream->page_cursor);
+        stream->prev_pid += decode_zigzag(&stream->pid_cursor);
+        *page = check_page(stream->prev_page);
+        *pid = (int)stream->prev_pid;
+        if (map->size_data)
+        {
+            stream->prev_size += decode_zigzag(&stream->size_cursor);
+            *size = (uint32_t)stream->prev_size;
+        }
     }
     else
-    { // just in case
-        return rand() % page_ref_upper_bound;
+    {
+        *page = check_page(((const uint32_t *)map->page_data)[stream->read]);
+        *pid = (int)((const uint32_t *)map->pid_data)[stream->read];
+        if (map->size_data)
+            *size = ((const uint32_t *)map->size_data)[stream->read];
     }
+    stream->read++;
+    return 1;
 }
 
-// page all selected algorithms with input ref
-// int page(int page_ref)
-// {
-//     last_page_ref = page_ref;
-//     size_t i = 0;
-//     for (i = 0; i < num_algos; i++)
-//     {
-//         if (algos[i].selected == 1)
-//         {
-//             algos[i].algo(algos[i].data);
-//             if (printrefs == 1)
-//             {
-//                 print_stats(algos[i]);
-//             }
-//         }
-//     }
+// Parse up to one chunk of refs into the ring
+void fill_trace_stream(Trace_Stream *stream)
+{
+    int room = stream->capacity - (int)(stream->tail - (stream->head - stream->retain));
+    int parsed = 0;
+    int pid, page;
+    uint32_t size;
+    while (parsed < room && parsed < STREAM_CHUNK && !stream->eof)
+    {
+        if (read_trace_stream(stream, &pid, &page, &size) != 1)
+        {
+            stream->eof = 1;
+            break;
+        }
+        page = ref_key(pid, page);
+        if (stream->sample_threshold != 0 && shards_hash(page) >= stream->sample_threshold)
+            continue;
+        int64_t position = stream->tail++;
+        Trace_Ref *ref = &stream->ring[position & (stream->capacity - 1)];
+        ref->page_num = page;
+        ref->pid = pid;
+        ref->next_use = INT64_MAX;
+        ref->prev_use = -1;
+        ref->tenant = tenant_mode != TENANT_OFF ? tenant_of(pid) : 0;
+        ref->size = size;
+        int64_t *last = stream->last_seen.near ? page_values_at(&stream->last_seen, page) : NULL;
+        if (last != NULL)
+        {
+            // Link the previous ref to this page while it is still in the ring
+            int64_t prev = *last;
+            ref->prev_use = prev;
+            if (prev >= stream->head - stream->retain)
+                stream->ring[prev & (stream->capacity - 1)].next_use = position;
+            *last = position;
+        }
+        parsed++;
+    }
+}
 
-//     return 0;
-// }
+// 1 if there is another ref to page
+int trace_stream_has_ref(Trace_Stream *stream)
+{
+    if (stream->tail - stream->head <= stream->window)
+        fill_trace_stream(stream);
+    return stream->head < stream->tail;
+}
 
-int page(int page_ref) {
-    last_page_ref = page_ref;
-    size_t i = 0;
-    clock_t start_time, end_time;
-    
-    for (i = 0; i < num_algos; i++) {
-        if (algos[i].selected == 1) {
-            start_time = clock(); // Start time
-            algos[i].algo(algos[i].data);
-            end_time = clock(); // End time
-            
+// Pop the next ref, topping the ring up so window refs of lookahead stay parsed
+int trace_stream_get_ref(Trace_Stream *stream)
+{
+    while (stream->tail - stream->head <= stream->window && !stream->eof)
+        fill_trace_stream(stream);
+    return stream->ring[stream->head++ & (stream->capacity - 1)].page_num;
+}
+
+// Page at an absolute position if it is parsed and still in the ring, else -1
+int trace_stream_peek(Trace_Stream *stream, int64_t position)
+{
+    if (position < stream->head - stream->retain || position >= stream->tail)
+        return -1;
+    return stream->ring[position & (stream->capacity - 1)].page_num;
+}
+
+// Skip a freshly opened stream to position offset, where a resumed run continues
+// A plain binary trace jumps there. Varints, tenants and page links still need the skipped refs,
+// which are decoded without going through the ring. Text and sampled traces, whose positions
+// count only the kept refs, are read through ref by ref.
+int trace_stream_seek(Trace_Stream *stream, int64_t offset)
+{
+    if (stream->pipe != NULL || stream->sample_threshold != 0)
+    {
+        while (stream->head < offset && trace_stream_has_ref(stream))
+            trace_stream_get_ref(stream);
+        return stream->head == offset ? 0 : -1;
+    }
+    if ((uint64_t)offset > stream->map.header->num_refs)
+        return -1;
+    if (!(stream->map.header->flags & TRACE_FLAG_VARINT) && stream->last_seen.near == NULL && tenant_mode == TENANT_OFF)
+    {
+        stream->read = offset;
+    }
+    else
+    {
+        int pid, page;
+        uint32_t size;
+        for (int64_t position = 0; position < offset && read_trace_stream(stream, &pid, &page, &size) == 1; position++)
+        {
+            page = ref_key(pid, page);
+            if (tenant_mode != TENANT_OFF)
+                tenant_of(pid);
+            int64_t *last = stream->last_seen.near ? page_values_at(&stream->last_seen, page) : NULL;
+            if (last != NULL)
+                *last = position;
+        }
+    }
+    stream->head = stream->tail = offset;
+    return 0;
+}
+
+void close_trace_stream(Trace_Stream *stream)
+{
+    ingest_pipe_close(stream->pipe);
+    unmap_trace(&stream->map);
+    free(stream->ring);
+    page_values_free(&stream->last_seen);
+    memset(stream, 0, sizeof(Trace_Stream));
+}
+
+// Binary trace section
+// A binary trace is a Trace_Header followed by the page array then the pid array. The arrays
+// are uint32_t per ref, or zigzag delta varints when TRACE_FLAG_VARINT is set. Integers are
+// stored in host byte order.
+
+// Append v as a LEB128 varint, returns the number of bytes written
+static int put_varint(FILE *file, uint64_t v)
+{
+    int n = 0;
+    while (v >= 0x80)
+    {
+        fputc((int)(v & 0x7f) | 0x80, file);
+        v >>= 7;
+        n++;
+    }
+    fputc((int)v, file);
+    return n + 1;
+}
+
+// Write one value of an array, as a zigzag delta from prev when compressing
+static uint64_t put_trace_value(FILE *file, int compress, int64_t value, int64_t *prev)
+{
+    if (!compress)
+    {
+        uint32_t raw = (uint32_t)value;
+        fwrite(&raw, sizeof(raw), 1, file);
+        return sizeof(raw);
+    }
+    int64_t delta = value - *prev;
+    *prev = value;
+    return put_varint(file, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+}
+
+// Decode a zigzag varint delta and advance the cursor
+int64_t decode_zigzag(const unsigned char **cursor)
+{
+    uint64_t v = 0;
+    int shift = 0;
+    const unsigned char *p = *cursor;
+    do
+    {
+        v |= (uint64_t)(*p & 0x7f) << shift;
+        shift += 7;
+    } while (*p++ & 0x80);
+    *cursor = p;
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Convert a text trace of "pid page" lines to the binary format, with the pages numbered
+// 0, 1, 2... in first-seen order if dense is set
+int convert_trace(const char *text_file, const char *binary_file, int compress, int dense)
+{
+    Text_Trace text;
+    if (read_text_trace(text_file, &text) != 0)
+        return -1;
+    FILE *out = fopen(binary_file, "wb");
+    FILE *pids = tmpfile(); // The pid and size arrays follow the page array, so hold them aside
+    FILE *sizes = tmpfile();
+    if (!out || !pids || !sizes)
+    {
+        perror("Error creating binary trace");
+        text_trace_free(&text);
+        if (out)
+            fclose(out);
+        if (pids)
+            fclose(pids);
+        if (sizes)
+            fclose(sizes);
+        return -1;
+    }
+    Trace_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.flags = (compress ? TRACE_FLAG_VARINT : 0) | (dense ? TRACE_FLAG_DENSE : 0);
+    fwrite(&header, sizeof(header), 1, out);
+
+    Key_Map ids;
+    memset(&ids, 0, sizeof(ids));
+    if (dense && key_map_init(&ids, 1024) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed for dense pages\n");
+        dense = 0;
+        header.flags &= ~TRACE_FLAG_DENSE;
+    }
+    int64_t prev_page = 0, prev_pid = 0, prev_size = 0;
+    for (int i = 0; i < text.num_refs; i++)
+    {
+        int page = text.pages[i];
+        if (dense && (page = key_map_id(&ids, (uint32_t)page)) < 0)
+        {
+            fprintf(stderr, "Memory allocation failed for dense pages\n");
+            exit(1);
+        }
+        header.page_bytes += put_trace_value(out, compress, page, &prev_page);
+        header.pid_bytes += put_trace_value(pids, compress, text.pids[i], &prev_pid);
+        header.size_bytes += put_trace_value(sizes, compress, text.sizes[i], &prev_size);
+        header.num_refs++;
+    }
+    int has_sizes = text.first_sized >= 0, distinct = ids.size;
+    text_trace_free(&text);
+    key_map_free(&ids);
+
+    // Append the pid array (and the size array if the trace has sizes), then rewrite the
+    // header with the final sizes
+    char buf[1 << 16];
+    size_t n;
+    rewind(pids);
+    while ((n = fread(buf, 1, sizeof(buf), pids)) > 0)
+        fwrite(buf, 1, n, out);
+    fclose(pids);
+    header.page_offset = sizeof(header);
+    header.pid_offset = header.page_offset + header.page_bytes;
+    if (has_sizes)
+    {
+        rewind(sizes);
+        while ((n = fread(buf, 1, sizeof(buf), sizes)) > 0)
+            fwrite(buf, 1, n, out);
+        header.flags |= TRACE_FLAG_SIZES;
+        header.size_offset = header.pid_offset + header.pid_bytes;
+    }
+    else
+    {
+        header.size_bytes = 0;
+    }
+    fclose(sizes);
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    if (fclose(out) != 0)
+    {
+        perror("Error writing binary trace");
+        return -1;
+    }
+    printf("Wrote %llu refs to %s (%llu bytes of refs%s)\n", (unsigned long long)header.num_refs, binary_file,
+           (unsigned long long)(header.page_bytes + header.pid_bytes + header.size_bytes),
+           compress ? ", varint" : "");
+    if (dense)
+        printf("Dense pages: %d distinct\n", distinct);
+    return 0;
+}
+
+// mmap filename if it is a binary trace
+// Returns 0 if mapped, 1 if the file is not a binary trace (left for the text reader), -1 on error
+int map_trace(Trace_Map *map, const char *filename)
+{
+    memset(map, 0, sizeof(Trace_Map));
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("Error opening file");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Trace_Header))
+    {
+        close(fd);
+        return 1;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return 1;
+    Trace_Header *header = base;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        munmap(base, st.st_size);
+        return 1;
+    }
+    if (header->version != TRACE_VERSION || header->num_refs > INT_MAX ||
+        header->page_offset + header->page_bytes > (uint64_t)st.st_size ||
+        header->pid_offset + header->pid_bytes > (uint64_t)st.st_size ||
+        ((header->flags & TRACE_FLAG_SIZES) && header->size_offset + header->size_bytes > (uint64_t)st.st_size))
+    {
+        fprintf(stderr, "Unsupported or truncated binary trace: %s\n", filename);
+        munmap(base, st.st_size);
+        return -1;
+    }
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+    map->base = base;
+    map->length = st.st_size;
+    map->header = header;
+    map->page_data = (const unsigned char *)base + header->page_offset;
+    map->pid_data = (const unsigned char *)base + header->pid_offset;
+    if (header->flags & TRACE_FLAG_SIZES)
+        map->size_data = (const unsigned char *)base + header->size_offset;
+    printf("Mapped binary trace: %s (%llu refs)\n", filename, (unsigned long long)header->num_refs);
+    return 0;
+}
+
+// One past the largest page of a trace, at least 1
+static int trace_page_bound(const uint32_t *pages, int n)
+{
+    uint32_t largest = 0;
+    for (int i = 0; i < n; i++)
+        largest = pages[i] > largest ? pages[i] : largest;
+    return largest < INT_MAX ? (int)largest + 1 : INT_MAX;
+}
+
+// Check every page of an uncompressed array used in place, pages past INT_MAX have the top bit set
+static void check_trace_pages(const uint32_t *pages, int n)
+{
+    uint32_t bits = 0;
+    for (int i = 0; i < n; i++)
+        bits |= pages[i];
+    for (int i = 0; i < n && (bits >> 31); i++)
+        check_page(pages[i]);
+}
+
+// Use a mapped trace as the in-memory trace, every ref is paged in file order
+// Uncompressed page arrays are used in place, varint ones are decoded once
+void load_mapped_trace(Trace_Map *map)
+{
+    num_refs = (int)map->header->num_refs;
+    max_page_calls = num_refs;
+    int varint = map->header->flags & TRACE_FLAG_VARINT;
+    trace_has_sizes = map->size_data != NULL;
+    if (map->size_data && !varint)
+    {
+        trace_sizes = (const uint32_t *)map->size_data;
+    }
+    else if (map->size_data)
+    {
+        uint32_t *sizes = malloc(sizeof(uint32_t) * (num_refs > 0 ? num_refs : 1));
+        if (!sizes)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        const unsigned char *cursor = map->size_data;
+        int64_t size = 0;
+        for (int i = 0; i < num_refs; ++i)
+        {
+            size += decode_zigzag(&cursor);
+            sizes[i] = (uint32_t)size;
+        }
+        trace_sizes = map->decoded_sizes = sizes;
+    }
+    // Pages converted with --dense are ids below the distinct page count, so the arrays sized
+    // by page_ref_upper_bound only need that many entries
+    int dense = (map->header->flags & TRACE_FLAG_DENSE) && !pid_aware && line_shift == 0;
+    if (!varint && !pid_aware && tenant_mode == TENANT_OFF && line_shift == 0)
+    {
+        trace_pages = (const uint32_t *)map->page_data;
+        check_trace_pages(trace_pages, num_refs);
+        if (dense)
+            page_ref_upper_bound = trace_page_bound(trace_pages, num_refs);
+        return;
+    }
+    uint32_t *pages = malloc(sizeof(uint32_t) * (num_refs > 0 ? num_refs : 1));
+    if (!pages || (tenant_mode != TENANT_OFF && !(trace_tenants = malloc(sizeof(int) * (num_refs > 0 ? num_refs : 1)))))
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    const unsigned char *cursor = map->page_data, *pid_cursor = map->pid_data;
+    int64_t page = 0, pid = 0;
+    for (int i = 0; i < num_refs; ++i)
+    {
+        // Pids are only decoded when refs are keyed or counted by them
+        if (varint)
+            page += decode_zigzag(&cursor);
+        else
+            page = ((const uint32_t *)map->page_data)[i];
+        check_page(page);
+        if (pid_aware && varint)
+            pid += decode_zigzag(&pid_cursor);
+        else if (pid_aware)
+            pid = ((const uint32_t *)map->pid_data)[i];
+        if (trace_tenants)
+            trace_tenants[i] = tenant_of((int)pid);
+        pages[i] = (uint32_t)ref_key((int)pid, (int)page);
+    }
+    trace_map.decoded = pages;
+    trace_pages = pages;
+    if (dense)
+        page_ref_upper_bound = trace_page_bound(trace_pages, num_refs);
+}
+
+
+void unmap_trace(Trace_Map *map)
+{
+    if (map->base)
+        munmap(map->base, map->length);
+    free(map->decoded);
+    free(map->decoded_sizes);
+    memset(map, 0, sizeof(Trace_Map));
+}
+
+// Generate a random page ref within bounds
+Page_Ref *gen_ref()
+{
+    Page_Ref *page = malloc(sizeof(Page_Ref));
+    page->page_num = (int)rng_below(&gen_rng, (uint32_t)page_ref_upper_bound);
+    page->pid = 0;
+    page->size = 1;
+    return page;
+}
+
+// Function to initialize LFRU partitions over the page table
+// The first privilegedSize frames are the privileged (LRU) partition, the next
+// unprivilegedSize the unprivileged (LFU) one
+void initializeLFRUPartitions(Algorithm_Data *data, int privilegedSize, int unprivilegedSize)
+{
+    LFRU_Data *lfru_data = calloc(1, sizeof(LFRU_Data));
+    if (!lfru_data || page_map_init(&lfru_data->privileged.map, privilegedSize) != 0 ||
+        lfu_init(&lfru_data->unprivileged, data->frame_arena + privilegedSize, unprivilegedSize) != 0)
+    {
+        // Handle allocation failure
+        fprintf(stderr, "Failed to allocate memory for LFRU data\n");
+        freeLFRUPartitions(lfru_data);
+        exit(1);
+    }
+
+    // Privileged frames start free, in page table order
+    lfru_data->privileged.size = privilegedSize;
+    TAILQ_INIT(&lfru_data->privileged.order);
+    TAILQ_INIT(&lfru_data->privileged.free);
+    for (int i = 0; i < privilegedSize; ++i)
+        TAILQ_INSERT_TAIL(&lfru_data->privileged.free, &data->frame_arena[i], order);
+
+    // Assign the initialized LFRU data to the extra field of Algorithm_Data
+    data->extra = lfru_data;
+    data->free_extra = &freeLFRUPartitions;
+}
+
+// Frees LFRU partitions attached by initializeLFRUPartitions, the frames belong to the page table
+void freeLFRUPartitions(void *extra)
+{
+    LFRU_Data *lfru_data = extra;
+    if (!lfru_data)
+        return;
+    page_map_free(&lfru_data->privileged.map);
+    lfu_free(&lfru_data->unprivileged);
+    free(lfru_data);
+}
+
+// Setup hook for LFRU, splits num_frames by lfru_ratio
+// Each partition gets at least one frame, unless there is only one frame to give
+void initializeLFRU(Algorithm_Data *data)
+{
+    int privileged = (int)(data->num_frames * lfru_ratio + 0.5);
+    if (privileged > data->num_frames - 1)
+        privileged = data->num_frames - 1;
+    if (privileged < 1)
+        privileged = 1;
+    initializeLFRUPartitions(data, privileged, data->num_frames - privileged);
+}
+
+// Creates an empty Algorithm_Data of frames frames to init an Algorithm, their page_table is
+// only carved when page_table is 1, the rest keep their frames elsewhere or are never run
+Algorithm_Data *create_algo_data_store(int frames, int page_table)
+{
+    Algorithm_Data *data = malloc(sizeof(Algorithm_Data));
+    data->hits = 0;
+    data->misses = 0;
+    data->last_victim = NULL;
+    data->extra = NULL;
+    data->free_extra = NULL;
+    data->num_frames = frames;
+    data->page_ref = -1;
+    data->position = 0;
+    data->rand_state = 1;
+    /* Initialize Lists */
+    LIST_INIT(&(data->page_table));
+    LIST_INIT(&(data->victim_list));
+    TAILQ_INIT(&(data->order));
+    memset(&data->page_map, 0, sizeof(Page_Map));
+    memset(&data->victims, 0, sizeof(Victim_History));
+    data->victims.mode = victim_mode;
+    if (victim_mode == VICTIM_HISTORY_RING)
+    {
+        data->victims.ring = malloc(sizeof(Frame) * victim_capacity);
+        data->victims.capacity = victim_capacity;
+        if (!data->victims.ring)
+            fprintf(stderr, "Failed to allocate memory for victim ring, counting victims only\n");
+    }
+    memset(&data->arrays, 0, sizeof(Frame_Arrays));
+    memset(&data->lfu, 0, sizeof(Lfu));
+    data->tenant = 0;
+    data->tenants = NULL;
+    data->num_tenants = 0;
+    data->partitions = NULL;
+    data->num_partitions = 0;
+    data->size = 1;
+    data->byte_hits = 0;
+    data->byte_misses = 0;
+    data->evict_hook = NULL;
+    data->evict_arg = NULL;
+    data->prefetch = NULL;
+    data->shadow = NULL;
+    data->interval_hits = 0;
+    data->interval_misses = 0;
+    data->interval_evictions = 0;
+    data->interval_ticks = 0;
+    data->exec_ticks = 0; // Initialize execution time
+    data->latency = NULL;
+    data->frame_arena = NULL;
+    if (!page_table)
+        return data;
+    /* Carve the page_table frames from one arena, linked in index order. */
+    data->frame_arena = malloc(sizeof(Frame) * (frames > 0 ? frames : 1));
+    if (!data->frame_arena)
+    {
+        fprintf(stderr, "Failed to allocate memory for page table\n");
+        exit(1);
+    }
+    for (int i = frames - 1; i >= 0; --i)
+    {
+        Frame *framep = &data->frame_arena[i];
+        init_empty_frame(framep, i);
+        LIST_INSERT_HEAD(&(data->page_table), framep, frames);
+    }
+    return data;
+}
+
+// Give data count partitions of shares[i] frames (all of frames if shares is NULL), each set up for algo
+static void partition_algo_data(Algorithm_Data *data, const Algorithm *algo, int count, const int *shares, int frames)
+{
+    data->partitions = malloc(sizeof(Algorithm_Data *) * count);
+    if (!data->partitions)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        data->partitions[i] = create_algo_data_store(shares != NULL ? shares[i] : frames, !(algo->flags & ALGO_OWN_FRAMES));
+        if (algo->setup != NULL)
+            algo->setup(data->partitions[i]);
+        data->num_partitions++;
+    }
+}
+
+// Creates a data store for algo and runs its setup hook. With --tenants static it instead
+// gets one set-up partition per tenant, sized by tenant_frames(), and with --assoc one per
+// set unless algo models the sets itself
+Algorithm_Data *setup_algo_data(const Algorithm *algo, int frames)
+{
+    // A partitioned cache pages through its partitions' tables, never its own
+    int partitioned = assoc_ways > 0 ? !(algo->flags & ALGO_SET_LOCAL) : tenant_mode == TENANT_STATIC && num_tenants > 0;
+    Algorithm_Data *data = create_algo_data_store(frames, !partitioned && !(algo->flags & ALGO_OWN_FRAMES));
+    if (assoc_ways > 0)
+    {
+        int sets = frames / assoc_ways;
+        if (sets * assoc_ways != frames || (set_index_mode == SET_INDEX_BITS && (sets & (sets - 1)) != 0))
+        {
+            printf("%d frames do not make %s sets of %d ways\n", frames,
+                   set_index_mode == SET_INDEX_BITS ? "a power of two of" : "whole", assoc_ways);
+            exit(1);
+        }
+        if (algo->flags & ALGO_SET_LOCAL)
+            algo->setup(data);
+        else
+            partition_algo_data(data, algo, sets, NULL, assoc_ways);
+    }
+    else if (tenant_mode == TENANT_STATIC && num_tenants > 0)
+    {
+        int *shares = malloc(sizeof(int) * num_tenants);
+        data->tenants = calloc(num_tenants, sizeof(Tenant_Stats));
+        if (!shares || !data->tenants)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        if (tenant_frames(frames, shares) != 0)
+        {
+            printf("%d frames cannot be split over %d tenants\n", frames, num_tenants);
+            exit(1);
+        }
+        data->num_tenants = num_tenants;
+        for (int t = 0; t < num_tenants; t++)
+            data->tenants[t].frames = shares[t];
+        partition_algo_data(data, algo, num_tenants, shares, 0);
+        free(shares);
+    }
+    else if (algo->setup != NULL)
+    {
+        algo->setup(data);
+    }
+    // The offline policies are the bounds prefetching is measured against, they run without one
+    if (prefetch_kind != PREFETCH_OFF && data->num_partitions == 0 && !(algo->flags & ALGO_OFFLINE))
+    {
+        data->prefetch = prefetcher_create(frames);
+        data->evict_hook = &prefetch_evicted;
+        data->evict_arg = data->prefetch;
+    }
+    // One shadow for the whole cache, evictions in its partitions reach it through their hook
+    if (shadow_window > 0)
+    {
+        data->shadow = miss_shadow_create(shadow_window);
+        for (int i = 0; i < data->num_partitions; i++)
+        {
+            data->partitions[i]->evict_hook = &shadow_evicted;
+            data->partitions[i]->evict_arg = data->shadow;
+        }
+    }
+    return data;
+}
+
+// Frees an Algorithm_Data and everything its algorithm attached to it
+void destroy_algo_data_store(Algorithm_Data *data)
+{
+    free(data->frame_arena); // every page_table frame at once
+    frame_arrays_free(&data->arrays);
+    lfu_free(&data->lfu);
+    // Victims live in the ring or in pool blocks, not in their own allocations
+    while (data->victims.blocks != NULL)
+    {
+        Frame_Block *block = data->victims.blocks;
+        data->victims.blocks = block->next;
+        free(block);
+    }
+    free(data->victims.ring);
+    page_map_free(&data->page_map);
+    for (int i = 0; i < data->num_partitions; ++i)
+        destroy_algo_data_store(data->partitions[i]);
+    free(data->partitions);
+    free(data->tenants);
+    free(data->latency);
+    prefetcher_free(data->prefetch);
+    miss_shadow_free(data->shadow);
+    if (data->free_extra != NULL)
+        data->free_extra(data->extra);
+    else
+        free(data->extra);
+    free(data);
+}
+
+// Creates an empty Frame for page table list
+Frame *create_empty_frame(int index)
+{
+    Frame *framep = malloc(sizeof(Frame));
+    if (framep)
+        init_empty_frame(framep, index);
+    return framep;
+}
+
+// Resets a Frame to empty
+void init_empty_frame(Frame *framep, int index)
+{
+    framep->index = index;
+    framep->page = -1;
+    framep->time = 0; // Never used
+    framep->extra = 0;
+    framep->lastUsed = 0;
+    framep->frequency = 0;
+    framep->bucket = NULL;
+    framep->size = 0;
+}
+
+// Struct-of-arrays section
+// Policies that scan every frame keep page[] and their metadata in two dense arrays, so a
+// hit scan or a victim search walks contiguous memory instead of chasing list nodes.
+
+// Allocate page[] and meta[] for size frames from one arena
+int frame_arrays_init(Frame_Arrays *arrays, int size)
+{
+    memset(arrays, 0, sizeof(Frame_Arrays));
+    arrays->arena = calloc(size > 0 ? size : 1, sizeof(int) + sizeof(uint32_t));
+    if (!arrays->arena)
+    {
+        fprintf(stderr, "Failed to allocate memory for frame arrays\n");
+        return -1;
+    }
+    arrays->page = arrays->arena;
+    arrays->meta = (uint32_t *)(arrays->page + size);
+    arrays->size = size;
+    for (int i = 0; i < size; ++i)
+        arrays->page[i] = -1;
+    return 0;
+}
+
+// Frame holding page, -1 if page is not resident
+int frame_arrays_find(const Frame_Arrays *arrays, int page)
+{
+    return find_page_kernel(arrays->page, arrays->used, page);
+}
+
+// Frame with the smallest meta, the first one on ties
+int frame_arrays_argmin(const Frame_Arrays *arrays)
+{
+    return argmin_kernel(arrays->meta, arrays->size);
+}
+
+// Frame with the largest meta, the first one on ties
+int frame_arrays_argmax(const Frame_Arrays *arrays)
+{
+    return argmax_kernel(arrays->meta, arrays->size);
+}
+
+void frame_arrays_free(Frame_Arrays *arrays)
+{
+    free(arrays->arena);
+    memset(arrays, 0, sizeof(Frame_Arrays));
+}
+
+// Scans for the policy steps below, which take the frame count as size. The specialized replay
+// loops pass a literal size, so these become fixed-trip loops the compiler unrolls; any other
+// size goes to the --simd kernels.
+static inline int frameFind(const Frame_Arrays *arrays, int size, int page)
+{
+    if (!__builtin_constant_p(size) || size > FRAME_UNROLL_MAX)
+        return find_page_kernel(arrays->page, arrays->used, page);
+    int found = -1;
+    for (int i = size - 1; i >= 0; i--) // Frames past used hold no page, whatever is in them
+        found = i < arrays->used && arrays->page[i] == page ? i : found;
+    return found;
+}
+
+static inline int frameArgmin(const Frame_Arrays *arrays, int size)
+{
+    if (!__builtin_constant_p(size) || size > FRAME_UNROLL_MAX)
+        return argmin_kernel(arrays->meta, arrays->size);
+    int best = 0;
+    for (int i = 1; i < size; i++)
+        best = arrays->meta[i] < arrays->meta[best] ? i : best;
+    return best;
+}
+
+static inline void frameHalve(Frame_Arrays *arrays, int size)
+{
+    if (!__builtin_constant_p(size) || size > FRAME_UNROLL_MAX)
+    {
+        halve_kernel(arrays->meta, arrays->used);
+        return;
+    }
+    for (int i = 0; i < size; i++) // Unused frames hold 0
+        arrays->meta[i] >>= 1;
+}
+
+// Setup hook for RANDOM, CLOCK, GCLOCK, NFU, AGING and NRU
+void initializeFrameArrays(Algorithm_Data *data)
+{
+    if (frame_arrays_init(&data->arrays, data->num_frames) != 0)
+        exit(1);
+}
+
+// SIMD section
+// Kernels behind frame_arrays_find(), frame_arrays_argmin(), frame_arrays_argmax() and AGING's
+// counter decay. The widest set the CPU supports is picked once by simd_init(), before any
+// worker thread starts. Each kernel returns the same frame as the scalar one, the first on ties.
+
+int find_page_scalar(const int *pages, int n, int page)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (pages[i] == page)
+            return i;
+    }
+    return -1;
+}
+
+int argmin_scalar(const uint32_t *values, int n)
+{
+    int best = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        if (values[i] < values[best])
+            best = i;
+    }
+    return best;
+}
+
+void halve_scalar(uint32_t *values, int n)
+{
+    for (int i = 0; i < n; ++i)
+        values[i] >>= 1;
+}
+
+int argmax_scalar(const uint32_t *values, int n)
+{
+    int best = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        if (values[i] > values[best])
+            best = i;
+    }
+    return best;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) int find_page_avx2(const int *pages, int n, int page)
+{
+    __m256i key = _mm256_set1_epi32(page);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(pages + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    int tail = find_page_scalar(pages + i, n - i, page);
+    return tail < 0 ? -1 : i + tail;
+}
+
+// Smallest (or largest) value in 8-lane passes, then the first frame holding it
+__attribute__((target("avx2"))) static int arg_extreme_avx2(const uint32_t *values, int n, int largest)
+{
+    if (n < 16)
+        return largest ? argmax_scalar(values, n) : argmin_scalar(values, n);
+    __m256i acc = _mm256_loadu_si256((const __m256i *)values);
+    int i = 8;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        acc = largest ? _mm256_max_epu32(acc, v) : _mm256_min_epu32(acc, v);
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    uint32_t best = lanes[0];
+    for (int l = 1; l < 8; ++l)
+        best = largest ? (lanes[l] > best ? lanes[l] : best) : (lanes[l] < best ? lanes[l] : best);
+    for (; i < n; ++i)
+        best = largest ? (values[i] > best ? values[i] : best) : (values[i] < best ? values[i] : best);
+    return find_page_avx2((const int *)values, n, (int)best);
+}
+
+__attribute__((target("avx2"))) int argmin_avx2(const uint32_t *values, int n)
+{
+    return arg_extreme_avx2(values, n, 0);
+}
+
+__attribute__((target("avx2"))) int argmax_avx2(const uint32_t *values, int n)
+{
+    return arg_extreme_avx2(values, n, 1);
+}
+
+__attribute__((target("avx2"))) void halve_avx2(uint32_t *values, int n)
+{
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        _mm256_storeu_si256((__m256i *)(values + i), _mm256_srli_epi32(v, 1));
+    }
+    halve_scalar(values + i, n - i);
+}
+
+__attribute__((target("avx512f"))) int find_page_avx512(const int *pages, int n, int page)
+{
+    __m512i key = _mm512_set1_epi32(page);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(pages + i), key);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    if (i < n)
+    {
+        // The tail is one masked load, lanes past n read as never equal
+        __mmask16 live = (__mmask16)((1u << (n - i)) - 1);
+        __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(live, _mm512_maskz_loadu_epi32(live, pages + i), key);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return -1;
+}
+
+__attribute__((target("avx512f"))) static int arg_extreme_avx512(const uint32_t *values, int n, int largest)
+{
+    if (n < 32)
+        return largest ? argmax_scalar(values, n) : argmin_scalar(values, n);
+    __m512i acc = _mm512_loadu_si512(values);
+    int i = 16;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i v = _mm512_loadu_si512(values + i);
+        acc = largest ? _mm512_max_epu32(acc, v) : _mm512_min_epu32(acc, v);
+    }
+    uint32_t best = largest ? _mm512_reduce_max_epu32(acc) : _mm512_reduce_min_epu32(acc);
+    for (; i < n; ++i)
+        best = largest ? (values[i] > best ? values[i] : best) : (values[i] < best ? values[i] : best);
+    return find_page_avx512((const int *)values, n, (int)best);
+}
+
+__attribute__((target("avx512f"))) int argmin_avx512(const uint32_t *values, int n)
+{
+    return arg_extreme_avx512(values, n, 0);
+}
+
+__attribute__((target("avx512f"))) int argmax_avx512(const uint32_t *values, int n)
+{
+    return arg_extreme_avx512(values, n, 1);
+}
+
+__attribute__((target("avx512f"))) void halve_avx512(uint32_t *values, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_si512(values + i, _mm512_srli_epi32(_mm512_loadu_si512(values + i), 1));
+    halve_scalar(values + i, n - i);
+}
+#endif
+
+#if defined(__aarch64__)
+int find_page_neon(const int *pages, int n, int page)
+{
+    int32x4_t key = vdupq_n_s32(page);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        if (vmaxvq_u32(vceqq_s32(vld1q_s32(pages + i), key)) != 0)
+            return i + find_page_scalar(pages + i, 4, page);
+    }
+    int tail = find_page_scalar(pages + i, n - i, page);
+    return tail < 0 ? -1 : i + tail;
+}
+
+static int arg_extreme_neon(const uint32_t *values, int n, int largest)
+{
+    if (n < 8)
+        return largest ? argmax_scalar(values, n) : argmin_scalar(values, n);
+    uint32x4_t acc = vld1q_u32(values);
+    int i = 4;
+    for (; i + 4 <= n; i += 4)
+        acc = largest ? vmaxq_u32(acc, vld1q_u32(values + i)) : vminq_u32(acc, vld1q_u32(values + i));
+    uint32_t best = largest ? vmaxvq_u32(acc) : vminvq_u32(acc);
+    for (; i < n; ++i)
+        best = largest ? (values[i] > best ? values[i] : best) : (values[i] < best ? values[i] : best);
+    return find_page_neon((const int *)values, n, (int)best);
+}
+
+int argmin_neon(const uint32_t *values, int n)
+{
+    return arg_extreme_neon(values, n, 0);
+}
+
+int argmax_neon(const uint32_t *values, int n)
+{
+    return arg_extreme_neon(values, n, 1);
+}
+
+void halve_neon(uint32_t *values, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_u32(values + i, vshrq_n_u32(vld1q_u32(values + i), 1));
+    halve_scalar(values + i, n - i);
+}
+#endif
+
+// Pick the kernels for name ("auto" takes the widest the CPU supports), 0 if available
+int simd_init(const char *name)
+{
+    int automatic = strcmp(name, "auto") == 0;
+    find_page_kernel = &find_page_scalar;
+    argmin_kernel = &argmin_scalar;
+    argmax_kernel = &argmax_scalar;
+    halve_kernel = &halve_scalar;
+    simd_kernel = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if ((automatic || strcmp(name, "avx512") == 0) && __builtin_cpu_supports("avx512f"))
+    {
+        find_page_kernel = &find_page_avx512;
+        argmin_kernel = &argmin_avx512;
+        argmax_kernel = &argmax_avx512;
+        halve_kernel = &halve_avx512;
+        simd_kernel = "avx512";
+    }
+    else if ((automatic || strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2"))
+    {
+        find_page_kernel = &find_page_avx2;
+        argmin_kernel = &argmin_avx2;
+        argmax_kernel = &argmax_avx2;
+        halve_kernel = &halve_avx2;
+        simd_kernel = "avx2";
+    }
+#elif defined(__aarch64__)
+    if (automatic || strcmp(name, "neon") == 0)
+    {
+        find_page_kernel = &find_page_neon;
+        argmin_kernel = &argmin_neon;
+        argmax_kernel = &argmax_neon;
+        halve_kernel = &halve_neon;
+        simd_kernel = "neon";
+    }
+#endif
+    return automatic || strcmp(name, simd_kernel) == 0 ? 0 : -1;
+}
+
+// O(1) LFU section
+// Buckets of equal use count are kept in ascending order and each keeps its frames in the order
+// they reached that count. A use moves a frame to the next bucket, so every operation is O(1),
+// and ties always go to the frame that has held its count longest.
+
+// Set up an LFU over frames[0...capacity-1], all free
+int lfu_init(Lfu *lfu, Frame *frames, int capacity)
+{
+    memset(lfu, 0, sizeof(Lfu));
+    TAILQ_INIT(&lfu->buckets);
+    TAILQ_INIT(&lfu->spare);
+    TAILQ_INIT(&lfu->free);
+    lfu->capacity = capacity;
+    lfu->pool = malloc(sizeof(Freq_Bucket) * (capacity + 1));
+    if (!lfu->pool || page_map_init(&lfu->map, capacity) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for LFU buckets\n");
+        lfu_free(lfu);
+        return -1;
+    }
+    for (int i = 0; i <= capacity; ++i)
+        TAILQ_INSERT_TAIL(&lfu->spare, &lfu->pool[i], buckets);
+    for (int i = 0; i < capacity; ++i)
+    {
+        frames[i].bucket = NULL;
+        TAILQ_INSERT_TAIL(&lfu->free, &frames[i], order);
+    }
+    return 0;
+}
+
+Frame *lfu_get(Lfu *lfu, int page)
+{
+    return page_map_get(&lfu->map, page);
+}
+
+// Bucket for frequency right after prev (NULL for the head), taken from the spare list if new
+static Freq_Bucket *lfu_bucket_after(Lfu *lfu, Freq_Bucket *prev, int frequency)
+{
+    Freq_Bucket *next = prev ? TAILQ_NEXT(prev, buckets) : TAILQ_FIRST(&lfu->buckets);
+    if (next != NULL && next->frequency == frequency)
+        return next;
+    Freq_Bucket *bucket = TAILQ_FIRST(&lfu->spare);
+    TAILQ_REMOVE(&lfu->spare, bucket, buckets);
+    bucket->frequency = frequency;
+    TAILQ_INIT(&bucket->frames);
+    if (prev)
+        TAILQ_INSERT_AFTER(&lfu->buckets, prev, bucket, buckets);
+    else
+        TAILQ_INSERT_HEAD(&lfu->buckets, bucket, buckets);
+    return bucket;
+}
+
+// Unlink frame from its bucket, returning the bucket to the spare list once it is empty
+static void lfu_unlink(Lfu *lfu, Frame *frame)
+{
+    Freq_Bucket *bucket = frame->bucket;
+    TAILQ_REMOVE(&bucket->frames, frame, order);
+    frame->bucket = NULL;
+    if (TAILQ_EMPTY(&bucket->frames))
+    {
+        TAILQ_REMOVE(&lfu->buckets, bucket, buckets);
+        TAILQ_INSERT_HEAD(&lfu->spare, bucket, buckets);
+    }
+}
+
+Frame *lfu_insert(Lfu *lfu, int page)
+{
+    Frame *frame = TAILQ_FIRST(&lfu->free);
+    if (frame == NULL)
+        return NULL;
+    TAILQ_REMOVE(&lfu->free, frame, order);
+    frame->page = page;
+    frame->frequency = 1;
+    frame->bucket = lfu_bucket_after(lfu, NULL, 1);
+    TAILQ_INSERT_TAIL(&frame->bucket->frames, frame, order);
+    page_map_put(&lfu->map, page, frame);
+    lfu->size++;
+    return frame;
+}
+
+void lfu_touch(Lfu *lfu, Frame *frame)
+{
+    Freq_Bucket *bucket = frame->bucket;
+    Freq_Bucket *next = lfu_bucket_after(lfu, bucket, bucket->frequency + 1);
+    lfu_unlink(lfu, frame);
+    frame->frequency = next->frequency;
+    frame->bucket = next;
+    TAILQ_INSERT_TAIL(&next->frames, frame, order);
+}
+
+void lfu_remove(Lfu *lfu, Frame *frame)
+{
+    lfu_unlink(lfu, frame);
+    page_map_remove(&lfu->map, frame->page);
+    frame->page = -1;
+    frame->frequency = 0;
+    TAILQ_INSERT_TAIL(&lfu->free, frame, order);
+    lfu->size--;
+}
+
+Frame *lfu_least(Lfu *lfu)
+{
+    Freq_Bucket *bucket = TAILQ_FIRST(&lfu->buckets);
+    return bucket ? TAILQ_FIRST(&bucket->frames) : NULL;
+}
+
+Frame *lfu_most(Lfu *lfu)
+{
+    Freq_Bucket *bucket = TAILQ_LAST(&lfu->buckets, Freq_Buckets);
+    return bucket ? TAILQ_FIRST(&bucket->frames) : NULL;
+}
+
+void lfu_free(Lfu *lfu)
+{
+    page_map_free(&lfu->map);
+    free(lfu->pool);
+    lfu->pool = NULL;
+}
+
+// Setup hook for LFU and MFU, the buckets run over the page_table frames
+void initializeFrequency(Algorithm_Data *data)
+{
+    if (lfu_init(&data->lfu, data->frame_arena, data->num_frames) != 0)
+        exit(1);
+}
+
+// Page map section
+
+// Fibonacci hash of a page into a slot
+static unsigned int page_map_slot(const Page_Map *map, int page)
+{
+    unsigned int h = (unsigned int)page * 2654435769u;
+    return (h ^ (h >> 16)) & map->mask;
+}
+
+// Allocate a map with at least twice as many slots as expected pages
+int page_map_init(Page_Map *map, int expected)
+{
+    unsigned int capacity = 8;
+    while (capacity < 2u * (unsigned int)expected)
+        capacity <<= 1;
+    map->keys = malloc(sizeof(int) * capacity);
+    map->values = malloc(sizeof(Frame *) * capacity);
+    if (!map->keys || !map->values)
+    {
+        fprintf(stderr, "Failed to allocate memory for page map\n");
+        free(map->keys);
+        free(map->values);
+        map->keys = NULL;
+        map->values = NULL;
+        return -1;
+    }
+    for (unsigned int i = 0; i < capacity; ++i)
+        map->keys[i] = -1;
+    map->mask = capacity - 1;
+    return 0;
+}
+
+// Frame holding page, NULL if page is not resident
+Frame *page_map_get(Page_Map *map, int page)
+{
+    unsigned int i = page_map_slot(map, page);
+    while (map->keys[i] != -1)
+    {
+        if (map->keys[i] == page)
+            return map->values[i];
+        i = (i + 1) & map->mask;
+    }
+    return NULL;
+}
+
+// Insert or update the frame holding page
+void page_map_put(Page_Map *map, int page, Frame *frame)
+{
+    unsigned int i = page_map_slot(map, page);
+    while (map->keys[i] != -1 && map->keys[i] != page)
+        i = (i + 1) & map->mask;
+    map->keys[i] = page;
+    map->values[i] = frame;
+}
+
+// Grow the map to at least twice as many slots as expected pages, rehashing what it holds
+int page_map_reserve(Page_Map *map, int expected)
+{
+    if (2u * (unsigned int)expected <= map->mask + 1)
+        return 0;
+    Page_Map bigger;
+    if (page_map_init(&bigger, expected) != 0)
+        return -1;
+    for (unsigned int i = 0; i <= map->mask; ++i)
+    {
+        if (map->keys[i] != -1)
+            page_map_put(&bigger, map->keys[i], map->values[i]);
+    }
+    page_map_free(map);
+    *map = bigger;
+    return 0;
+}
+
+// Remove page, shifting later entries of its probe run back so lookups need no tombstones
+void page_map_remove(Page_Map *map, int page)
+{
+    unsigned int i = page_map_slot(map, page);
+    while (map->keys[i] != page)
+    {
+        if (map->keys[i] == -1)
+            return;
+        i = (i + 1) & map->mask;
+    }
+    unsigned int j = i;
+    for (;;)
+    {
+        j = (j + 1) & map->mask;
+        if (map->keys[j] == -1)
+            break;
+        unsigned int home = page_map_slot(map, map->keys[j]);
+        // Move j back into the hole at i unless its home slot lies cyclically in (i, j]
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j))
+        {
+            map->keys[i] = map->keys[j];
+            map->values[i] = map->values[j];
+            i = j;
+        }
+    }
+    map->keys[i] = -1;
+}
+
+void page_map_free(Page_Map *map)
+{
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+}
+
+// Tenant section
+// With --pid-aware a ref is paged by a dense key for its (pid, page) pair, so two processes
+// never share a page. With --tenants each pid is a tenant: results are broken down per pid,
+// and in static mode every tenant gets its own page table of a fixed share of the frames.
+
+static unsigned int key_map_slot(const Key_Map *map, uint64_t key)
+{
+    return (unsigned int)splitmix64(key) & map->mask;
+}
+
+int key_map_init(Key_Map *map, int expected)
+{
+    unsigned int capacity = 16;
+    while (capacity < (unsigned int)expected * 2)
+        capacity <<= 1;
+    map->keys = malloc(sizeof(uint64_t) * capacity);
+    map->ids = malloc(sizeof(int) * capacity);
+    map->mask = capacity - 1;
+    map->size = 0;
+    if (!map->keys || !map->ids)
+    {
+        fprintf(stderr, "Failed to allocate memory for key map\n");
+        key_map_free(map);
+        return -1;
+    }
+    for (unsigned int i = 0; i < capacity; i++)
+        map->ids[i] = -1;
+    return 0;
+}
+
+// Double the table, rehashing every key
+static int key_map_grow(Key_Map *map)
+{
+    Key_Map bigger;
+    if (key_map_init(&bigger, (int)(map->mask + 1)) != 0)
+        return -1;
+    for (unsigned int i = 0; i <= map->mask; i++)
+    {
+        if (map->ids[i] == -1)
+            continue;
+        unsigned int slot = key_map_slot(&bigger, map->keys[i]);
+        while (bigger.ids[slot] != -1)
+            slot = (slot + 1) & bigger.mask;
+        bigger.keys[slot] = map->keys[i];
+        bigger.ids[slot] = map->ids[i];
+    }
+    bigger.size = map->size;
+    key_map_free(map);
+    *map = bigger;
+    return 0;
+}
+
+int key_map_id(Key_Map *map, uint64_t key)
+{
+    unsigned int slot = key_map_slot(map, key);
+    while (map->ids[slot] != -1)
+    {
+        if (map->keys[slot] == key)
+            return map->ids[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    // Kept at most half full, so probes stay short
+    if ((unsigned int)(map->size + 1) * 2 > map->mask + 1)
+    {
+        if (key_map_grow(map) != 0)
+            return -1;
+        slot = key_map_slot(map, key);
+        while (map->ids[slot] != -1)
+            slot = (slot + 1) & map->mask;
+    }
+    map->keys[slot] = key;
+    map->ids[slot] = map->size;
+    return map->size++;
+}
+
+int key_map_find(const Key_Map *map, uint64_t key)
+{
+    if (map->ids == NULL)
+        return -1;
+    for (unsigned int slot = key_map_slot(map, key); map->ids[slot] != -1; slot = (slot + 1) & map->mask)
+    {
+        if (map->keys[slot] == key)
+            return map->ids[slot];
+    }
+    return -1;
+}
+
+void key_map_free(Key_Map *map)
+{
+    free(map->keys);
+    free(map->ids);
+    memset(map, 0, sizeof(Key_Map));
+}
+
+// Set up a table with every page at empty, the far pages are added as they are seen
+int page_values_init(Page_Values *values, int64_t empty)
+{
+    memset(values, 0, sizeof(Page_Values));
+    values->empty = empty;
+    values->near_size = page_ref_upper_bound;
+    values->near = malloc(sizeof(int64_t) * (values->near_size > 0 ? values->near_size : 1));
+    if (!values->near)
+    {
+        fprintf(stderr, "Failed to allocate memory for page values\n");
+        return -1;
+    }
+    page_values_clear(values);
+    return 0;
+}
+
+int64_t *page_values_at(Page_Values *values, int page)
+{
+    if (page >= 0 && page < values->near_size)
+        return &values->near[page];
+    if (values->far_ids.ids == NULL && key_map_init(&values->far_ids, 64) != 0)
+        return NULL;
+    int id = key_map_id(&values->far_ids, (uint32_t)page);
+    if (id < 0)
+        return NULL;
+    if (id >= values->far_size)
+    {
+        int size = values->far_size > 0 ? values->far_size * 2 : 64;
+        int64_t *far = realloc(values->far, sizeof(int64_t) * size);
+        if (!far)
+        {
+            fprintf(stderr, "Failed to allocate memory for page values\n");
+            return NULL;
+        }
+        for (int i = values->far_size; i < size; i++)
+            far[i] = values->empty;
+        values->far = far;
+        values->far_size = size;
+    }
+    return &values->far[id];
+}
+
+int64_t page_values_get(const Page_Values *values, int page)
+{
+    if (page >= 0 && page < values->near_size)
+        return values->near[page];
+    int id = key_map_find(&values->far_ids, (uint32_t)page);
+    return id >= 0 ? values->far[id] : values->empty;
+}
+
+void page_values_clear(Page_Values *values)
+{
+    for (int i = 0; i < values->near_size; i++)
+        values->near[i] = values->empty;
+    for (int i = 0; i < values->far_size; i++)
+        values->far[i] = values->empty;
+}
+
+void page_values_free(Page_Values *values)
+{
+    free(values->near);
+    free(values->far);
+    key_map_free(&values->far_ids);
+    memset(values, 0, sizeof(Page_Values));
+}
+
+// Key a ref is paged by: its block (the page itself unless --line-size is given), or a
+// dense id of (pid, block) with --pid-aware
+int ref_key(int pid, int page)
+{
+    page = (int)((unsigned int)page >> line_shift);
+    if (!pid_aware)
+        return page;
+    int id = key_map_id(&ref_keys, ((uint64_t)(uint32_t)pid << 32) | (uint32_t)page);
+    if (id < 0)
+        exit(1);
+    return id;
+}
+
+// Tenant index of pid, tenants are numbered in the order their pids first appear
+int tenant_of(int pid)
+{
+    int tenant = key_map_id(&tenant_map, (uint32_t)pid);
+    if (tenant < 0)
+        exit(1);
+    if (tenant == num_tenants)
+    {
+        // Grow in powers of two
+        if ((num_tenants & (num_tenants - 1)) == 0)
+        {
+            int *pids = realloc(tenant_pids, sizeof(int) * (num_tenants > 0 ? num_tenants * 2 : 1));
+            if (!pids)
+            {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(1);
+            }
+            tenant_pids = pids;
+        }
+        tenant_pids[num_tenants++] = pid;
+    }
+    return tenant;
+}
+
+int tenant_at(int64_t position)
+{
+    if (tenant_mode == TENANT_OFF)
+        return 0;
+    if (stream_mode)
+        return trace_stream.ring[position & (trace_stream.capacity - 1)].tenant;
+    return trace_tenants != NULL && position < num_refs ? trace_tenants[position] : 0;
+}
+
+uint32_t size_at(int64_t position)
+{
+    if (stream_mode)
+        return trace_stream.ring[position & (trace_stream.capacity - 1)].size;
+    return trace_sizes != NULL && position < num_refs ? trace_sizes[position] : 1;
+}
+
+// global, static, or static:PID=W,PID=W... where tenants not listed weigh 1
+int parse_tenant_mode(const char *spec)
+{
+    num_tenant_weights = 0;
+    if (strcmp(spec, "global") == 0)
+    {
+        tenant_mode = TENANT_GLOBAL;
+        return 0;
+    }
+    if (strncmp(spec, "static", 6) != 0 || (spec[6] != '\0' && spec[6] != ':'))
+        return -1;
+    tenant_mode = TENANT_STATIC;
+    const char *p = spec[6] == ':' ? spec + 7 : spec + 6;
+    while (*p != '\0')
+    {
+        char *end;
+        long pid = strtol(p, &end, 10);
+        if (end == p || *end != '=' || num_tenant_weights == MAX_TENANT_WEIGHTS)
+            return -1;
+        p = end + 1;
+        long weight = strtol(p, &end, 10);
+        if (end == p || weight < 1 || (*end != ',' && *end != '\0'))
+            return -1;
+        tenant_weight_pids[num_tenant_weights] = (int)pid;
+        tenant_weights[num_tenant_weights++] = (int)weight;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
+// Split frames over the tenants by weight, each gets at least one and the rounding
+// leftovers go to the first tenants. -1 if there are fewer frames than tenants
+int tenant_frames(int frames, int *shares)
+{
+    if (frames < num_tenants)
+        return -1;
+    long total = 0;
+    for (int t = 0; t < num_tenants; t++)
+    {
+        shares[t] = 1;
+        for (int w = 0; w < num_tenant_weights; w++)
+        {
+            if (tenant_weight_pids[w] == tenant_pids[t])
+                shares[t] = tenant_weights[w];
+        }
+        total += shares[t];
+    }
+    int rest = frames - num_tenants, given = 0;
+    for (int t = 0; t < num_tenants; t++)
+    {
+        shares[t] = 1 + (int)((long)rest * shares[t] / total);
+        given += shares[t];
+    }
+    for (int t = 0; given < frames; t = (t + 1) % num_tenants, given++)
+        shares[t]++;
+    return 0;
+}
+
+// Count a ref of tenant in data's per-tenant results
+void tenant_count(Algorithm_Data *data, int tenant, int fault)
+{
+    if (tenant >= data->num_tenants)
+    {
+        int size = data->num_tenants > 0 ? data->num_tenants : 4;
+        while (size <= tenant)
+            size *= 2;
+        Tenant_Stats *tenants = realloc(data->tenants, sizeof(Tenant_Stats) * size);
+        if (!tenants)
+            return;
+        memset(tenants + data->num_tenants, 0, sizeof(Tenant_Stats) * (size - data->num_tenants));
+        data->tenants = tenants;
+        data->num_tenants = size;
+    }
+    if (fault)
+        data->tenants[tenant].misses++;
+    else
+        data->tenants[tenant].hits++;
+}
+
+// Page data->page_ref in its set's or tenant's partition if data has them, else in data itself
+int page_data(Algorithm *algo, Algorithm_Data *data)
+{
+    if (tenant_mode == TENANT_OFF && data->num_partitions == 0 && !trace_has_sizes && data->shadow == NULL)
+        return data->prefetch != NULL ? prefetch_page(algo, data) : algo->algo(data);
+    int fault;
+    if (data->shadow != NULL)
+        data->shadow->now = data->position;
+    data->tenant = tenant_at(data->position);
+    data->size = size_at(data->position);
+    int index = assoc_ways > 0 ? set_of(data->page_ref, data->num_partitions) : data->tenant;
+    if (index < data->num_partitions)
+    {
+        Algorithm_Data *part = data->partitions[index];
+        part->page_ref = data->page_ref;
+        part->position = data->position;
+        part->tenant = data->tenant;
+        part->size = data->size;
+        fault = algo->algo(part);
+        if (fault)
+            data->misses++;
+        else
+            data->hits++;
+    }
+    else
+    {
+        fault = data->prefetch != NULL ? prefetch_page(algo, data) : algo->algo(data);
+    }
+    if (data->shadow != NULL)
+        shadow_count(data->shadow, data->page_ref, data->position, fault);
+    if (tenant_mode != TENANT_OFF)
+        tenant_count(data, data->tenant, fault);
+    if (fault)
+        data->byte_misses += data->size;
+    else
+        data->byte_hits += data->size;
+    return fault;
+}
+
+// One line per tenant that made a ref
+int print_tenants(const Algorithm_Data *data)
+{
+    for (int t = 0; t < data->num_tenants && t < num_tenants; t++)
+    {
+        const Tenant_Stats *stats = &data->tenants[t];
+        if (stats->hits + stats->misses == 0)
+            continue;
+        printf("  pid %d: Hits: %llu, Misses: %llu, Hit Ratio: %f", tenant_pids[t], (unsigned long long)stats->hits,
+               (unsigned long long)stats->misses,
+               (double)stats->hits / (double)(stats->hits + stats->misses));
+        if (stats->frames > 0)
+            printf(", Frames: %d", stats->frames);
+        printf("\n");
+    }
+    return 0;
+}
+
+// Comparator function for sorting algorithms by hit ratio
+int compare_hit_ratio(const void *a, const void *b)
+{
+    const Algorithm *algoA = (const Algorithm *)a;
+    const Algorithm *algoB = (const Algorithm *)b;
+    // Unselected algorithms paged nothing, they sort last instead of comparing as NaN
+    uint64_t refsA = algoA->data->hits + algoA->data->misses, refsB = algoB->data->hits + algoB->data->misses;
+    double hitRatioA = algoA->selected && refsA > 0 ? (double)algoA->data->hits / refsA : -1.0;
+    double hitRatioB = algoB->selected && refsB > 0 ? (double)algoB->data->hits / refsB : -1.0;
+
+    // For descending order
+    return (hitRatioB > hitRatioA) - (hitRatioB < hitRatioA);
+}
+
+// page all selected algorithms with input ref
+int event_loop()
+{
+    counter = 0;
+    if (mrc_mode)
+    {
+        return run_stack_distance();
+    }
+    if (concurrent_threads > 0)
+    {
+        return run_concurrent();
+    }
+    if (bench_path != NULL)
+    {
+        return run_bench(workload_specs);
+    }
+    if (sample_error && sweep_frames == NULL)
+    {
+        // The error report compares jobs, so run num_frames as a one point sweep
+        sweep_frames = malloc(sizeof(int));
+        if (!sweep_frames)
+            return 1;
+        sweep_frames[0] = num_frames;
+        num_sweep_frames = 1;
+    }
+    if (sweep_frames != NULL)
+    {
+        return run_sweep();
+    }
+    if (resume_path != NULL)
+    {
+        if (read_checkpoint(resume_path) != 0)
+            exit(1);
+        // A streamed trace continues from where the checkpoint was taken
+        if (stream_mode && trace_stream_seek(&trace_stream, counter) != 0)
+        {
+            printf("Trace %s ends before ref %llu of the checkpoint\n", trace_name, (unsigned long long)counter);
+            exit(1);
+        }
+    }
+    if (num_threads > 0)
+    {
+        run_parallel();
+    }
+    else if (batch_size > 0)
+    {
+        replay_batches();
+    }
+    else
+    {
+        while (has_ref() && (checkpoint_at == 0 || counter < checkpoint_at))
+        {
+            page(get_ref());
+            ++counter;
+            if (checkpoint_every > 0 && counter % checkpoint_every == 0)
+                write_checkpoint(checkpoint_path);
+        }
+    }
+    if (checkpoint_path != NULL && write_checkpoint(checkpoint_path) != 0)
+        exit(1);
+
+    if (frame_scale != 1.0)
+        printf("Sampled trace at rate %f: %d frames replayed as %d\n", frame_scale, num_frames, scaled_frames(num_frames));
+
+    // Sort algorithms by hit ratio in descending order
+    qsort(algos, num_algos, sizeof(Algorithm), compare_hit_ratio);
+
+    // Print the sorted results
+    for (size_t i = 0; i < num_algos; i++)
+    {
+        if (algos[i].selected == 1)
+        {
+            print_summary(algos[i]);
+        }
+    }
+    return write_results();
+}
+
+// 1 while there are page refs left to test
+int has_ref()
+{
+    if (stream_mode)
+        return trace_stream_has_ref(&trace_stream);
+    return counter < num_refs;
+}
+
+// get a random ref
+int get_ref()
+{
+    if (stream_mode)
+        return trace_stream_get_ref(&trace_stream);
+    if (trace_pages != NULL && counter < num_refs)
+        return (int)trace_pages[counter];
+    // just in case
+    return (int)rng_below(&gen_rng, (uint32_t)page_ref_upper_bound);
+}
+
+// Next block of up to batch_size refs starting at counter, 0 at the end of the trace
+// Array traces are handed out in place, streamed refs are copied into buffer
+// A block never runs past the next checkpoint
+int next_block(const uint32_t **block, uint32_t *buffer)
+{
+    int n = 0, size = checkpoint_path != NULL && checkpoint_refs_left() < batch_size ? checkpoint_refs_left() : batch_size;
+    if (!stream_mode)
+    {
+        n = num_refs - counter < size ? (int)(num_refs - counter) : size;
+        *block = trace_pages + counter;
+        return n > 0 ? n : 0;
+    }
+    while (n < size && trace_stream_has_ref(&trace_stream))
+        buffer[n++] = (uint32_t)trace_stream_get_ref(&trace_stream);
+    *block = buffer;
+    return n;
+}
+
+// Replay the trace a block at a time, each selected algorithm runs the whole block in a
+// tight loop before the next one, so the block stays in cache and is timed once per algorithm
+int replay_batches()
+{
+    uint32_t *buffer = stream_mode ? malloc(sizeof(uint32_t) * batch_size) : NULL;
+    if (stream_mode && !buffer)
+    {
+        fprintf(stderr, "Memory allocation failed for batch buffer\n");
+        return -1;
+    }
+    const uint32_t *block;
+    int n;
+    int64_t start;
+    while ((n = next_block(&block, buffer)) > 0)
+    {
+        start = counter;
+        for (size_t i = 0; i < num_algos; i++)
+        {
+            if (algos[i].selected == 1)
+                page_block(&algos[i], block, n, start);
+        }
+        counter = start + n;
+        if (checkpoint_every > 0 && counter % checkpoint_every == 0)
+            write_checkpoint(checkpoint_path);
+    }
+    free(buffer);
+    return 0;
+}
+
+// Run one algorithm over a block of refs that starts at trace position start
+int page_block(Algorithm *algo, const uint32_t *block, int n, int64_t start)
+{
+    Algorithm_Data *data = algo->data;
+    uint64_t block_start = latency_now();
+#ifdef CRA_SPECIALIZE
+    // Plain replay with nothing sampled per ref runs the loop compiled for this policy
+    if (interval_refs == 0 && !latency_report && tenant_mode == TENANT_OFF && data->num_partitions == 0 &&
+        !trace_has_sizes && data->prefetch == NULL && data->shadow == NULL)
+    {
+        Replay_Fn replay = replay_kernel(algo->algo, data->arrays.size);
+        if (replay != NULL)
+        {
+            replay(data, block, n, start);
+            data->exec_ticks += latency_net(block_start);
+            return 0;
+        }
+    }
+#endif
+    for (int i = 0; i < n; i++)
+    {
+        data->page_ref = (int)block[i];
+        data->position = start + i;
+        if (latency_report && (start + i) % latency_sample == 0)
+        {
+            uint64_t ref_start = latency_now();
+            int fault = page_data(algo, data);
+            latency_record(data, fault, latency_net(ref_start));
+        }
+        else
+            page_data(algo, data);
+        if (interval_refs > 0 && (start + i + 1) % interval_refs == 0)
+            interval_emit(algo, data->exec_ticks + latency_net(block_start));
+        if (printrefs == 1)
+            print_stats(*algo);
+    }
+    data->exec_ticks += latency_net(block_start);
+    return 0;
+}
+
+// Parallel section
+// Sweeps and parallel runs share the in-memory trace read-only. Each job owns its
+// Algorithm_Data, so jobs need no locking beyond taking the next job index.
+
+// Worker loop, takes jobs until none are left
+void *sweep_worker(void *arg)
+{
+    Sweep_Pool *pool = arg;
+    int j;
+    while ((j = atomic_fetch_add(&pool->next_job, 1)) < pool->num_jobs)
+        run_sweep_job(&pool->jobs[j]);
+    return NULL;
+}
+
+// Replay the whole trace through one job
+// Jobs without data get a private page table that is freed once its stats are saved
+void run_sweep_job(Sweep_Job *job)
+{
+    int owned = (job->algo.data == NULL);
+    if (owned)
+    {
+        job->algo.data = setup_algo_data(&job->algo, scaled_frames(job->frames));
+    }
+    int chunk = batch_size > 0 ? batch_size : num_refs;
+    for (int start = 0; start < num_refs; start += chunk)
+        page_block(&job->algo, trace_pages + start, num_refs - start < chunk ? num_refs - start : chunk, start);
+    job->hits = job->algo.data->hits;
+    job->misses = job->algo.data->misses;
+    job->byte_hits = job->algo.data->byte_hits;
+    job->byte_misses = job->algo.data->byte_misses;
+    job->evictions = eviction_count(job->algo.data);
+    job->prefetches = job->algo.data->prefetch != NULL ? job->algo.data->prefetch->issued : 0;
+    job->useful_prefetches = job->algo.data->prefetch != NULL ? job->algo.data->prefetch->useful : 0;
+    job->exec_ticks = job->algo.data->exec_ticks;
+    if (owned)
+    {
+        destroy_algo_data_store(job->algo.data);
+        job->algo.data = NULL;
+    }
+}
+
+// Run jobs on num_threads workers (or the calling thread if there is only one)
+int run_jobs(Sweep_Job *jobs, int num_jobs)
+{
+    Sweep_Pool pool;
+    pool.jobs = jobs;
+    pool.num_jobs = num_jobs;
+    atomic_init(&pool.next_job, 0);
+
+    // anything shared between jobs is built up front, workers only read it
+    for (int j = 0; j < num_jobs; j++)
+    {
+        if (jobs[j].algo.algo == &OPTIMAL && next_use_index == NULL && build_next_use_index() != 0)
+            return -1;
+    }
+
+    int workers = num_threads > 0 ? num_threads : 1;
+    if (workers > num_jobs)
+        workers = num_jobs;
+    if (workers <= 1)
+    {
+        sweep_worker(&pool);
+        return 0;
+    }
+    pthread_t *threads = malloc(sizeof(pthread_t) * workers);
+    if (!threads)
+    {
+        fprintf(stderr, "Memory allocation failed for worker threads\n");
+        return -1;
+    }
+    int started = 0;
+    for (; started < workers; started++)
+    {
+        if (pthread_create(&threads[started], NULL, sweep_worker, &pool) != 0)
+            break;
+    }
+    if (started == 0)
+        sweep_worker(&pool);
+    for (int t = 0; t < started; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+    return 0;
+}
+
+// Run each selected algorithm as its own job on the pool, using the data made by init()
+int run_parallel()
+{
+    if (stream_mode)
+    {
+        printf("--threads needs the trace in memory, paging on the main thread\n");
+        while (has_ref())
+        {
+            page(get_ref());
+            ++counter;
+        }
+        return 0;
+    }
+    if (printrefs || debug)
+    {
+        num_threads = 1; // keep per-ref output in order
+    }
+    Sweep_Job *jobs = calloc(num_algos, sizeof(Sweep_Job));
+    int num_jobs = 0;
+    if (!jobs)
+        return -1;
+    for (size_t i = 0; i < num_algos; i++)
+    {
+        if (algos[i].selected == 1)
+        {
+            jobs[num_jobs].algo = algos[i];
+            jobs[num_jobs].frames = algos[i].data->num_frames;
+            num_jobs++;
+        }
+    }
+    run_jobs(jobs, num_jobs);
+    counter = num_refs;
+    free(jobs);
+    return 0;
+}
+
+// Sweep every selected algorithm over every frame count in sweep_frames and print the table
+int run_sweep()
+{
+    if (stream_mode)
+    {
+        printf("--frames needs the trace in memory, it cannot be combined with --stream\n");
+        return 1;
+    }
+    if (num_threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (int)online : 1;
+    }
+    if (printrefs || debug)
+        num_threads = 1;
+
+    int selected = 0;
+    for (size_t i = 0; i < num_algos; i++)
+        selected += (algos[i].selected == 1);
+    int num_jobs = selected * num_sweep_frames;
+    Sweep_Job *jobs = calloc(num_jobs > 0 ? num_jobs : 1, sizeof(Sweep_Job));
+    if (!jobs)
+    {
+        fprintf(stderr, "Memory allocation failed for sweep jobs\n");
+        return 1;
+    }
+    int j = 0;
+    for (size_t i = 0; i < num_algos; i++)
+    {
+        if (algos[i].selected != 1)
+            continue;
+        for (int f = 0; f < num_sweep_frames; f++)
+        {
+            jobs[j].algo = algos[i];
+            jobs[j].algo.data = NULL; // private to the job
+            jobs[j].frames = sweep_frames[f];
+            j++;
+        }
+    }
+
+    printf("Sweep: %d algorithms x %d frame counts over %d refs on %d threads\n", selected, num_sweep_frames, num_refs, num_threads);
+    if (exact_pages == NULL)
+    {
+        run_jobs(jobs, num_jobs);
+        print_sweep(jobs, num_jobs);
+        write_sweep_results(jobs, num_jobs);
+        free(jobs);
+        return 0;
+    }
+
+    // --sample-error: replay the unsampled trace at full size first, then the sampled one
+    Sweep_Job *exact = malloc(sizeof(Sweep_Job) * (num_jobs > 0 ? num_jobs : 1));
+    if (!exact)
+    {
+        fprintf(stderr, "Memory allocation failed for sweep jobs\n");
+        free(jobs);
+        return 1;
+    }
+    memcpy(exact, jobs, sizeof(Sweep_Job) * num_jobs);
+    const uint32_t *sampled_pages = trace_pages;
+    int sampled_refs = num_refs;
+    double scale = frame_scale;
+    trace_pages = exact_pages;
+    num_refs = exact_refs;
+    frame_scale = 1.0;
+    free(next_use_index); // OPTIMAL indexes the trace it replays
+    next_use_index = NULL;
+    run_jobs(exact, num_jobs);
+    free(next_use_index);
+    next_use_index = NULL;
+    trace_pages = sampled_pages;
+    num_refs = sampled_refs;
+    frame_scale = scale;
+    run_jobs(jobs, num_jobs);
+    print_sample_error(exact, jobs, num_jobs);
+    write_sweep_results(jobs, num_jobs);
+    free(exact);
+    free(jobs);
+    return 0;
+}
+
+// Print one row per sweep job, grouped by algorithm in frame order
+int print_sweep(Sweep_Job *jobs, int num_jobs)
+{
+    printf("%-10s %10s %12s %12s %10s %12s", "Algorithm", "Frames", "Hits", "Misses", "Hit Ratio", "Time (s)");
+    if (prefetch_kind != PREFETCH_OFF)
+        printf(" %12s %12s", "Prefetches", "Useful");
+    printf(trace_has_sizes ? " %10s\n" : "\n", "Byte Ratio");
+    for (int j = 0; j < num_jobs; j++)
+    {
+        double total = (double)(jobs[j].hits + jobs[j].misses);
+        double bytes = (double)(jobs[j].byte_hits + jobs[j].byte_misses);
+        printf("%-10s %10d %12llu %12llu %10f %12f", jobs[j].algo.label, jobs[j].frames, (unsigned long long)jobs[j].hits,
+               (unsigned long long)jobs[j].misses,
+               total > 0 ? jobs[j].hits / total : 0.0, latency_ns(jobs[j].exec_ticks) / 1e9);
+        if (prefetch_kind != PREFETCH_OFF)
+            printf(" %12llu %12llu", (unsigned long long)jobs[j].prefetches, (unsigned long long)jobs[j].useful_prefetches);
+        printf(trace_has_sizes ? " %10f\n" : "\n", bytes > 0 ? jobs[j].byte_hits / bytes : 0.0);
+    }
+    return 0;
+}
+
+static double job_hit_ratio(const Sweep_Job *job)
+{
+    double total = (double)(job->hits + job->misses);
+    return total > 0 ? job->hits / total : 0.0;
+}
+
+// Print sampled against exact hit ratios for each sweep job, and the mean error per algorithm
+int print_sample_error(Sweep_Job *exact, Sweep_Job *sampled, int num_jobs)
+{
+    printf("%-10s %10s %10s %10s %10s %12s %12s\n", "Algorithm", "Frames", "Exact", "Sampled", "Error", "Exact (s)", "Sampled (s)");
+    for (int j = 0; j < num_jobs; j++)
+    {
+        double want = job_hit_ratio(&exact[j]);
+        double got = job_hit_ratio(&sampled[j]);
+        printf("%-10s %10d %10f %10f %10f %12f %12f\n", exact[j].algo.label, exact[j].frames, want, got,
+               got > want ? got - want : want - got, latency_ns(exact[j].exec_ticks) / 1e9,
+               latency_ns(sampled[j].exec_ticks) / 1e9);
+    }
+    for (int j = 0; j < num_jobs;)
+    {
+        const char *label = exact[j].algo.label;
+        double total = 0;
+        int points = 0;
+        for (; j < num_jobs && exact[j].algo.label == label; j++, points++)
+        {
+            double want = job_hit_ratio(&exact[j]);
+            double got = job_hit_ratio(&sampled[j]);
+            total += got > want ? got - want : want - got;
+        }
+        printf("%s mean absolute error: %f over %d frame counts\n", label, total / points, points);
+    }
+    return 0;
+}
+
+// Library section
+// Build with -DCRA_NO_MAIN to link the policies into another program. A Policy_Cache is one
+// algos[] policy over its own page table, fed keys instead of trace refs, so the simulator and
+// an embedding run the same code. Policies read the configuration globals (--victims, --lfru-ratio,
+// ...) but write only their own Algorithm_Data, so caches on different threads need no locking.
+// A cache counts its accesses in 64 bits, like a streamed trace position, so it never runs out of them.
+
+Policy_Cache *policy_cache_create(const char *label, int frames)
+{
+    const Algorithm *algo = NULL;
+    for (size_t i = 0; i < sizeof(algos) / sizeof(Algorithm); i++)
+        if (strcasecmp(label, algos[i].label) == 0 && !(algos[i].flags & ALGO_OFFLINE))
+            algo = &algos[i];
+    Policy_Cache *cache = algo != NULL && frames > 0 ? malloc(sizeof(Policy_Cache)) : NULL;
+    if (cache == NULL)
+        return NULL;
+    cache->algo = *algo;
+    cache->algo.selected = 1;
+    cache->algo.data = setup_algo_data(&cache->algo, frames);
+    cache->accesses = 0;
+    return cache;
+}
+
+int policy_cache_access(Policy_Cache *cache, int key)
+{
+    if (key < 0)
+        return -1;
+    Algorithm_Data *data = cache->algo.data;
+    data->page_ref = key;
+    data->position = cache->accesses++;
+    data->tenant = 0;
+    data->size = 1;
+    if (data->num_partitions > 0)
+        return page_data(&cache->algo, data);
+    return cache->algo.algo(data);
+}
+
+// hook(arg, key) runs inside policy_cache_access() for every key it evicts
+void policy_cache_evict_hook(Policy_Cache *cache, void (*hook)(void *arg, int key), void *arg)
+{
+    Algorithm_Data *data = cache->algo.data;
+    data->evict_hook = hook;
+    data->evict_arg = arg;
+    for (int i = 0; i < data->num_partitions; i++)
+    {
+        data->partitions[i]->evict_hook = hook;
+        data->partitions[i]->evict_arg = arg;
+    }
+}
+
+void policy_cache_destroy(Policy_Cache *cache)
+{
+    if (cache == NULL)
+        return;
+    destroy_algo_data_store(cache->algo.data);
+    free(cache);
+}
+
+// Each shard gets frames / shards frames, the first frames % shards one more
+Sharded_Cache *sharded_cache_create(const char *label, int frames, int shards)
+{
+    if (shards < 1 || frames < shards)
+        return NULL;
+    Sharded_Cache *cache = malloc(sizeof(Sharded_Cache));
+    Cache_Shard *array = cache ? aligned_alloc(CACHE_LINE, sizeof(Cache_Shard) * shards) : NULL;
+    if (!array)
+    {
+        free(cache);
+        return NULL;
+    }
+    cache->shards = array;
+    cache->num_shards = 0;
+    for (int i = 0; i < shards; i++)
+    {
+        Cache_Shard *shard = &array[i];
+        shard->cache = policy_cache_create(label, frames / shards + (i < frames % shards));
+        if (shard->cache == NULL)
+        {
+            sharded_cache_destroy(cache);
+            return NULL;
+        }
+        pthread_mutex_init(&shard->lock, NULL);
+        cache->num_shards++;
+    }
+    return cache;
+}
+
+int sharded_cache_access(Sharded_Cache *cache, int key)
+{
+    if (key < 0)
+        return -1;
+    Cache_Shard *shard = &cache->shards[splitmix64((uint32_t)key) % (uint64_t)cache->num_shards];
+    pthread_mutex_lock(&shard->lock);
+    int fault = policy_cache_access(shard->cache, key);
+    pthread_mutex_unlock(&shard->lock);
+    return fault;
+}
+
+// The hook runs under the evicting shard's lock, so it must not access the same cache
+void sharded_cache_evict_hook(Sharded_Cache *cache, void (*hook)(void *arg, int key), void *arg)
+{
+    for (int i = 0; i < cache->num_shards; i++)
+    {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        policy_cache_evict_hook(cache->shards[i].cache, hook, arg);
+        pthread_mutex_unlock(&cache->shards[i].lock);
+    }
+}
+
+void sharded_cache_stats(Sharded_Cache *cache, uint64_t *hits, uint64_t *misses)
+{
+    *hits = 0;
+    *misses = 0;
+    for (int i = 0; i < cache->num_shards; i++)
+    {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        *hits += cache->shards[i].cache->algo.data->hits;
+        *misses += cache->shards[i].cache->algo.data->misses;
+        pthread_mutex_unlock(&cache->shards[i].lock);
+    }
+}
+
+void sharded_cache_destroy(Sharded_Cache *cache)
+{
+    if (cache == NULL)
+        return;
+    for (int i = 0; i < cache->num_shards; i++)
+    {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+        policy_cache_destroy(cache->shards[i].cache);
+    }
+    free(cache->shards);
+    free(cache);
+}
+
+// Concurrent CLOCK section
+// A hit probes the index without locking, checks the frame still holds the page and sets its
+// reference bit. Index slots pack page and frame into one word, so a probe never sees half an
+// entry, and a miss removes a victim's slot before reusing its frame, so a stale slot fails the
+// check. A probe that misses (even falsely, while a removal shifts entries) takes the lock and
+// looks again. With one thread the results match CLOCK() exactly.
+
+static uint32_t cclockHome(const Concurrent_Clock *cc, int page)
+{
+    return (uint32_t)splitmix64((uint32_t)page) & cc->mask;
+}
+
+// Frame of page, -1 if not cached; exact only under the lock
+static int cclockFind(Concurrent_Clock *cc, int page)
+{
+    uint32_t slot = cclockHome(cc, page);
+    for (uint32_t probe = 0; probe <= cc->mask; probe++, slot = (slot + 1) & cc->mask)
+    {
+        uint64_t entry = atomic_load_explicit(&cc->index[slot], memory_order_acquire);
+        if (entry == CCLOCK_EMPTY)
+            return -1;
+        if ((int)(entry >> 32) == page)
+        {
+            int frame = (int)(uint32_t)entry;
+            return atomic_load_explicit(&cc->pages[frame], memory_order_acquire) == page ? frame : -1;
+        }
+    }
+    return -1;
+}
+
+// Remove page's slot under the lock, shifting later entries of the run back over it
+static void cclockRemove(Concurrent_Clock *cc, int page)
+{
+    uint32_t hole = cclockHome(cc, page);
+    while ((int)(atomic_load_explicit(&cc->index[hole], memory_order_relaxed) >> 32) != page)
+        hole = (hole + 1) & cc->mask;
+    for (uint32_t slot = (hole + 1) & cc->mask;; slot = (slot + 1) & cc->mask)
+    {
+        uint64_t entry = atomic_load_explicit(&cc->index[slot], memory_order_relaxed);
+        if (entry == CCLOCK_EMPTY)
+            break;
+        uint32_t home = cclockHome(cc, (int)(entry >> 32));
+        // An entry may fill the hole unless its home lies cyclically in (hole, slot]
+        if (hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot))
+            continue;
+        atomic_store_explicit(&cc->index[hole], entry, memory_order_release);
+        hole = slot;
+    }
+    atomic_store_explicit(&cc->index[hole], CCLOCK_EMPTY, memory_order_release);
+}
+
+static void cclockInsert(Concurrent_Clock *cc, int page, int frame)
+{
+    uint32_t slot = cclockHome(cc, page);
+    while (atomic_load_explicit(&cc->index[slot], memory_order_relaxed) != CCLOCK_EMPTY)
+        slot = (slot + 1) & cc->mask;
+    atomic_store_explicit(&cc->index[slot], (uint64_t)(uint32_t)page << 32 | (uint32_t)frame, memory_order_release);
+}
+
+int concurrent_clock_init(Concurrent_Clock *cc, int frames)
+{
+    uint32_t slots = 2;
+    while (slots < 2 * (uint32_t)frames)
+        slots <<= 1;
+    cc->index = malloc(sizeof(uint64_t) * slots);
+    cc->pages = malloc(sizeof(atomic_int) * frames);
+    cc->referenced = malloc(sizeof(atomic_uchar) * frames);
+    if (!cc->index || !cc->pages || !cc->referenced)
+    {
+        concurrent_clock_free(cc);
+        return -1;
+    }
+    for (uint32_t i = 0; i < slots; i++)
+        atomic_init(&cc->index[i], CCLOCK_EMPTY);
+    for (int i = 0; i < frames; i++)
+    {
+        atomic_init(&cc->pages[i], -1);
+        atomic_init(&cc->referenced[i], 0);
+    }
+    cc->mask = slots - 1;
+    cc->size = frames;
+    cc->used = 0;
+    cc->hand = 0;
+    pthread_mutex_init(&cc->lock, NULL);
+    return 0;
+}
+
+int concurrent_clock_access(Concurrent_Clock *cc, int page)
+{
+    int frame = cclockFind(cc, page);
+    if (frame >= 0)
+    {
+        // Skip the store when the bit is already set, so hot pages' lines stay shared
+        if (!atomic_load_explicit(&cc->referenced[frame], memory_order_relaxed))
+            atomic_store_explicit(&cc->referenced[frame], 1, memory_order_relaxed);
+        return 0;
+    }
+    pthread_mutex_lock(&cc->lock);
+    int fault = 1;
+    frame = cclockFind(cc, page);
+    if (frame >= 0)
+        fault = 0; // Loaded by another thread, or a probe that raced a removal
+    else if (cc->used < cc->size)
+        frame = cc->used++;
+    else
+    {
+        // The hand clears reference bits until it finds a frame without one
+        while (atomic_load_explicit(&cc->referenced[cc->hand], memory_order_relaxed))
+        {
+            atomic_store_explicit(&cc->referenced[cc->hand], 0, memory_order_relaxed);
+            cc->hand = cc->hand + 1 == cc->size ? 0 : cc->hand + 1;
+        }
+        frame = cc->hand;
+        cclockRemove(cc, atomic_load_explicit(&cc->pages[frame], memory_order_relaxed));
+    }
+    if (fault)
+    {
+        atomic_store_explicit(&cc->pages[frame], page, memory_order_release);
+        cclockInsert(cc, page, frame);
+    }
+    atomic_store_explicit(&cc->referenced[frame], 1, memory_order_relaxed);
+    pthread_mutex_unlock(&cc->lock);
+    return fault;
+}
+
+void concurrent_clock_free(Concurrent_Clock *cc)
+{
+    if (cc->index != NULL)
+        pthread_mutex_destroy(&cc->lock);
+    free(cc->index);
+    free(cc->pages);
+    free(cc->referenced);
+    cc->index = NULL;
+    cc->pages = NULL;
+    cc->referenced = NULL;
+}
+
+void *concurrent_worker(void *arg)
+{
+    Concurrent_Worker *worker = arg;
+    uint64_t misses = 0;
+    pthread_barrier_wait(worker->start);
+    for (int i = 0; i < worker->n; i++)
+    {
+        int key = worker->keys[i];
+        if (worker->kind == CONCURRENT_CLOCK)
+            misses += concurrent_clock_access(worker->cache, key);
+        else if (worker->kind == CONCURRENT_SHARDED_LRU)
+            misses += sharded_cache_access(worker->cache, key);
+        else
+        {
+            pthread_mutex_lock(worker->lock);
+            misses += policy_cache_access(worker->cache, key);
+            pthread_mutex_unlock(worker->lock);
+        }
+    }
+    worker->misses = misses;
+    worker->hits = (uint64_t)worker->n - misses;
+    return NULL;
+}
+
+// Replay the trace through each concurrent cache on 1, 2, 4... concurrent_threads threads
+// Thread t gets the refs of every pid p with p % threads == t, in trace order, or every
+// threads-th block of refs if there are fewer pids than threads
+int run_concurrent()
+{
+    static const char *labels[CONCURRENT_KINDS] = {"CLOCK", "Locked LRU", "Sharded LRU"};
+    int *keys = malloc(sizeof(int) * (num_refs > 0 ? num_refs : 1));
+    int *offsets = malloc(sizeof(int) * (concurrent_threads + 1));
+    Concurrent_Worker *workers = malloc(sizeof(Concurrent_Worker) * concurrent_threads);
+    pthread_t *threads = malloc(sizeof(pthread_t) * concurrent_threads);
+    if (!keys || !offsets || !workers || !threads)
+    {
+        fprintf(stderr, "Memory allocation failed for the concurrent benchmark\n");
+        free(keys);
+        free(offsets);
+        free(workers);
+        free(threads);
+        return 1;
+    }
+    printf("Concurrent replay of %d refs from %d pids on %d frames\n", num_refs, num_tenants, num_frames);
+    printf("%-12s %8s %12s %12s %10s %12s %8s\n", "Cache", "Threads", "Hits", "Misses", "Hit Ratio", "Mrefs/s", "Speedup");
+    for (int kind = 0; kind < CONCURRENT_KINDS; kind++)
+    {
+        double base = 0;
+        for (int n = 1; n <= concurrent_threads; n = n * 2 > concurrent_threads && n < concurrent_threads ? concurrent_threads : n * 2)
+        {
+            // Deal the refs out, a counting pass then a placing pass
+            memset(offsets, 0, sizeof(int) * (n + 1));
+            for (int pos = 0; pos < num_refs; pos++)
+                offsets[(num_tenants >= n ? tenant_at(pos) : pos / CONCURRENT_BLOCK) % n + 1]++;
+            for (int t = 0; t < n; t++)
+                offsets[t + 1] += offsets[t];
+            for (int t = 0; t < n; t++)
+                workers[t].n = 0;
+            for (int pos = 0; pos < num_refs; pos++)
+            {
+                int t = (num_tenants >= n ? tenant_at(pos) : pos / CONCURRENT_BLOCK) % n;
+                keys[offsets[t] + workers[t].n++] = (int)trace_pages[pos];
+            }
+
+            Concurrent_Clock clock_cache;
+            pthread_mutex_t lock;
+            void *cache;
+            if (kind == CONCURRENT_CLOCK)
+                cache = concurrent_clock_init(&clock_cache, num_frames) == 0 ? &clock_cache : NULL;
+            else if (kind == CONCURRENT_SHARDED_LRU)
+                cache = sharded_cache_create("LRU", num_frames, num_frames < CONCURRENT_SHARDS ? num_frames : CONCURRENT_SHARDS);
+            else
+                cache = policy_cache_create("LRU", num_frames);
+            if (cache == NULL)
+            {
+                fprintf(stderr, "Memory allocation failed for the concurrent benchmark\n");
+                break;
+            }
+            pthread_mutex_init(&lock, NULL);
+            pthread_barrier_t start;
+            pthread_barrier_init(&start, NULL, n + 1);
+            for (int t = 0; t < n; t++)
+            {
+                workers[t].keys = keys + offsets[t];
+                workers[t].kind = kind;
+                workers[t].cache = cache;
+                workers[t].lock = &lock;
+                workers[t].start = &start;
+                pthread_create(&threads[t], NULL, concurrent_worker, &workers[t]);
+            }
+            uint64_t start_time = latency_now(); // Workers are all waiting, the barrier lets them go
+            pthread_barrier_wait(&start);
+            uint64_t hits = 0, misses = 0;
+            for (int t = 0; t < n; t++)
+            {
+                pthread_join(threads[t], NULL);
+                hits += workers[t].hits;
+                misses += workers[t].misses;
+            }
+            double seconds = latency_ns(latency_now() - start_time) / 1e9;
+            pthread_barrier_destroy(&start);
+            pthread_mutex_destroy(&lock);
+            if (kind == CONCURRENT_CLOCK)
+                concurrent_clock_free(&clock_cache);
+            else if (kind == CONCURRENT_SHARDED_LRU)
+                sharded_cache_destroy(cache);
+            else
+                policy_cache_destroy(cache);
+
+            double rate = seconds > 0 ? num_refs / seconds / 1e6 : 0;
+            if (n == 1)
+                base = rate;
+            printf("%-12s %8d %12llu %12llu %10f %12.2f %8.2f\n", labels[kind], n, (unsigned long long)hits,
+                   (unsigned long long)misses, num_refs > 0 ? (double)hits / num_refs : 0.0, rate, base > 0 ? rate / base : 0.0);
+        }
+    }
+    free(keys);
+    free(offsets);
+    free(workers);
+    free(threads);
+    return 0;
+}
+
+// Workload section
+// Synthetic traces for benchmarks, made with a seeded xoshiro256** so every run of a spec
+// replays the same refs. Each kind stresses something the checked-in traces do not: skew
+// (zipf), loops longer than the cache broken by scans (scan), phase changes (shift) and
+// tenants with different patterns sharing one cache (mix).
+
+static uint64_t rng_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+void rng_seed(Rng *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        rng->s[i] = splitmix64(seed);
+        seed += 0x9E3779B97F4A7C15ull;
+    }
+}
+
+uint64_t rng_next(Rng *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Multiply-shift, the bias is under n / 2^32
+uint32_t rng_below(Rng *rng, uint32_t n)
+{
+    return (uint32_t)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+double rng_double(Rng *rng)
+{
+    return (double)(rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+// spec is uniform, zipf[:ALPHA] (default 0.99), scan[:LOOP] (default pages / 16),
+// shift[:WSS] (default pages / 16) or mix, over pages pages from 0
+int workload_init(Workload *w, const char *spec, int pages, uint64_t seed)
+{
+    static const char *kinds[] = {"uniform", "zipf", "scan", "shift", "mix"};
+    memset(w, 0, sizeof(Workload));
+    size_t len = strcspn(spec, ":");
+    double param = 0;
+    if (spec[len] == ':')
+    {
+        char *end;
+        param = strtod(spec + len + 1, &end);
+        if (end == spec + len + 1 || *end != '\0' || param <= 0)
+            return -1;
+    }
+    w->kind = -1;
+    for (int k = 0; k < (int)(sizeof(kinds) / sizeof(kinds[0])); k++)
+        if (strlen(kinds[k]) == len && strncmp(spec, kinds[k], len) == 0)
+            w->kind = k;
+    w->pages = pages > 2 ? pages : 2;
+    w->phase_refs = gen_refs / WORKLOAD_PHASES > 0 ? gen_refs / WORKLOAD_PHASES : 1;
+    rng_seed(&w->rng, seed);
+    switch (w->kind)
+    {
+    case WORKLOAD_UNIFORM:
+        return param == 0 ? 0 : -1;
+    case WORKLOAD_ZIPF:
+    {
+        w->alpha = param > 0 ? param : 0.99;
+        w->cdf = malloc(sizeof(double) * w->pages);
+        if (!w->cdf)
+            return -1;
+        double total = 0;
+        for (int r = 0; r < w->pages; r++)
+            w->cdf[r] = (total += pow(r + 1, -w->alpha));
+        for (int r = 0; r < w->pages; r++)
+            w->cdf[r] /= total;
+        return 0;
+    }
+    case WORKLOAD_SCAN:
+    case WORKLOAD_SHIFT:
+        w->span = param > 0 ? (int)param : w->pages / 16;
+        if (w->span < 1 || w->span >= w->pages)
+            return -1;
+        return 0;
+    case WORKLOAD_MIX:
+    {
+        static const char *parts[] = {"zipf", "scan", "shift", "uniform"};
+        if (param != 0)
+            return -1;
+        w->num_parts = sizeof(parts) / sizeof(parts[0]);
+        w->parts = calloc(w->num_parts, sizeof(Workload));
+        if (!w->parts)
+            return -1;
+        int share = w->pages / w->num_parts;
+        for (int i = 0; i < w->num_parts; i++)
+        {
+            if (workload_init(&w->parts[i], parts[i], share, seed + i + 1) != 0)
+            {
+                workload_free(w);
+                return -1;
+            }
+            w->parts[i].pid = i + 1;
+            w->parts[i].base = i * share; // Disjoint pages, even without --pid-aware
+        }
+        return 0;
+    }
+    }
+    return -1;
+}
+
+void workload_next(Workload *w, int *pid, int *page)
+{
+    int r = 0;
+    switch (w->kind)
+    {
+    case WORKLOAD_UNIFORM:
+        r = (int)rng_below(&w->rng, (uint32_t)w->pages);
+        break;
+    case WORKLOAD_ZIPF:
+    {
+        // Smallest rank whose cumulative probability is past u
+        double u = rng_double(&w->rng);
+        int lo = 0, hi = w->pages - 1;
+        while (lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+            if (w->cdf[mid] > u)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        r = lo;
+        break;
+    }
+    case WORKLOAD_SCAN:
+    {
+        // Four laps of the loop, then as many refs of the scan through the other pages
+        uint64_t t = w->refs % (5 * (uint64_t)w->span);
+        if (t < 4 * (uint64_t)w->span)
+            r = (int)(t % w->span);
+        else
+        {
+            r = w->span + w->cursor;
+            w->cursor = w->cursor + 1 == w->pages - w->span ? 0 : w->cursor + 1;
+        }
+        break;
+    }
+    case WORKLOAD_SHIFT:
+    {
+        int sets = w->pages / w->span;
+        r = (int)((w->refs / w->phase_refs) % sets) * w->span + (int)rng_below(&w->rng, (uint32_t)w->span);
+        break;
+    }
+    case WORKLOAD_MIX:
+        workload_next(&w->parts[rng_below(&w->rng, (uint32_t)w->num_parts)], pid, page);
+        w->refs++;
+        return;
+    }
+    *pid = w->pid;
+    *page = w->base + r;
+    w->refs++;
+}
+
+void workload_free(Workload *w)
+{
+    for (int i = 0; i < w->num_parts; i++)
+        workload_free(&w->parts[i]);
+    free(w->parts);
+    free(w->cdf);
+    w->parts = NULL;
+    w->cdf = NULL;
+    w->num_parts = 0;
+}
+
+// Replace the in-memory trace with gen_refs refs of the first workload in a comma list
+int load_workload(const char *spec)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%.*s", (int)strcspn(spec, ","), spec);
+    Workload w;
+    if (workload_init(&w, name, gen_pages, gen_seed) != 0)
+    {
+        printf("Invalid workload: %s (uniform, zipf[:ALPHA], scan[:LOOP], shift[:WSS] or mix)\n", name);
+        workload_free(&w);
+        return -1;
+    }
+    uint32_t *pages = malloc(sizeof(uint32_t) * gen_refs);
+    int *tenants = tenant_mode != TENANT_OFF ? malloc(sizeof(int) * gen_refs) : NULL;
+    if (!pages || (tenant_mode != TENANT_OFF && !tenants))
+    {
+        fprintf(stderr, "Memory allocation failed for the workload\n");
+        free(pages);
+        free(tenants);
+        workload_free(&w);
+        return -1;
+    }
+    for (int i = 0; i < gen_refs; i++)
+    {
+        int pid, page;
+        workload_next(&w, &pid, &page);
+        if (tenants)
+            tenants[i] = tenant_of(pid);
+        pages[i] = (uint32_t)ref_key(pid, page);
+    }
+    workload_free(&w);
+    free(trace_array);
+    free(trace_tenants);
+    free(next_use_index);
+    next_use_index = NULL;
+    trace_pages = trace_array = pages;
+    trace_tenants = tenants;
+    num_refs = gen_refs;
+    printf("Generated workload: %s (%d refs over %d pages, seed %llu)\n", name, gen_refs, gen_pages,
+           (unsigned long long)gen_seed);
+    return 0;
+}
+
+// Run a sweep job in a child process, so its peak RSS (in KiB) is its own
+// Falls back to running it here, with the process' peak so far, if there is no fork
+static void bench_job(Sweep_Job *job, long *peak_rss)
+{
+    int fds[2];
+    fflush(NULL);
+    pid_t child = pipe(fds) == 0 ? fork() : -1;
+    if (child == 0)
+    {
+        close(fds[0]);
+        run_sweep_job(job);
+        ssize_t written = write(fds[1], job, sizeof(Sweep_Job));
+        _exit(written == (ssize_t)sizeof(Sweep_Job) ? 0 : 1);
+    }
+    if (child > 0)
+    {
+        close(fds[1]);
+        Sweep_Job result;
+        ssize_t got = read(fds[0], &result, sizeof(Sweep_Job));
+        close(fds[0]);
+        struct rusage usage;
+        int status;
+        if (wait4(child, &status, 0, &usage) == child && got == (ssize_t)sizeof(Sweep_Job))
+        {
+            *job = result;
+            job->algo.data = NULL;
+            *peak_rss = usage.ru_maxrss;
+            return;
+        }
+    }
+    run_sweep_job(job);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *peak_rss = usage.ru_maxrss;
+}
+
+// Every selected algorithm x frame count over each workload of specs (or the trace file),
+// one job at a time so times and peak RSS are not shared
+int run_bench(const char *specs)
+{
+    int json;
+    FILE *out = open_output(bench_path, &json);
+    if (!out)
+        return 1;
+    int default_frames[3] = {num_frames / 4 > 0 ? num_frames / 4 : 1, num_frames, num_frames * 4};
+    const int *frames = sweep_frames != NULL ? sweep_frames : default_frames;
+    int num_points = sweep_frames != NULL ? num_sweep_frames : 3;
+    if (json)
+        fprintf(out, "{\"seed\": %llu, \"results\": [", (unsigned long long)gen_seed);
+    else
+        fprintf(out, "workload,algorithm,frames,refs,hits,misses,hit_ratio,ns_per_ref,peak_rss_kb\n");
+    int rows = 0;
+    for (const char *spec = specs; spec == specs || (spec != NULL && *spec != '\0');)
+    {
+        char name[64];
+        if (spec != NULL)
+        {
+            if (spec != specs && load_workload(spec) != 0)
+                break;
+            snprintf(name, sizeof(name), "%.*s", (int)strcspn(spec, ","), spec);
+        }
+        else
+            snprintf(name, sizeof(name), "%s", trace_name);
+        printf("Bench: %s\n", name);
+        for (size_t i = 0; i < num_algos; i++)
+        {
+            if (algos[i].selected != 1)
+                continue;
+            if (algos[i].algo == &OPTIMAL && next_use_index == NULL && build_next_use_index() != 0)
+                continue;
+            for (int f = 0; f < num_points; f++)
+            {
+                Sweep_Job job;
+                memset(&job, 0, sizeof(Sweep_Job));
+                job.algo = algos[i];
+                job.algo.data = NULL;
+                job.frames = frames[f];
+                long peak_rss = 0;
+                bench_job(&job, &peak_rss);
+                uint64_t refs = job.hits + job.misses;
+                double ratio = refs > 0 ? (double)job.hits / refs : 0.0;
+                double ns = refs > 0 ? latency_ns(job.exec_ticks) / refs : 0.0;
+                if (json)
+                    fprintf(out, "%s\n  {\"workload\": \"%s\", \"algorithm\": \"%s\", \"frames\": %d, \"refs\": %llu, "
+                            "\"hits\": %llu, \"misses\": %llu, \"hit_ratio\": %f, \"ns_per_ref\": %.2f, \"peak_rss_kb\": %ld}",
+                            rows > 0 ? "," : "", name, job.algo.label, job.frames, (unsigned long long)refs,
+                            (unsigned long long)job.hits, (unsigned long long)job.misses, ratio, ns, peak_rss);
+                else
+                    fprintf(out, "%s,%s,%d,%llu,%llu,%llu,%f,%.2f,%ld\n", name, job.algo.label, job.frames,
+                            (unsigned long long)refs, (unsigned long long)job.hits, (unsigned long long)job.misses,
+                            ratio, ns, peak_rss);
+                rows++;
+            }
+        }
+        if (spec == NULL)
+            break;
+        spec += strcspn(spec, ",");
+        if (*spec == ',')
+            spec++;
+    }
+    if (json)
+        fprintf(out, "\n]}\n");
+    fclose(out);
+    printf("Bench: %d results written to %s\n", rows, bench_path);
+    return 0;
+}
+
+// Results output section
+// Final stats and --interval time series for scripts, as CSV or JSON. Files are fully
+// buffered, so a row costs a formatted write into memory rather than a printf to a terminal.
+
+FILE *open_output(const char *path, int *json)
+{
+    size_t len = strlen(path);
+    *json = len > 5 && strcmp(path + len - 5, ".json") == 0;
+    FILE *out = fopen(path, "w");
+    if (!out)
+    {
+        perror(path);
+        return NULL;
+    }
+    setvbuf(out, NULL, _IOFBF, OUTPUT_BUFFER);
+    return out;
+}
+
+uint64_t eviction_count(const Algorithm_Data *data)
+{
+    uint64_t count = data->victims.count;
+    for (int i = 0; i < data->num_partitions; i++)
+        count += eviction_count(data->partitions[i]);
+    return count;
+}
+
+// One result row, pid -1 for an algorithm's total; evictions and ticks are unknown for a pid
+static void write_result(FILE *out, int json, int *rows, const char *label, int pid, int frames, uint64_t hits,
+                         uint64_t misses, uint64_t byte_hits, uint64_t byte_misses, uint64_t evictions, uint64_t ticks)
+{
+    uint64_t refs = hits + misses;
+    uint64_t bytes = byte_hits + byte_misses;
+    char pid_text[16] = "", bytes_text[32] = "", evictions_text[32] = "", time_text[32] = "", ns_text[32] = "";
+    const char *none = json ? "null" : "";
+    snprintf(pid_text, sizeof(pid_text), "%d", pid);
+    snprintf(bytes_text, sizeof(bytes_text), "%f", bytes > 0 ? (double)byte_hits / bytes : 0.0);
+    snprintf(evictions_text, sizeof(evictions_text), "%llu", (unsigned long long)evictions);
+    snprintf(time_text, sizeof(time_text), "%f", latency_ns(ticks) / 1e9);
+    snprintf(ns_text, sizeof(ns_text), "%.2f", refs > 0 ? latency_ns(ticks) / refs : 0.0);
+    if (json)
+        fprintf(out, "%s\n  {\"algorithm\": \"%s\", \"pid\": %s, \"frames\": %d, \"hits\": %llu, \"misses\": %llu, "
+                "\"hit_ratio\": %f, \"byte_hit_ratio\": %s, \"evictions\": %s, \"time_s\": %s, \"ns_per_ref\": %s}",
+                *rows > 0 ? "," : "", label, pid >= 0 ? pid_text : none, frames, (unsigned long long)hits,
+                (unsigned long long)misses,
+                refs > 0 ? (double)hits / refs : 0.0, trace_has_sizes ? bytes_text : none, pid < 0 ? evictions_text : none,
+                pid < 0 ? time_text : none, pid < 0 ? ns_text : none);
+    else
+        fprintf(out, "%s,%s,%d,%llu,%llu,%f,%s,%s,%s,%s\n", label, pid >= 0 ? pid_text : none, frames,
+                (unsigned long long)hits, (unsigned long long)misses,
+                refs > 0 ? (double)hits / refs : 0.0, trace_has_sizes ? bytes_text : none, pid < 0 ? evictions_text : none,
+                pid < 0 ? time_text : none, pid < 0 ? ns_text : none);
+    (*rows)++;
+}
+
+static FILE *open_results(int *json)
+{
+    FILE *out = open_output(output_path, json);
+    if (out == NULL)
+        return NULL;
+    if (*json)
+        fprintf(out, "{\"trace\": \"%s\", \"refs\": %d, \"results\": [", trace_name, num_refs);
+    else
+        fprintf(out, "algorithm,pid,frames,hits,misses,hit_ratio,byte_hit_ratio,evictions,time_s,ns_per_ref\n");
+    return out;
+}
+
+static int close_results(FILE *out, int json, int rows)
+{
+    if (json)
+        fprintf(out, "\n]}\n");
+    fclose(out);
+    printf("Wrote %d results to %s\n", rows, output_path);
+    return 0;
+}
+
+int write_results()
+{
+    int json, rows = 0;
+    FILE *out = output_path != NULL ? open_results(&json) : NULL;
+    if (out == NULL)
+        return output_path != NULL;
+    for (size_t i = 0; i < num_algos; i++)
+    {
+        const Algorithm_Data *data = algos[i].data;
+        if (algos[i].selected != 1)
+            continue;
+        write_result(out, json, &rows, algos[i].label, -1, data->num_frames, data->hits, data->misses, data->byte_hits,
+                     data->byte_misses, eviction_count(data), data->exec_ticks);
+        for (int t = 0; t < data->num_tenants && t < num_tenants; t++)
+            if (data->tenants[t].hits + data->tenants[t].misses > 0)
+                write_result(out, json, &rows, algos[i].label, tenant_pids[t], data->tenants[t].frames,
+                             data->tenants[t].hits, data->tenants[t].misses, 0, 0, 0, 0);
+    }
+    return close_results(out, json, rows);
+}
+
+int write_sweep_results(const Sweep_Job *jobs, int num_jobs)
+{
+    int json, rows = 0;
+    FILE *out = output_path != NULL ? open_results(&json) : NULL;
+    if (out == NULL)
+        return output_path != NULL;
+    for (int j = 0; j < num_jobs; j++)
+        write_result(out, json, &rows, jobs[j].algo.label, -1, jobs[j].frames, jobs[j].hits, jobs[j].misses,
+                     jobs[j].byte_hits, jobs[j].byte_misses, jobs[j].evictions, jobs[j].exec_ticks);
+    return close_results(out, json, rows);
+}
+
+// Write the interval that ends at algo's current ref, then start the next one
+void interval_emit(Algorithm *algo, uint64_t ticks)
+{
+    Algorithm_Data *data = algo->data;
+    uint64_t hits = data->hits - data->interval_hits;
+    uint64_t misses = data->misses - data->interval_misses;
+    uint64_t evictions = eviction_count(data);
+    double ns = hits + misses > 0 ? latency_ns(ticks - data->interval_ticks) / (hits + misses) : 0.0;
+    double total = data->hits + data->misses > 0 ? (double)data->hits / (data->hits + data->misses) : 0.0;
+    flockfile(interval_file);
+    if (interval_json)
+        fprintf(interval_file, "%s\n  {\"algorithm\": \"%s\", \"frames\": %d, \"refs\": %llu, \"hits\": %llu, \"misses\": %llu, "
+                "\"hit_ratio\": %f, \"evictions\": %llu, \"ns_per_ref\": %.2f, \"total_hit_ratio\": %f}",
+                interval_rows > 0 ? "," : "", algo->label, data->num_frames, (unsigned long long)data->position + 1,
+                (unsigned long long)hits, (unsigned long long)misses,
+                hits + misses > 0 ? (double)hits / (hits + misses) : 0.0,
+                (unsigned long long)(evictions - data->interval_evictions), ns, total);
+    else
+        fprintf(interval_file, "%s,%d,%llu,%llu,%llu,%f,%llu,%.2f,%f\n", algo->label, data->num_frames,
+                (unsigned long long)data->position + 1,
+                (unsigned long long)hits, (unsigned long long)misses, hits + misses > 0 ? (double)hits / (hits + misses) : 0.0,
+                (unsigned long long)(evictions - data->interval_evictions), ns, total);
+    interval_rows++;
+    funlockfile(interval_file);
+    data->interval_hits = data->hits;
+    data->interval_misses = data->misses;
+    data->interval_evictions = evictions;
+    data->interval_ticks = ticks;
+}
+
+// Prefetch section
+// A prefetcher watches the demand refs of one policy and inserts the pages it predicts as if
+// they were referenced, without counting them as hits or misses. The policy's evict hook keeps
+// the set of held pages, so a prediction already held is dropped and a prefetched page is
+// useful only if a demand ref hits it before it is evicted.
+
+// Parse a --prefetch spec: "seq" or "stride", optionally ":D" for the degree
+int parse_prefetch(const char *spec)
+{
+    const char *colon = strchr(spec, ':');
+    size_t len = colon != NULL ? (size_t)(colon - spec) : strlen(spec);
+    if (len == 3 && strncmp(spec, "seq", 3) == 0)
+        prefetch_kind = PREFETCH_SEQUENTIAL;
+    else if (len == 6 && strncmp(spec, "stride", 6) == 0)
+        prefetch_kind = PREFETCH_STRIDE;
+    else
+        return -1;
+    prefetch_degree = colon != NULL ? atoi(colon + 1) : 1;
+    return prefetch_degree >= 1 && prefetch_degree <= MAX_PREFETCH_DEGREE ? 0 : -1;
+}
+
+Prefetcher *prefetcher_create(int frames)
+{
+    Prefetcher *pf = calloc(1, sizeof(Prefetcher));
+    if (!pf || page_map_init(&pf->held, frames) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for prefetcher\n");
+        exit(1);
+    }
+    pf->last_page = -1;
+    return pf;
+}
+
+void prefetcher_free(Prefetcher *pf)
+{
+    if (pf == NULL)
+        return;
+    page_map_free(&pf->held);
+    free(pf);
+}
+
+// Evict hook of a policy with a prefetcher
+void prefetch_evicted(void *arg, int page)
+{
+    Prefetcher *pf = arg;
+    if (page_map_get(&pf->held, page) == NULL)
+        return;
+    page_map_remove(&pf->held, page);
+    pf->count--;
+}
+
+// Record that the policy now holds page, state is &pf->used or &pf->unused
+static void prefetch_hold(Prefetcher *pf, int page, Frame *state)
+{
+    if (page_map_get(&pf->held, page) == NULL)
+    {
+        if (page_map_reserve(&pf->held, pf->count + 1) != 0)
+            exit(1);
+        pf->count++;
+    }
+    page_map_put(&pf->held, page, state);
+}
+
+// Insert a predicted page through the policy unless it already holds it
+static void prefetch_insert(Algorithm *algo, Algorithm_Data *data, long page)
+{
+    Prefetcher *pf = data->prefetch;
+    if (page < 0 || page > INT_MAX || page_map_get(&pf->held, (int)page) != NULL)
+        return;
+    int demand = data->page_ref;
+    uint64_t hits = data->hits, misses = data->misses;
+    data->page_ref = (int)page;
+    int fault = algo->algo(data);
+    data->page_ref = demand;
+    data->hits = hits;
+    data->misses = misses;
+    pf->issued++;
+    prefetch_hold(pf, (int)page, fault ? &pf->unused : &pf->used);
+}
+
+// Page one demand ref through a policy paired with a prefetcher
+int prefetch_page(Algorithm *algo, Algorithm_Data *data)
+{
+    Prefetcher *pf = data->prefetch;
+    int page = data->page_ref;
+    int fault = algo->algo(data);
+    int trigger = fault;
+    if (!fault && page_map_get(&pf->held, page) == &pf->unused)
+    {
+        pf->useful++;
+        trigger = 1; // A prefetched page in use means the stream it predicted goes on
+    }
+    prefetch_hold(pf, page, &pf->used);
+    if (prefetch_kind == PREFETCH_SEQUENTIAL)
+    {
+        for (int d = 1; trigger && d <= prefetch_degree; d++)
+            prefetch_insert(algo, data, (long)page + d);
+    }
+    else
+    {
+        long stride = pf->last_page >= 0 ? (long)page - pf->last_page : 0;
+        pf->confirmed = stride != 0 && stride == pf->stride;
+        pf->stride = stride;
+        pf->last_page = page;
+        for (int d = 1; pf->confirmed && d <= prefetch_degree; d++)
+            prefetch_insert(algo, data, page + stride * d);
+    }
+    return fault;
+}
+
+int print_prefetch(const Prefetcher *pf)
+{
+    printf("  Prefetches: %llu, Useful: %llu, Wasted: %llu, Accuracy: %f\n", (unsigned long long)pf->issued,
+           (unsigned long long)pf->useful, (unsigned long long)(pf->issued - pf->useful),
+           pf->issued > 0 ? (double)pf->useful / (double)pf->issued : 0.0);
+    return 0;
+}
+
+// Shadow section
+// A shadow watches one policy's evictions and demand refs. Its ghosts are the policy's last
+// window evicted pages, hashed by page, so a miss on a page the policy itself evicted within
+// the last window refs is told apart from a first ref (compulsory) and from a page that was
+// evicted long ago or never fit (capacity). Reuse distances come from the trace, not the policy.
+
+// Build prev_use_index with one forward pass over trace_pages
+int build_prev_use_index()
+{
+    Page_Values last_seen;
+    prev_use_index = malloc(sizeof(int) * (num_refs > 0 ? num_refs : 1));
+    if (prev_use_index == NULL || page_values_init(&last_seen, -1) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed for previous use index\n");
+        free(prev_use_index);
+        prev_use_index = NULL;
+        return -1;
+    }
+
+    for (int i = 0; i < num_refs; ++i)
+    {
+        int64_t *last = page_values_at(&last_seen, (int)trace_pages[i]);
+        if (last == NULL)
+        {
+            page_values_free(&last_seen);
+            free(prev_use_index);
+            prev_use_index = NULL;
+            return -1;
+        }
+        prev_use_index[i] = (int)*last;
+        *last = i;
+    }
+
+    page_values_free(&last_seen);
+    return 0;
+}
+
+// Previous ref to the page referenced at the given position, -1 if none (or unknown)
+int64_t prev_use_of(int64_t position)
+{
+    if (stream_mode)
+    {
+        if (position < trace_stream.head - trace_stream.retain || position >= trace_stream.tail)
+            return -1;
+        return trace_stream.ring[position & (trace_stream.capacity - 1)].prev_use;
+    }
+    if (prev_use_index == NULL || position < 0 || position >= num_refs)
+        return -1;
+    return prev_use_index[position];
+}
+
+Miss_Shadow *miss_shadow_create(int window)
+{
+    Miss_Shadow *shadow = calloc(1, sizeof(Miss_Shadow));
+    if (!shadow || !(shadow->ghosts = malloc(sizeof(Frame) * window)) || page_map_init(&shadow->map, window) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for shadow ghosts\n");
+        exit(1);
+    }
+    for (int i = 0; i < window; ++i)
+        init_empty_frame(&shadow->ghosts[i], i);
+    shadow->window = window;
+    return shadow;
+}
+
+void miss_shadow_free(Miss_Shadow *shadow)
+{
+    if (shadow == NULL)
+        return;
+    page_map_free(&shadow->map);
+    free(shadow->ghosts);
+    free(shadow);
+}
+
+// Evict hook of a policy with a shadow, the ghost overwrites the oldest one
+void shadow_evicted(void *arg, int page)
+{
+    Miss_Shadow *shadow = arg;
+    Frame *ghost = &shadow->ghosts[shadow->evictions++ % (uint64_t)shadow->window];
+    if (ghost->page != -1 && page_map_get(&shadow->map, ghost->page) == ghost)
+        page_map_remove(&shadow->map, ghost->page);
+    ghost->page = page;
+    ghost->time = (uint64_t)shadow->now;
+    page_map_put(&shadow->map, page, ghost);
+}
+
+// Count a paged demand ref by its reuse distance, and a miss by why the page was not held
+void shadow_count(Miss_Shadow *shadow, int page, int64_t position, int fault)
+{
+    int64_t prev = prev_use_of(position);
+    if (prev >= 0)
+    {
+        int bucket = 63 - __builtin_clzll((uint64_t)(position - prev));
+        if (bucket >= REUSE_BUCKETS)
+            bucket = REUSE_BUCKETS - 1;
+        if (fault)
+            shadow->reuse_misses[bucket]++;
+        else
+            shadow->reuse_hits[bucket]++;
+    }
+    if (!fault)
+        return;
+    // A ghost stamped with this ref was evicted after the page was loaded, by a prefetch
+    Frame *ghost = page_map_get(&shadow->map, page);
+    if (ghost != NULL && ghost->time < (uint64_t)position)
+        page_map_remove(&shadow->map, page);
+    else
+        ghost = NULL;
+    if (prev < 0)
+        shadow->compulsory++;
+    else if (ghost != NULL && (uint64_t)position - ghost->time <= (uint64_t)shadow->window)
+        shadow->policy++;
+    else
+        shadow->capacity++;
+}
+
+int print_shadow(const Miss_Shadow *shadow)
+{
+    uint64_t misses = shadow->compulsory + shadow->capacity + shadow->policy;
+    double total = misses > 0 ? (double)misses : 1.0;
+    printf("  Misses: compulsory %llu (%.1f%%), capacity %llu (%.1f%%), policy %llu (%.1f%%, evicted within %d refs)\n",
+           (unsigned long long)shadow->compulsory, 100.0 * shadow->compulsory / total,
+           (unsigned long long)shadow->capacity, 100.0 * shadow->capacity / total,
+           (unsigned long long)shadow->policy, 100.0 * shadow->policy / total, shadow->window);
+    printf("  Reuse distance   %12s %12s %10s\n", "Hits", "Misses", "Miss Ratio");
+    for (int b = 0; b < REUSE_BUCKETS; b++)
+    {
+        uint64_t hits = shadow->reuse_hits[b], bucket_misses = shadow->reuse_misses[b];
+        if (hits + bucket_misses == 0)
+            continue;
+        char range[32];
+        if (b == 0)
+            snprintf(range, sizeof(range), "1");
+        else if (b == REUSE_BUCKETS - 1)
+            snprintf(range, sizeof(range), ">= %llu", 1ULL << b);
+        else
+            snprintf(range, sizeof(range), "%llu-%llu", 1ULL << b, (2ULL << b) - 1);
+        printf("  %-16s %12llu %12llu %10f\n", range, (unsigned long long)hits, (unsigned long long)bucket_misses,
+               (double)bucket_misses / (double)(hits + bucket_misses));
+    }
+    return 0;
+}
+
+// Checkpoint section
+// A checkpoint holds the trace position and, for each selected algorithm, everything its
+// Algorithm_Data and setup hook keep, so a resumed run pages exactly as the uninterrupted one
+// would. Every piece of state has one visitor that both writes and reads it, and pointers
+// between frames are written as ids into the frame pools of the Algorithm_Data being visited.
+
+void checkpoint_fail(Checkpoint *cp, const char *what)
+{
+    if (!cp->failed)
+        cp->error = what;
+    cp->failed = 1;
+}
+
+void checkpoint_bytes(Checkpoint *cp, void *bytes, size_t n)
+{
+    if (cp->failed || n == 0)
+        return;
+    size_t done = cp->loading ? fread(bytes, 1, n, cp->file) : fwrite(bytes, 1, n, cp->file);
+    if (done != n)
+        checkpoint_fail(cp, NULL);
+}
+
+void checkpoint_match(Checkpoint *cp, int64_t value, const char *what)
+{
+    int64_t saved = value;
+    CHECKPOINT(cp, saved);
+    if (cp->loading && !cp->failed && saved != value)
+        checkpoint_fail(cp, what);
+}
+
+void checkpoint_pool(Checkpoint *cp, Frame *frames, int n)
+{
+    if (cp->num_pools == cp->pool_capacity)
+    {
+        int capacity = cp->pool_capacity > 0 ? cp->pool_capacity * 2 : 16;
+        Frame **pools = realloc(cp->pools, sizeof(Frame *) * capacity);
+        int *sizes = pools ? realloc(cp->pool_sizes, sizeof(int) * capacity) : NULL;
+        if (pools)
+            cp->pools = pools;
+        if (!sizes)
+        {
+            fprintf(stderr, "Failed to allocate memory for checkpoint\n");
+            exit(1);
+        }
+        cp->pool_sizes = sizes;
+        cp->pool_capacity = capacity;
+    }
+    cp->pools[cp->num_pools] = frames;
+    cp->pool_sizes[cp->num_pools] = n;
+    cp->num_pools++;
+}
+
+void checkpoint_frame(Checkpoint *cp, Frame **framep)
+{
+    int64_t id = -1, base = 0;
+    if (!cp->loading && *framep != NULL)
+    {
+        for (int i = 0; i < cp->num_pools && id < 0; base += cp->pool_sizes[i], i++)
+        {
+            if (*framep >= cp->pools[i] && *framep < cp->pools[i] + cp->pool_sizes[i])
+                id = base + (*framep - cp->pools[i]);
+        }
+        if (id < 0)
+            checkpoint_fail(cp, "a frame outside the page table"); // a policy left a pool unregistered
+    }
+    CHECKPOINT(cp, id);
+    if (!cp->loading || cp->failed)
+        return;
+    *framep = NULL;
+    for (int i = 0; i < cp->num_pools && id >= 0; id -= cp->pool_sizes[i], i++)
+    {
+        if (id < cp->pool_sizes[i])
+            *framep = cp->pools[i] + id;
+    }
+    if (*framep == NULL && id != -1)
+        checkpoint_fail(cp, "a frame id");
+}
+
+void checkpoint_frames(Checkpoint *cp, Frame *frames, int n)
+{
+    for (int i = 0; i < n && !cp->failed; i++)
+    {
+        CHECKPOINT(cp, frames[i].index);
+        CHECKPOINT(cp, frames[i].page);
+        CHECKPOINT(cp, frames[i].time);
+        CHECKPOINT(cp, frames[i].extra);
+        CHECKPOINT(cp, frames[i].lastUsed);
+        CHECKPOINT(cp, frames[i].frequency);
+        CHECKPOINT(cp, frames[i].size);
+    }
+}
+
+void checkpoint_queue(Checkpoint *cp, struct Frame_Queue *queue, int second)
+{
+    int count = 0;
+    Frame *framep;
+    for (framep = cp->loading ? NULL : TAILQ_FIRST(queue); framep != NULL;
+         framep = second ? TAILQ_NEXT(framep, queue) : TAILQ_NEXT(framep, order))
+        count++;
+    CHECKPOINT(cp, count);
+    if (cp->loading)
+        TAILQ_INIT(queue);
+    framep = cp->loading ? NULL : TAILQ_FIRST(queue);
+    for (int i = 0; i < count && !cp->failed; i++)
+    {
+        checkpoint_frame(cp, &framep);
+        if (!cp->loading)
+            framep = second ? TAILQ_NEXT(framep, queue) : TAILQ_NEXT(framep, order);
+        else if (framep == NULL)
+            checkpoint_fail(cp, "a frame queue");
+        else if (second)
+            TAILQ_INSERT_TAIL(queue, framep, queue);
+        else
+            TAILQ_INSERT_TAIL(queue, framep, order);
+    }
+}
+
+// The slots as they are, so probe order and any later growth match the saved map
+void checkpoint_page_map(Checkpoint *cp, Page_Map *map)
+{
+    uint32_t slots = map->keys != NULL ? map->mask + 1 : 0;
+    CHECKPOINT(cp, slots);
+    if (cp->failed)
+        return;
+    if (cp->loading)
+    {
+        page_map_free(map);
+        map->mask = 0;
+        if (slots == 0)
+            return;
+        if ((slots & (slots - 1)) != 0)
+        {
+            checkpoint_fail(cp, "a page map");
+            return;
+        }
+        map->keys = malloc(sizeof(int) * slots);
+        map->values = calloc(slots, sizeof(Frame *));
+        if (!map->keys || !map->values)
+        {
+            fprintf(stderr, "Failed to allocate memory for page map\n");
+            exit(1);
+        }
+        map->mask = slots - 1;
+    }
+    checkpoint_bytes(cp, map->keys, sizeof(int) * slots);
+    for (uint32_t i = 0; i < slots && !cp->failed; i++)
+    {
+        if (map->keys[i] != -1)
+            checkpoint_frame(cp, &map->values[i]);
+    }
+}
+
+// A list of LFU buckets, as indices into the pool, with their frames if contents is set
+static void checkpoint_buckets(Checkpoint *cp, Lfu *lfu, struct Freq_Buckets *list, int contents)
+{
+    int count = 0;
+    Freq_Bucket *bucket;
+    for (bucket = cp->loading ? NULL : TAILQ_FIRST(list); bucket != NULL; bucket = TAILQ_NEXT(bucket, buckets))
+        count++;
+    CHECKPOINT(cp, count);
+    if (cp->loading)
+        TAILQ_INIT(list);
+    bucket = cp->loading ? NULL : TAILQ_FIRST(list);
+    for (int i = 0; i < count && !cp->failed; i++)
+    {
+        int index = cp->loading ? 0 : (int)(bucket - lfu->pool);
+        CHECKPOINT(cp, index);
+        if (cp->loading)
+        {
+            if (cp->failed || index < 0 || index > lfu->capacity)
+            {
+                checkpoint_fail(cp, "an LFU bucket");
+                return;
+            }
+            bucket = &lfu->pool[index];
+            TAILQ_INSERT_TAIL(list, bucket, buckets);
+        }
+        if (contents)
+        {
+            CHECKPOINT(cp, bucket->frequency);
+            checkpoint_queue(cp, &bucket->frames, 0);
+            for (Frame *framep = bucket->frames.tqh_first; cp->loading && framep != NULL; framep = framep->order.tqe_next)
+                framep->bucket = bucket;
+        }
+        bucket = TAILQ_NEXT(bucket, buckets);
+    }
+}
+
+static void checkpoint_lfu(Checkpoint *cp, Lfu *lfu)
+{
+    checkpoint_match(cp, lfu->pool != NULL, "LFU buckets");
+    if (lfu->pool == NULL)
+        return;
+    checkpoint_match(cp, lfu->capacity, "LFU frames");
+    checkpoint_page_map(cp, &lfu->map);
+    checkpoint_buckets(cp, lfu, &lfu->buckets, 1);
+    checkpoint_buckets(cp, lfu, &lfu->spare, 0);
+    checkpoint_queue(cp, &lfu->free, 0);
+    for (Frame *framep = lfu->free.tqh_first; cp->loading && framep != NULL; framep = framep->order.tqe_next)
+        framep->bucket = NULL;
+    CHECKPOINT(cp, lfu->size);
+}
+
+// Ghost frames, then the map and lists over them and the page_table frames
+static void checkpoint_ghost_cache(Checkpoint *cp, Ghost_Cache *gc)
+{
+    checkpoint_match(cp, gc->capacity, "frames");
+    checkpoint_match(cp, gc->num_ghosts, "ghost frames");
+    checkpoint_pool(cp, gc->ghosts, gc->num_ghosts);
+    checkpoint_frames(cp, gc->ghosts, gc->num_ghosts);
+    checkpoint_page_map(cp, &gc->map);
+    for (int i = 0; i < GHOST_CACHE_LISTS; i++)
+        checkpoint_queue(cp, &gc->lists[i], 0);
+    checkpoint_bytes(cp, gc->sizes, sizeof(gc->sizes));
+    checkpoint_queue(cp, &gc->free, 0);
+    checkpoint_queue(cp, &gc->spare, 0);
+    CHECKPOINT(cp, gc->resident);
+}
+
+// The live time slots only, last[] and the Fenwick tree are rebuilt from them
+static void checkpoint_stack_distance(Checkpoint *cp, Stack_Distance *sd)
+{
+    checkpoint_match(cp, sd->tree != NULL, "stack distance monitors");
+    if (sd->tree == NULL)
+        return;
+    int capacity = sd->capacity, hist_size = sd->hist_size;
+    CHECKPOINT(cp, capacity);
+    CHECKPOINT(cp, hist_size);
+    CHECKPOINT(cp, sd->now);
+    if (cp->failed)
+        return;
+    if (cp->loading)
+    {
+        if (capacity < 1 || hist_size < 1 || sd->now < 0 || sd->now > capacity)
+        {
+            checkpoint_fail(cp, "a stack distance monitor");
+            return;
+        }
+        int *tree = realloc(sd->tree, sizeof(int) * (capacity + 1));
+        if (tree)
+            sd->tree = tree;
+        int *page_at = tree ? realloc(sd->page_at, sizeof(int) * capacity) : NULL;
+        if (page_at)
+            sd->page_at = page_at;
+        uint64_t *hist = page_at ? realloc(sd->hist, sizeof(uint64_t) * hist_size) : NULL;
+        if (!hist)
+        {
+            fprintf(stderr, "Failed to allocate memory for stack distance analyzer\n");
+            exit(1);
+        }
+        sd->hist = hist;
+        sd->capacity = capacity;
+        sd->hist_size = hist_size;
+    }
+    checkpoint_bytes(cp, sd->page_at, sizeof(int) * sd->now);
+    checkpoint_bytes(cp, sd->hist, sizeof(uint64_t) * sd->hist_size);
+    CHECKPOINT(cp, sd->refs);
+    CHECKPOINT(cp, sd->cold);
+    CHECKPOINT(cp, sd->distinct);
+    if (!cp->loading || cp->failed)
+        return;
+    page_values_clear(&sd->last);
+    memset(sd->tree, 0, sizeof(int) * (sd->capacity + 1));
+    for (int t = 0; t < sd->now; t++)
+    {
+        int page = sd->page_at[t];
+        if (page == -1)
+            continue;
+        int64_t *last = page_values_at(&sd->last, page);
+        if (last == NULL)
+        {
+            checkpoint_fail(cp, "a stack distance monitor");
+            return;
+        }
+        *last = t;
+        sd->tree[t + 1] = 1;
+    }
+    // Each node adds itself into its parent once, building the tree in O(capacity)
+    for (int i = 1; i <= sd->capacity; i++)
+    {
+        int parent = i + (i & -i);
+        if (parent <= sd->capacity)
+            sd->tree[parent] += sd->tree[i];
+    }
+}
+
+// Counters, then the generic page tables, then the policy's own state and any partitions
+static void checkpoint_algo_data(Checkpoint *cp, const Algorithm *algo, Algorithm_Data *data)
+{
+    cp->num_pools = 0;
+    checkpoint_match(cp, data->num_frames, "frames");
+    checkpoint_match(cp, data->num_partitions, "partitions");
+    CHECKPOINT(cp, data->hits);
+    CHECKPOINT(cp, data->misses);
+    CHECKPOINT(cp, data->position);
+    CHECKPOINT(cp, data->rand_state);
+    CHECKPOINT(cp, data->byte_hits);
+    CHECKPOINT(cp, data->byte_misses);
+    CHECKPOINT(cp, data->interval_hits);
+    CHECKPOINT(cp, data->interval_misses);
+    CHECKPOINT(cp, data->interval_evictions);
+    CHECKPOINT(cp, data->victims.count);
+    // Ticks are only comparable within one calibration, so they travel as nanoseconds
+    uint64_t exec_ns = (uint64_t)latency_ns(data->exec_ticks), interval_ns = (uint64_t)latency_ns(data->interval_ticks);
+    CHECKPOINT(cp, exec_ns);
+    CHECKPOINT(cp, interval_ns);
+    if (cp->loading)
+    {
+        data->exec_ticks = (uint64_t)(exec_ns / latency_ns_per_tick);
+        data->interval_ticks = (uint64_t)(interval_ns / latency_ns_per_tick);
+    }
+    int tenants = data->num_tenants;
+    CHECKPOINT(cp, tenants);
+    if (cp->loading && !cp->failed && tenants != data->num_tenants)
+    {
+        Tenant_Stats *stats = tenants > 0 ? realloc(data->tenants, sizeof(Tenant_Stats) * tenants) : NULL;
+        if (tenants < 0 || (tenants > 0 && !stats))
+        {
+            checkpoint_fail(cp, "tenants");
+            return;
+        }
+        if (tenants == 0)
+            free(data->tenants);
+        data->tenants = stats;
+        data->num_tenants = tenants;
+    }
+    if (!cp->failed)
+        checkpoint_bytes(cp, data->tenants, sizeof(Tenant_Stats) * data->num_tenants);
+
+    int arena_frames = data->frame_arena != NULL ? data->num_frames : 0;
+    checkpoint_pool(cp, data->frame_arena, arena_frames);
+    checkpoint_frames(cp, data->frame_arena, arena_frames);
+    checkpoint_page_map(cp, &data->page_map);
+    checkpoint_queue(cp, &data->order, 0);
+    Frame_Arrays *arrays = &data->arrays;
+    checkpoint_match(cp, arrays->arena != NULL, "frame arrays");
+    if (arrays->arena != NULL)
+    {
+        checkpoint_match(cp, arrays->size, "frames");
+        if (!cp->failed)
+        {
+            checkpoint_bytes(cp, arrays->page, sizeof(int) * arrays->size);
+            checkpoint_bytes(cp, arrays->meta, sizeof(uint32_t) * arrays->size);
+        }
+        CHECKPOINT(cp, arrays->used);
+        CHECKPOINT(cp, arrays->hand);
+        CHECKPOINT(cp, arrays->base);
+    }
+    checkpoint_lfu(cp, &data->lfu);
+    Prefetcher *pf = data->prefetch;
+    checkpoint_match(cp, pf != NULL, "--prefetch");
+    if (pf != NULL)
+    {
+        checkpoint_pool(cp, &pf->used, 1);
+        checkpoint_pool(cp, &pf->unused, 1);
+        checkpoint_page_map(cp, &pf->held);
+        CHECKPOINT(cp, pf->count);
+        CHECKPOINT(cp, pf->last_page);
+        CHECKPOINT(cp, pf->stride);
+        CHECKPOINT(cp, pf->confirmed);
+        CHECKPOINT(cp, pf->issued);
+        CHECKPOINT(cp, pf->useful);
+    }
+    Miss_Shadow *shadow = data->shadow;
+    checkpoint_match(cp, shadow != NULL, "--shadow");
+    if (shadow != NULL)
+    {
+        checkpoint_match(cp, shadow->window, "--shadow");
+        checkpoint_pool(cp, shadow->ghosts, shadow->window);
+        checkpoint_frames(cp, shadow->ghosts, shadow->window);
+        checkpoint_page_map(cp, &shadow->map);
+        CHECKPOINT(cp, shadow->evictions);
+        CHECKPOINT(cp, shadow->now);
+        CHECKPOINT(cp, shadow->compulsory);
+        CHECKPOINT(cp, shadow->capacity);
+        CHECKPOINT(cp, shadow->policy);
+        CHECKPOINT(cp, shadow->reuse_hits);
+        CHECKPOINT(cp, shadow->reuse_misses);
+    }
+    checkpoint_match(cp, data->extra != NULL, "algorithm state");
+    if (data->extra != NULL && !cp->failed)
+    {
+        if (algo->checkpoint == NULL)
+            checkpoint_fail(cp, "algorithm state"); // setup attached state no hook saves
+        else
+            algo->checkpoint(cp, data);
+    }
+    for (int i = 0; i < data->num_partitions && !cp->failed; i++)
+        checkpoint_algo_data(cp, algo, data->partitions[i]);
+}
+
+// Trace the checkpoint was taken on, so it is not resumed on another, or from another position
+static uint64_t trace_fingerprint()
+{
+    if (stream_mode)
+    {
+        struct stat st;
+        return stat(trace_name, &st) == 0 ? (uint64_t)st.st_size : 0;
+    }
+    uint64_t h = splitmix64((uint64_t)num_refs);
+    for (int i = 0; i < num_refs; i++)
+        h = splitmix64(h ^ trace_pages[i]);
+    return h;
+}
+
+// Header: format, trace and the options that shape the page tables, then the trace position
+static void checkpoint_header(Checkpoint *cp, int64_t *offset, uint64_t *ticks)
+{
+    char magic[8];
+    memcpy(magic, CHECKPOINT_MAGIC, sizeof(magic));
+    CHECKPOINT(cp, magic);
+    if (cp->loading && !cp->failed && memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0)
+        checkpoint_fail(cp, "the file format");
+    checkpoint_match(cp, CHECKPOINT_VERSION, "the checkpoint version");
+    uint32_t length = (uint32_t)strlen(trace_name);
+    char name[PATH_MAX];
+    CHECKPOINT(cp, length);
+    if (cp->failed || length >= sizeof(name))
+    {
+        checkpoint_fail(cp, "the trace file");
+        return;
+    }
+    memcpy(name, trace_name, cp->loading ? 0 : length);
+    checkpoint_bytes(cp, name, length);
+    name[length] = '\0';
+    uint64_t fingerprint = trace_fingerprint();
+    CHECKPOINT(cp, fingerprint);
+    // A warm start may replay another trace on the saved caches
+    if (cp->loading && !warm_start && !cp->failed && (strcmp(name, trace_name) != 0 || fingerprint != trace_fingerprint()))
+        checkpoint_fail(cp, "the trace file");
+    checkpoint_match(cp, stream_mode, "--stream");
+    checkpoint_match(cp, scaled_frames(num_frames), "num_frames");
+    checkpoint_match(cp, assoc_ways, "--assoc");
+    checkpoint_match(cp, set_index_mode, "--set-index");
+    checkpoint_match(cp, line_shift, "--line-size");
+    checkpoint_match(cp, tenant_mode, "--tenants");
+    checkpoint_match(cp, pid_aware, "--pid-aware");
+    checkpoint_match(cp, frame_bytes, "--frame-bytes");
+    checkpoint_match(cp, prefetch_kind, "--prefetch");
+    checkpoint_match(cp, prefetch_degree, "--prefetch");
+    CHECKPOINT(cp, *offset);
+    CHECKPOINT(cp, *ticks);
+}
+
+// Replace path with the selected algorithms' state at counter, through a temporary file
+int write_checkpoint(const char *path)
+{
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    Checkpoint cp = {0};
+    if (!(cp.file = fopen(tmp, "wb")))
+    {
+        perror("Error opening checkpoint");
+        return -1;
+    }
+    setvbuf(cp.file, NULL, _IOFBF, OUTPUT_BUFFER);
+    int64_t offset = counter;
+    uint64_t ticks = tick_base;
+    checkpoint_header(&cp, &offset, &ticks);
+    for (size_t i = 0; i < num_algos && !cp.failed; i++)
+    {
+        if (algos[i].selected != 1)
+            continue;
+        // Label, then the section length so a run without the algorithm can skip it
+        uint32_t length = (uint32_t)strlen(algos[i].label);
+        uint64_t bytes = 0;
+        CHECKPOINT(&cp, length);
+        checkpoint_bytes(&cp, (void *)algos[i].label, length);
+        long start = ftell(cp.file);
+        CHECKPOINT(&cp, bytes);
+        checkpoint_algo_data(&cp, &algos[i], algos[i].data);
+        long end = ftell(cp.file);
+        bytes = (uint64_t)(end - start) - sizeof(bytes);
+        if (start < 0 || end < 0 || fseek(cp.file, start, SEEK_SET) != 0)
+            checkpoint_fail(&cp, NULL);
+        CHECKPOINT(&cp, bytes);
+        if (fseek(cp.file, end, SEEK_SET) != 0)
+            checkpoint_fail(&cp, NULL);
+    }
+    uint32_t last = 0;
+    CHECKPOINT(&cp, last);
+    free(cp.pools);
+    free(cp.pool_sizes);
+    if (fclose(cp.file) != 0 || cp.failed)
+    {
+        printf("Failed to write checkpoint %s%s%s\n", path, cp.error ? ": " : "", cp.error ? cp.error : "");
+        remove(tmp);
+        return -1;
+    }
+    if (rename(tmp, path) != 0)
+    {
+        perror("Error replacing checkpoint");
+        return -1;
+    }
+    if (debug)
+        printf("Checkpoint %s at ref %llu\n", path, (unsigned long long)counter);
+    return 0;
+}
+
+// Zero what a warm start counts, the caches themselves are kept
+static void checkpoint_warm(Algorithm_Data *data)
+{
+    data->hits = data->misses = 0;
+    data->byte_hits = data->byte_misses = 0;
+    data->interval_hits = data->interval_misses = 0;
+    data->interval_evictions = data->victims.count = 0;
+    data->exec_ticks = data->interval_ticks = 0;
+    for (int t = 0; t < data->num_tenants; t++)
+        data->tenants[t].hits = data->tenants[t].misses = 0;
+    if (data->prefetch != NULL)
+        data->prefetch->issued = data->prefetch->useful = 0;
+    free(data->latency);
+    data->latency = NULL;
+    for (int i = 0; i < data->num_partitions; i++)
+        checkpoint_warm(data->partitions[i]);
+}
+
+// Load path into the selected algorithms and set counter to where it was taken (0 with --warm)
+int read_checkpoint(const char *path)
+{
+    Checkpoint cp = {0};
+    cp.loading = 1;
+    if (!(cp.file = fopen(path, "rb")))
+    {
+        perror("Error opening checkpoint");
+        return -1;
+    }
+    setvbuf(cp.file, NULL, _IOFBF, OUTPUT_BUFFER);
+    int64_t offset = 0;
+    uint64_t ticks = 0;
+    char *restored = calloc(num_algos, 1);
+    if (!restored)
+        exit(1);
+    checkpoint_header(&cp, &offset, &ticks);
+    while (!cp.failed)
+    {
+        uint32_t length = 0;
+        uint64_t bytes = 0;
+        char label[64];
+        CHECKPOINT(&cp, length);
+        if (cp.failed || length == 0)
+            break;
+        if (length >= sizeof(label))
+        {
+            checkpoint_fail(&cp, "an algorithm label");
+            break;
+        }
+        checkpoint_bytes(&cp, label, length);
+        label[length] = '\0';
+        CHECKPOINT(&cp, bytes);
+        size_t i;
+        for (i = 0; i < num_algos; i++)
+        {
+            if (algos[i].selected == 1 && strcmp(algos[i].label, label) == 0)
+                break;
+        }
+        // The offline policies know the saved trace's future, not the one a warm start replays
+        if (i == num_algos || (warm_start && (algos[i].flags & ALGO_OFFLINE)))
+        {
+            if (!cp.failed && fseeko(cp.file, (off_t)bytes, SEEK_CUR) != 0)
+                checkpoint_fail(&cp, NULL);
+            continue;
+        }
+        checkpoint_algo_data(&cp, &algos[i], algos[i].data);
+        restored[i] = 1;
+    }
+    for (size_t i = 0; i < num_algos && !cp.failed; i++)
+    {
+        if (algos[i].selected != 1 || restored[i])
+            continue;
+        if (warm_start && (algos[i].flags & ALGO_OFFLINE))
+            printf("%s starts cold, a warm start only keeps the online policies\n", algos[i].label);
+        else
+            checkpoint_fail(&cp, algos[i].label);
+    }
+    free(restored);
+    free(cp.pools);
+    free(cp.pool_sizes);
+    fclose(cp.file);
+    if (cp.failed)
+    {
+        if (cp.error != NULL)
+            printf("Checkpoint %s does not match this run: %s\n", path, cp.error);
+        else
+            printf("Checkpoint %s is truncated or unreadable\n", path);
+        return -1;
+    }
+    if (warm_start)
+    {
+        for (size_t i = 0; i < num_algos; i++)
+        {
+            if (algos[i].selected == 1 && !(algos[i].flags & ALGO_OFFLINE))
+                checkpoint_warm(algos[i].data);
+        }
+        tick_base = ticks + (uint64_t)offset;
+        counter = 0;
+        printf("Warm start from %s, taken at ref %llu\n", path, (unsigned long long)offset);
+    }
+    else
+    {
+        tick_base = ticks;
+        counter = offset;
+        printf("Resuming from %s at ref %llu\n", path, (unsigned long long)offset);
+    }
+    return 0;
+}
+
+// Refs until the next periodic checkpoint or --checkpoint-at, so blocks end on one
+int checkpoint_refs_left()
+{
+    int64_t refs = INT_MAX;
+    if (checkpoint_every > 0 && checkpoint_every - counter % checkpoint_every < refs)
+        refs = checkpoint_every - counter % checkpoint_every;
+    if (checkpoint_at > 0 && checkpoint_at - counter < refs)
+        refs = checkpoint_at - counter;
+    return refs > 0 ? (int)refs : 0;
+}
+
+// Latency section
+// Refs are timed with the TSC where there is one, two reads per ref cost a few ns where a
+// clock() call costs a syscall-sized fraction of a microsecond. Totals time each block, or each
+// ref when refs are paged one at a time. The hit/miss histograms are only kept with --latency,
+// and count every ref of a ref-at-a-time run and one in latency_sample otherwise.
+
+static uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t latency_now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return monotonic_ns();
+#endif
+}
+
+// Time the TSC against CLOCK_MONOTONIC, and the cost of reading it
+void latency_init()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t start_ns = monotonic_ns(), start = latency_now(), now_ns;
+    while ((now_ns = monotonic_ns()) - start_ns < LATENCY_CALIBRATION_NS)
+        ;
+    uint64_t ticks = latency_now() - start;
+    if (ticks > 0)
+        latency_ns_per_tick = (double)(now_ns - start_ns) / (double)ticks;
+#endif
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; i++)
+    {
+        uint64_t start = latency_now();
+        uint64_t ticks = latency_now() - start;
+        if (ticks < best)
+            best = ticks;
+    }
+    latency_overhead = best;
+}
+
+double latency_ns(uint64_t ticks)
+{
+    return (double)ticks * latency_ns_per_tick;
+}
+
+uint64_t latency_net(uint64_t start)
+{
+    uint64_t ticks = latency_now() - start;
+    return ticks > latency_overhead ? ticks - latency_overhead : 0;
+}
+
+// Bucket of a value: exact below 1 << LATENCY_SUB_BITS, then LATENCY_SUB_BITS bits past the top one
+static int latencyBucket(uint64_t value)
+{
+    if (value < (1u << LATENCY_SUB_BITS))
+        return (int)value;
+    int top = 63 - __builtin_clzll(value);
+    return ((top - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) |
+           (int)((value >> (top - LATENCY_SUB_BITS)) & ((1u << LATENCY_SUB_BITS) - 1));
+}
+
+// Largest value in a bucket
+static uint64_t latencyBucketMax(int bucket)
+{
+    if (bucket < (1 << LATENCY_SUB_BITS))
+        return (uint64_t)bucket;
+    int shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)((1 << LATENCY_SUB_BITS) | (bucket & ((1 << LATENCY_SUB_BITS) - 1))) << shift;
+    return low + ((1ull << shift) - 1);
+}
+
+void latency_record(Algorithm_Data *data, int fault, uint64_t ticks)
+{
+    if (data->latency == NULL)
+    {
+        data->latency = calloc(2, sizeof(Latency_Histogram));
+        if (!data->latency)
+            return;
+    }
+    Latency_Histogram *hist = &data->latency[fault ? 1 : 0];
+    hist->counts[latencyBucket(ticks)]++;
+    hist->count++;
+    hist->total += ticks;
+    if (ticks > hist->max)
+        hist->max = ticks;
+}
+
+uint64_t latency_percentile(const Latency_Histogram *hist, double q)
+{
+    uint64_t rank = (uint64_t)(q * (double)hist->count + 0.5), seen = 0;
+    if (rank < 1)
+        rank = 1;
+    for (int b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += hist->counts[b];
+        if (seen >= rank)
+        {
+            uint64_t value = latencyBucketMax(b);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+int print_latency(const Algorithm_Data *data)
+{
+    uint64_t refs = data->hits + data->misses;
+    printf("  Latency: %.1f ns/ref", refs > 0 ? latency_ns(data->exec_ticks) / (double)refs : 0.0);
+    for (int fault = 0; fault < 2 && data->latency != NULL; fault++)
+    {
+        const Latency_Histogram *hist = &data->latency[fault];
+        if (hist->count == 0)
+            continue;
+        printf(", %s: %.1f ns mean, p50 %.0f, p99 %.0f, p999 %.0f, max %.0f ns", fault ? "Miss" : "Hit",
+               latency_ns(hist->total) / (double)hist->count, latency_ns(latency_percentile(hist, 0.5)),
+               latency_ns(latency_percentile(hist, 0.99)), latency_ns(latency_percentile(hist, 0.999)),
+               latency_ns(hist->max));
+    }
+    if (data->latency != NULL)
+        printf(" (%llu refs timed)", (unsigned long long)(data->latency[0].count + data->latency[1].count));
+    printf("\n");
+    return 0;
+}
+
+// page all selected algorithms with input ref
+// int page(int page_ref)
+// {
+//     last_page_ref = page_ref;
+//     size_t i = 0;
+//     for (i = 0; i < num_algos; i++)
+//     {
+//         if (algos[i].selected == 1)
+//         {
+//             algos[i].algo(algos[i].data);
+//             if (printrefs == 1)
+//             {
+//                 print_stats(algos[i]);
+//             }
+//         }
+//     }
+
+//     return 0;
+// }
+
+int page(int page_ref) {
+    size_t i = 0;
+    
+    for (i = 0; i < num_algos; i++) {
+        if (algos[i].selected == 1) {
+            algos[i].data->page_ref = page_ref;
+            algos[i].data->position = counter;
+            uint64_t start = latency_now();
+            int fault = page_data(&algos[i], algos[i].data);
+            uint64_t ticks = latency_net(start);
+            
             // Accumulate the execution time
-            algos[i].data->exec_time += (end_time - start_time);
+            algos[i].data->exec_ticks += ticks;
+            if (latency_report)
+                latency_record(algos[i].data, fault, ticks);
+            if (interval_refs > 0 && (counter + 1) % interval_refs == 0)
+                interval_emit(&algos[i], algos[i].data->exec_ticks);
             
             if (printrefs == 1) {
                 print_stats(algos[i]);
             }
         }
     }
-    return 0;
+    return 0;
+}
+
+
+
+
+// Take a frame from the newest pool block, starting a block when it is full
+static Frame *victim_pool_take(Victim_History *history)
+{
+    if (history->blocks == NULL || history->used == VICTIM_POOL_BLOCK)
+    {
+        Frame_Block *block = malloc(sizeof(Frame_Block));
+        if (!block)
+            return NULL;
+        block->next = history->blocks;
+        history->blocks = block;
+        history->used = 0;
+    }
+    return &history->blocks->frames[history->used++];
+}
+
+// Record a frame evicted from the page table in data's victim history
+// Ring slots are allocated up front and pool frames a block at a time, never per eviction
+int add_victim(Algorithm_Data *data, struct Frame *frame)
+{
+    if (debug)
+        printf("Victim index: %d, Page: %d\n", frame->index, frame->page);
+    if (data->evict_hook != NULL)
+        data->evict_hook(data->evict_arg, frame->page);
+    if (data->shadow != NULL)
+        shadow_evicted(data->shadow, frame->page);
+    Victim_History *history = &data->victims;
+    struct Frame *victim = NULL;
+    if (history->mode == VICTIM_HISTORY_RING && history->ring != NULL)
+        victim = &history->ring[history->count % history->capacity];
+    else if (history->mode == VICTIM_HISTORY_POOL)
+        victim = victim_pool_take(history);
+    history->count++;
+    if (victim == NULL)
+        return 0;
+    *victim = *frame;
+    victim->index = 1;
+    if (history->mode == VICTIM_HISTORY_POOL)
+        LIST_INSERT_HEAD(&data->victim_list, victim, frames);
+    data->last_victim = victim;
+    return 0;
+}
+
+// Record the page evicted from frame index of a struct-of-arrays page table
+int add_victim_page(Algorithm_Data *data, int index, int page)
+{
+    Frame victim;
+    init_empty_frame(&victim, index);
+    victim.page = page;
+    return add_victim(data, &victim);
+}
+
+// Parse a --victims spec: "off", "ring" or "ring:N", "pool"
+int parse_victim_mode(const char *spec)
+{
+    if (strcmp(spec, "off") == 0)
+        victim_mode = VICTIM_HISTORY_OFF;
+    else if (strcmp(spec, "pool") == 0)
+        victim_mode = VICTIM_HISTORY_POOL;
+    else if (strncmp(spec, "ring", 4) == 0 && (spec[4] == '\0' || spec[4] == ':'))
+    {
+        victim_mode = VICTIM_HISTORY_RING;
+        if (spec[4] == ':')
+            victim_capacity = atoi(spec + 5);
+        if (victim_capacity < 1)
+            return -1;
+    }
+    else
+        return -1;
+    return 0;
+}
+
+// Build next_use_index with one backward pass over trace_pages
+// trace_pages is in the order get_ref() hands refs out, so position i is the ref seen at counter == i
+int build_next_use_index()
+{
+    Page_Values last_seen;
+    next_use_index = malloc(sizeof(int) * (num_refs > 0 ? num_refs : 1));
+    if (next_use_index == NULL || page_values_init(&last_seen, INT_MAX) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed for next use index\n");
+        free(next_use_index);
+        next_use_index = NULL;
+        return -1;
+    }
+
+    for (int i = num_refs - 1; i >= 0; --i)
+    {
+        int64_t *last = page_values_at(&last_seen, (int)trace_pages[i]);
+        if (last == NULL)
+        {
+            page_values_free(&last_seen);
+            free(next_use_index);
+            next_use_index = NULL;
+            return -1;
+        }
+        next_use_index[i] = (int)*last;
+        *last = i;
+    }
+
+    page_values_free(&last_seen);
+    return 0;
+}
+
+// Next use of the page referenced at the given position, INT64_MAX if never (or unknown)
+// With a lookahead window, uses further away than the window are unknown
+int64_t next_use_of(int64_t position, int window)
+{
+    int64_t next;
+    if (stream_mode)
+    {
+        if (position < trace_stream.head - trace_stream.retain || position >= trace_stream.tail)
+            return INT64_MAX;
+        next = trace_stream.ring[position & (trace_stream.capacity - 1)].next_use;
+    }
+    else
+    {
+        if (next_use_index == NULL || position < 0 || position >= num_refs || next_use_index[position] == INT_MAX)
+            return INT64_MAX;
+        next = next_use_index[position];
+    }
+    if (window > 0 && next != INT64_MAX && next - position > window)
+        return INT64_MAX;
+    return next;
+}
+
+// Swap two heap entries and keep heap_pos in sync
+void optimalHeapSwap(OPTIMAL_Data *opt, int a, int b)
+{
+    int tmp = opt->heap[a];
+    opt->heap[a] = opt->heap[b];
+    opt->heap[b] = tmp;
+    opt->heap_pos[opt->heap[a]] = a;
+    opt->heap_pos[opt->heap[b]] = b;
+}
+
+// Restore the max-heap property around heap position pos after its key changed
+void optimalHeapFix(OPTIMAL_Data *opt, int pos)
+{
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (opt->next_use[opt->heap[parent]] >= opt->next_use[opt->heap[pos]])
+            break;
+        optimalHeapSwap(opt, parent, pos);
+        pos = parent;
+    }
+    for (;;)
+    {
+        int left = 2 * pos + 1, right = left + 1, largest = pos;
+        if (left < opt->size && opt->next_use[opt->heap[left]] > opt->next_use[opt->heap[largest]])
+            largest = left;
+        if (right < opt->size && opt->next_use[opt->heap[right]] > opt->next_use[opt->heap[largest]])
+            largest = right;
+        if (largest == pos)
+            break;
+        optimalHeapSwap(opt, pos, largest);
+        pos = largest;
+    }
+}
+
+// Setup hook for OPTIMAL, builds the next use index and an empty heap
+void initializeOptimal(Algorithm_Data *data)
+{
+    if (!stream_mode && next_use_index == NULL && build_next_use_index() != 0)
+        return;
+
+    OPTIMAL_Data *opt = malloc(sizeof(OPTIMAL_Data));
+    if (!opt)
+    {
+        fprintf(stderr, "Failed to allocate memory for OPTIMAL data\n");
+        return;
+    }
+    opt->slots = malloc(sizeof(Frame *) * data->num_frames);
+    opt->heap = malloc(sizeof(int) * data->num_frames);
+    opt->heap_pos = malloc(sizeof(int) * data->num_frames);
+    opt->next_use = malloc(sizeof(int64_t) * data->num_frames);
+    if (!opt->slots || !opt->heap || !opt->heap_pos || !opt->next_use || page_map_init(&data->page_map, data->num_frames) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for OPTIMAL heap\n");
+        free(opt->slots);
+        free(opt->heap);
+        free(opt->heap_pos);
+        free(opt->next_use);
+        free(opt);
+        return;
+    }
+    opt->size = 0;
+    opt->window = stream_mode ? lookahead_window : 0;
+    int i = 0;
+    for (Frame *framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
+    {
+        opt->slots[i] = framep;
+        opt->heap_pos[i] = -1;
+        opt->next_use[i] = INT64_MAX;
+        ++i;
+    }
+
+    data->extra = opt;
+    data->free_extra = &freeOptimal;
+}
+
+// Setup hook for OPTIMAL-W, OPTIMAL limited to the next lookahead_window refs
+void initializeOptimalWindow(Algorithm_Data *data)
+{
+    initializeOptimal(data);
+    if (data->extra != NULL)
+        ((OPTIMAL_Data *)data->extra)->window = lookahead_window;
+}
+
+// Frees the heap attached by initializeOptimal
+void freeOptimal(void *extra)
+{
+    OPTIMAL_Data *opt = extra;
+    if (!opt)
+        return;
+    free(opt->slots);
+    free(opt->heap);
+    free(opt->heap_pos);
+    free(opt->next_use);
+    free(opt);
+}
+
+// Checkpoint hook for OPTIMAL and OPTIMAL-W, the page map is the generic one
+void checkpointOptimal(Checkpoint *cp, Algorithm_Data *data)
+{
+    OPTIMAL_Data *opt = data->extra;
+    checkpoint_match(cp, opt->window, "--window");
+    CHECKPOINT(cp, opt->size);
+    checkpoint_bytes(cp, opt->heap, sizeof(int) * data->num_frames);
+    checkpoint_bytes(cp, opt->heap_pos, sizeof(int) * data->num_frames);
+    checkpoint_bytes(cp, opt->next_use, sizeof(int64_t) * data->num_frames);
+}
+
+// OPTIMAL Page Replacement Algorithm
+// Resident frames sit in a max-heap keyed by the next use of their page, so the
+// victim (the page used farthest in the future) is always at the root. OPTIMAL-W runs
+// the same heap with next uses past its window unknown, an online policy's best case
+// with that much lookahead.
+int OPTIMAL(Algorithm_Data *data)
+{
+    OPTIMAL_Data *opt = (OPTIMAL_Data *)data->extra;
+    Frame *framep = page_map_get(&data->page_map, data->page_ref);
+    int idx = framep != NULL ? framep->index : -1; // frames are indexed by their slot
+    int fault = 0;
+
+    if (opt->window > 0)
+    { // A resident page whose next use was past the window comes into view at data->position + window
+        int64_t ahead = data->position + opt->window;
+        int seen = stream_mode ? trace_stream_peek(&trace_stream, ahead) : ahead < num_refs ? (int)trace_pages[ahead] : -1;
+        Frame *seen_frame = seen >= 0 ? page_map_get(&data->page_map, seen) : NULL;
+        if (seen_frame != NULL && opt->next_use[seen_frame->index] == INT64_MAX)
+        {
+            opt->next_use[seen_frame->index] = ahead;
+            optimalHeapFix(opt, opt->heap_pos[seen_frame->index]);
+        }
+    }
+
+    if (idx != -1)
+        ; // The page was found! Hit!
+    else if (opt->size < data->num_frames)
+    { // Use free page table index
+        idx = opt->size;
+        framep = opt->slots[idx];
+        opt->heap[opt->size] = idx;
+        opt->heap_pos[idx] = opt->size;
+        opt->size++;
+        fault = 1;
+    }
+    else
+    { // It's a miss, evict the page used farthest in the future
+        idx = opt->heap[0];
+        framep = opt->slots[idx];
+        if (debug)
+            printf("Victim selected: %d, Page: %d\n", framep->index, framep->page);
+        add_victim(data, framep);
+        page_map_remove(&data->page_map, framep->page);
+        fault = 1;
+    }
+
+    if (fault == 1)
+        page_map_put(&data->page_map, data->page_ref, framep);
+    framep->page = data->page_ref;
+    framep->time = current_tick(data);
+    framep->extra = (int)data->position;
+    opt->next_use[idx] = next_use_of(data->position, opt->window);
+    optimalHeapFix(opt, opt->heap_pos[idx]);
+
+    if (debug)
+    {
+        printf("Page Ref: %d\n", data->page_ref);
+        for (framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
+            printf("Slot: %d, Page: %d, Time used: %d\n", framep->index, framep->page, framep->extra);
+    }
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+
+    return fault;
+}
+
+// RANDOM Page Replacement Algorithm
+static inline int randomStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int rand_victim = rand_r(&data->rand_state) % size;
+    int fault = 0;
+    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
+    int i = frameFind(arrays, size, data->page_ref);
+    if (i < 0 && arrays->used < size)
+    { // Use free page table index
+        i = arrays->used++;
+        arrays->page[i] = data->page_ref;
+        fault = 1;
+    }
+    else if (i < 0)
+    { // It's a miss, kill our victim
+        i = rand_victim;
+        if (debug)
+            printf("Victim selected: %d, Page: %d\n", i, arrays->page[i]);
+        add_victim_page(data, i, arrays->page[i]);
+        arrays->page[i] = data->page_ref;
+        fault = 1;
+    }
+    arrays->meta[i] = (uint32_t)data->position; // The page was found or loaded, stamp it
+    if (debug)
+    {
+        printf("Page Ref: %d\n", data->page_ref);
+        for (i = 0; i < size; i++)
+            printf("Slot: %d, Page: %d, Time used: %u\n", i, arrays->page[i], arrays->meta[i]);
+    }
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+int RANDOM(Algorithm_Data *data)
+{
+    return randomStep(data, data->arrays.size);
+}
+
+// Setup hook for LRU, FIFO and MRU
+// All frames are queued up front, so free frames sit at the head and are used before any eviction
+void initializeRecency(Algorithm_Data *data)
+{
+    if (page_map_init(&data->page_map, data->num_frames) != 0)
+        return;
+    for (Frame *framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
+        TAILQ_INSERT_TAIL(&data->order, framep, order);
+}
+
+// Load data->page_ref into a frame on a miss, evicting its page if it had one
+void recency_load(Algorithm_Data *data, Frame *framep)
+{
+    if (framep->page != -1)
+    {
+        if (debug)
+            printf("Victim selected: %d, Page: %d\n", framep->index, framep->page);
+        add_victim(data, framep);
+        page_map_remove(&data->page_map, framep->page);
+    }
+    framep->page = data->page_ref;
+    page_map_put(&data->page_map, data->page_ref, framep);
+}
+
+// Move a frame to the tail (most recent end) of the order queue
+void recency_touch(Algorithm_Data *data, Frame *framep)
+{
+    TAILQ_REMOVE(&data->order, framep, order);
+    TAILQ_INSERT_TAIL(&data->order, framep, order);
+}
+
+// FIFO Page Replacement Algorithm
+int FIFO(Algorithm_Data *data)
+{
+    Frame *framep = page_map_get(&data->page_map, data->page_ref);
+    int fault = 0;
+    if (framep == NULL)
+    { // It's a miss, the oldest frame (or a free one) is at the head
+        framep = data->order.tqh_first;
+        recency_load(data, framep);
+        recency_touch(data, framep);
+        fault = 1;
+    }
+    // On a hit the page keeps its place in the queue
+    framep->time = current_tick(data);
+    framep->extra = (int)data->position;
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+// LRU Page Replacement Algorithm
+int LRU(Algorithm_Data *data)
+{
+    Frame *framep = page_map_get(&data->page_map, data->page_ref);
+    int fault = 0;
+    if (framep == NULL)
+    { // It's a miss, the least recently used frame (or a free one) is at the head
+        framep = data->order.tqh_first;
+        recency_load(data, framep);
+        fault = 1;
+    }
+    recency_touch(data, framep);
+    framep->time = current_tick(data);
+    framep->extra = (int)data->position;
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+// LRU stack distance section
+// LRU has the inclusion property: a ref hits in every cache at least as large as its stack
+// distance (distinct pages touched since the page was last used, itself included). A Fenwick
+// tree over time slots holds a 1 at each page's last access, so the distance is a range count.
+
+// Set up an analyzer with room for capacity time slots (it compacts itself when they run out)
+int stack_distance_init(Stack_Distance *sd, int capacity)
+{
+    memset(sd, 0, sizeof(Stack_Distance));
+    sd->capacity = capacity > 0 ? capacity : 1;
+    sd->tree = calloc(sd->capacity + 1, sizeof(int));
+    sd->page_at = malloc(sizeof(int) * sd->capacity);
+    sd->hist_size = 64;
+    sd->hist = calloc(sd->hist_size, sizeof(uint64_t));
+    if (!sd->tree || !sd->page_at || !sd->hist || page_values_init(&sd->last, -1) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for stack distance analyzer\n");
+        stack_distance_free(sd);
+        return -1;
+    }
+    return 0;
+}
+
+// Add delta at time slot t
+static void fenwick_add(Stack_Distance *sd, int t, int delta)
+{
+    for (int i = t + 1; i <= sd->capacity; i += i & -i)
+        sd->tree[i] += delta;
+}
+
+// Sum of time slots 0..t
+static int fenwick_sum(Stack_Distance *sd, int t)
+{
+    int sum = 0;
+    for (int i = t + 1; i > 0; i -= i & -i)
+        sum += sd->tree[i];
+    return sum;
+}
+
+// Renumber live last accesses to 0..distinct-1, growing the tree if it is over half full
+static int stack_distance_compact(Stack_Distance *sd)
+{
+    if (sd->distinct * 2 > (uint64_t)sd->capacity) // capacity is never negative
+    {
+        int capacity = sd->capacity * 2;
+        int *tree = realloc(sd->tree, sizeof(int) * (capacity + 1));
+        if (tree)
+            sd->tree = tree;
+        int *page_at = tree ? realloc(sd->page_at, sizeof(int) * capacity) : NULL;
+        if (!tree || !page_at)
+        {
+            fprintf(stderr, "Failed to grow stack distance analyzer\n");
+            return -1;
+        }
+        sd->page_at = page_at;
+        sd->capacity = capacity;
+    }
+    int live = 0;
+    for (int t = 0; t < sd->now; t++)
+    {
+        int page = sd->page_at[t];
+        if (page == -1)
+            continue;
+        sd->page_at[live] = page;
+        *page_values_at(&sd->last, page) = live;
+        live++;
+    }
+    // Rebuild as all ones over 0..live-1 in O(capacity)
+    memset(sd->tree, 0, sizeof(int) * (sd->capacity + 1));
+    for (int i = 1; i <= sd->capacity; i++)
+    {
+        if (i <= live)
+            sd->tree[i] += 1;
+        int parent = i + (i & -i);
+        if (parent <= sd->capacity)
+            sd->tree[parent] += sd->tree[i];
+    }
+    sd->now = live;
+    return 0;
+}
+
+// Record an access to page, returns its stack distance or 0 for a first (cold) access
+int stack_distance_access(Stack_Distance *sd, int page)
+{
+    sd->refs++;
+    if (sd->now == sd->capacity && stack_distance_compact(sd) != 0)
+        return 0;
+    int64_t *last = page_values_at(&sd->last, page);
+    if (last == NULL)
+        return 0;
+
+    int distance = 0;
+    int prev = (int)*last;
+    if (prev >= 0)
+    {
+        distance = fenwick_sum(sd, sd->now - 1) - fenwick_sum(sd, prev) + 1;
+        fenwick_add(sd, prev, -1);
+        sd->page_at[prev] = -1;
+    }
+    else
+    {
+        sd->cold++;
+        sd->distinct++;
+    }
+    fenwick_add(sd, sd->now, 1);
+    sd->page_at[sd->now] = page;
+    *last = sd->now;
+    sd->now++;
+
+    if (distance > 0)
+    {
+        if (distance >= sd->hist_size)
+        {
+            int size = sd->hist_size;
+            while (size <= distance)
+                size *= 2;
+            uint64_t *hist = realloc(sd->hist, sizeof(uint64_t) * size);
+            if (!hist)
+                return distance;
+            memset(hist + sd->hist_size, 0, sizeof(uint64_t) * (size - sd->hist_size));
+            sd->hist = hist;
+            sd->hist_size = size;
+        }
+        sd->hist[distance]++;
+    }
+    return distance;
+}
+
+// LRU hits with frames frames, from the distance histogram
+uint64_t stack_distance_hits(Stack_Distance *sd, int frames)
+{
+    uint64_t hits = 0;
+    for (int d = 1; d <= frames && d < sd->hist_size; d++)
+        hits += sd->hist[d];
+    return hits;
+}
+
+// Stop tracking page, its next access counts as a first access
+void stack_distance_forget(Stack_Distance *sd, int page)
+{
+    int64_t *last = page_values_at(&sd->last, page);
+    if (last == NULL || *last < 0)
+        return;
+    fenwick_add(sd, (int)*last, -1);
+    sd->page_at[*last] = -1;
+    *last = -1;
+    sd->distinct--;
+}
+
+void stack_distance_free(Stack_Distance *sd)
+{
+    free(sd->tree);
+    free(sd->page_at);
+    page_values_free(&sd->last);
+    free(sd->hist);
+    memset(sd, 0, sizeof(Stack_Distance));
+}
+
+// Print one point of a hit ratio curve
+static void print_curve_point(int frames, uint64_t hits, uint64_t refs)
+{
+    printf("%10d %12llu %12llu %10f\n", frames, (unsigned long long)hits, (unsigned long long)(refs - hits),
+           refs > 0 ? (double)hits / (double)refs : 0.0);
+}
+
+// Print LRU hits against frame count, at sweep_frames if given, else at every frame count
+// where the curve steps (every stack distance seen), which is the complete curve
+int print_hit_ratio_curve(Stack_Distance *sd)
+{
+    printf("LRU stack distance: %llu refs, %llu distinct pages, %llu cold misses\n",
+           (unsigned long long)sd->refs, (unsigned long long)sd->distinct, (unsigned long long)sd->cold);
+    printf("%10s %12s %12s %10s\n", "Frames", "Hits", "Misses", "Hit Ratio");
+    if (sweep_frames != NULL)
+    {
+        for (int f = 0; f < num_sweep_frames; f++)
+            print_curve_point(sweep_frames[f], stack_distance_hits(sd, sweep_frames[f]), sd->refs);
+        return 0;
+    }
+    uint64_t hits = 0;
+    for (int d = 1; d < sd->hist_size; d++)
+    {
+        if (sd->hist[d] == 0)
+            continue;
+        hits += sd->hist[d];
+        print_curve_point(d, hits, sd->refs);
+    }
+    return 0;
+}
+
+// Compute the LRU hit ratio curve for the whole trace in one pass
+int run_stack_distance()
+{
+    if (sample_rate > 0 || sample_size > 0)
+        return run_shards();
+    Stack_Distance sd;
+    if (stack_distance_init(&sd, stream_mode ? STACK_DISTANCE_CAPACITY : num_refs) != 0)
+        return 1;
+    uint64_t start_time = latency_now();
+    while (has_ref())
+    {
+        stack_distance_access(&sd, get_ref());
+        ++counter;
+    }
+    uint64_t end_time = latency_now();
+    print_hit_ratio_curve(&sd);
+    printf("Total Execution Time: %f seconds\n", latency_ns(end_time - start_time) / 1e9);
+    stack_distance_free(&sd);
+    return 0;
+}
+
+// SHARDS section
+// Spatially hashed sampling: a ref is kept when the hash of its page is under a threshold, so
+// every ref to a sampled page is kept and none to the others. Between sampled refs the stack
+// distance shrinks by the rate, so distances are scaled back up by 1/rate. A fixed-size budget
+// lowers the threshold as pages arrive, dropping the tracked pages with the largest hashes.
+
+// Spatial hash of a page in 0...SHARDS_MODULUS-1
+uint32_t shards_hash(int page)
+{
+    return (uint32_t)(splitmix64((uint32_t)page) & (SHARDS_MODULUS - 1));
+}
+
+uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Hash threshold for a sampling rate, at least 1 so something is always sampled
+uint32_t sample_threshold_of(double rate)
+{
+    double threshold = (rate > 0 ? rate : 1.0) * SHARDS_MODULUS + 0.5;
+    if (threshold < 1)
+        return 1;
+    return threshold > SHARDS_MODULUS ? SHARDS_MODULUS : (uint32_t)threshold;
+}
+
+// Set up a sampler starting at threshold, max_pages > 0 bounds the tracked pages
+int shards_init(Shards *sh, uint32_t threshold, int max_pages)
+{
+    memset(sh, 0, sizeof(Shards));
+    sh->threshold = threshold;
+    sh->max_pages = max_pages;
+    sh->hist_size = 64;
+    sh->hist = calloc(sh->hist_size, sizeof(double));
+    int capacity = max_pages > 0 ? 2 * max_pages + 64 : STACK_DISTANCE_CAPACITY;
+    if (max_pages > 0)
+    {
+        sh->heap_hash = malloc(sizeof(uint32_t) * (max_pages + 1));
+        sh->heap_page = malloc(sizeof(int) * (max_pages + 1));
+    }
+    if (!sh->hist || (max_pages > 0 && (!sh->heap_hash || !sh->heap_page)) ||
+        stack_distance_init(&sh->sd, capacity) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for SHARDS sampler\n");
+        shards_free(sh);
+        return -1;
+    }
+    return 0;
+}
+
+double shards_rate(const Shards *sh)
+{
+    return (double)sh->threshold / SHARDS_MODULUS;
+}
+
+// Swap two entries of the tracked page heap
+static void shards_heap_swap(Shards *sh, int a, int b)
+{
+    uint32_t h = sh->heap_hash[a];
+    int p = sh->heap_page[a];
+    sh->heap_hash[a] = sh->heap_hash[b];
+    sh->heap_page[a] = sh->heap_page[b];
+    sh->heap_hash[b] = h;
+    sh->heap_page[b] = p;
+}
+
+// Track a newly sampled page, then drop the largest hashes until the budget holds
+static void shards_track(Shards *sh, uint32_t hash, int page)
+{
+    int i = sh->heap_size++;
+    sh->heap_hash[i] = hash;
+    sh->heap_page[i] = page;
+    while (i > 0 && sh->heap_hash[(i - 1) / 2] < sh->heap_hash[i])
+    {
+        shards_heap_swap(sh, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    while (sh->heap_size > sh->max_pages)
+    {
+        // Pages at or above the new threshold are no longer sampled
+        sh->threshold = sh->heap_hash[0];
+        while (sh->heap_size > 0 && sh->heap_hash[0] >= sh->threshold)
+        {
+            stack_distance_forget(&sh->sd, sh->heap_page[0]);
+            shards_heap_swap(sh, 0, --sh->heap_size);
+            for (i = 0;;)
+            {
+                int largest = i, l = 2 * i + 1, r = l + 1;
+                if (l < sh->heap_size && sh->heap_hash[l] > sh->heap_hash[largest])
+                    largest = l;
+                if (r < sh->heap_size && sh->heap_hash[r] > sh->heap_hash[largest])
+                    largest = r;
+                if (largest == i)
+                    break;
+                shards_heap_swap(sh, i, largest);
+                i = largest;
+            }
+        }
+    }
+}
+
+// Offer a ref to the sampler, returns 1 if it was sampled
+// A sampled ref stands for 1/rate refs at the rate in force when it was seen
+int shards_access(Shards *sh, int page)
+{
+    sh->refs++;
+    uint32_t hash = shards_hash(page);
+    if (hash >= sh->threshold)
+        return 0;
+    sh->sampled++;
+    double rate = shards_rate(sh);
+    double weight = 1.0 / rate;
+    int fresh = page_values_get(&sh->sd.last, page) < 0;
+    int distance = stack_distance_access(&sh->sd, page);
+    sh->weight += weight;
+    if (distance == 0)
+    {
+        sh->cold += weight;
+    }
+    else
+    {
+        // Scale the other pages touched since the last access, not the page itself
+        int scaled = (int)((distance - 1) / rate + 0.5) + 1;
+        if (scaled >= sh->hist_size)
+        {
+            int size = sh->hist_size;
+            while (size <= scaled)
+                size *= 2;
+            double *hist = realloc(sh->hist, sizeof(double) * size);
+            if (!hist)
+                return 1;
+            memset(hist + sh->hist_size, 0, sizeof(double) * (size - sh->hist_size));
+            sh->hist = hist;
+            sh->hist_size = size;
+        }
+        sh->hist[scaled] += weight;
+    }
+    if (sh->max_pages > 0 && fresh)
+        shards_track(sh, hash, page);
+    return 1;
+}
+
+// With a fixed rate, refs * rate refs were expected to be sampled. The shortfall (or excess)
+// is credited to the smallest distance, which removes most of the bias of hot sampled pages.
+void shards_finish(Shards *sh)
+{
+    if (sh->max_pages > 0 || sh->sampled == 0)
+        return;
+    double rate = shards_rate(sh);
+    double adjust = ((double)sh->refs * rate - (double)sh->sampled) / rate;
+    sh->hist[1] += adjust;
+    sh->weight += adjust;
+}
+
+// Estimated LRU hit ratio with frames frames
+double shards_hit_ratio(const Shards *sh, int frames)
+{
+    double hits = 0;
+    for (int d = 1; d <= frames && d < sh->hist_size; d++)
+        hits += sh->hist[d];
+    if (sh->weight <= 0)
+        return 0.0;
+    double ratio = hits / sh->weight;
+    return ratio < 0 ? 0.0 : (ratio > 1 ? 1.0 : ratio);
+}
+
+void shards_free(Shards *sh)
+{
+    stack_distance_free(&sh->sd);
+    free(sh->heap_hash);
+    free(sh->heap_page);
+    free(sh->hist);
+    memset(sh, 0, sizeof(Shards));
+}
+
+// Sampled --mrc: the estimated LRU hit ratio curve in memory bounded by the sample
+// With --sample-error the exact analyzer runs alongside and the curves are compared
+int run_shards()
+{
+    Shards sh;
+    Stack_Distance exact;
+    if (shards_init(&sh, sample_threshold_of(sample_rate), sample_size) != 0)
+        return 1;
+    if (sample_error && stack_distance_init(&exact, stream_mode ? STACK_DISTANCE_CAPACITY : num_refs) != 0)
+    {
+        shards_free(&sh);
+        return 1;
+    }
+    uint64_t start_time = latency_now();
+    while (has_ref())
+    {
+        int page_ref = get_ref();
+        shards_access(&sh, page_ref);
+        if (sample_error)
+            stack_distance_access(&exact, page_ref);
+        ++counter;
+    }
+    shards_finish(&sh);
+    uint64_t end_time = latency_now();
+
+    printf("SHARDS LRU stack distance: %llu of %llu refs sampled, final rate %f, %llu pages tracked\n",
+           (unsigned long long)sh.sampled, (unsigned long long)sh.refs, shards_rate(&sh),
+           (unsigned long long)sh.sd.distinct);
+    if (!sample_error)
+    {
+        printf("%10s %12s %12s %10s\n", "Frames", "Hits", "Misses", "Hit Ratio");
+        for (int f = 0; sweep_frames != NULL && f < num_sweep_frames; f++)
+            print_curve_point(sweep_frames[f], (uint64_t)(shards_hit_ratio(&sh, sweep_frames[f]) * sh.refs + 0.5), sh.refs);
+        for (int d = 1; sweep_frames == NULL && d < sh.hist_size; d++)
+        {
+            if (sh.hist[d] != 0)
+                print_curve_point(d, (uint64_t)(shards_hit_ratio(&sh, d) * sh.refs + 0.5), sh.refs);
+        }
+    }
+    else
+    {
+        // Compare at the requested frame counts, else wherever the exact curve steps
+        // Below 1/rate frames the sample cannot resolve distances, so those are reported apart
+        double total = 0, worst = 0, resolved_total = 0;
+        int points = 0, resolved = 0;
+        printf("%10s %10s %10s %10s\n", "Frames", "Exact", "Sampled", "Error");
+        for (int d = 1; d < (sweep_frames != NULL ? num_sweep_frames + 1 : exact.hist_size); d++)
+        {
+            int frames = sweep_frames != NULL ? sweep_frames[d - 1] : d;
+            if (sweep_frames == NULL && exact.hist[d] == 0)
+                continue;
+            double want = exact.refs > 0 ? (double)stack_distance_hits(&exact, frames) / exact.refs : 0.0;
+            double got = shards_hit_ratio(&sh, frames);
+            double error = got > want ? got - want : want - got;
+            printf("%10d %10f %10f %10f\n", frames, want, got, error);
+            total += error;
+            worst = error > worst ? error : worst;
+            points++;
+            if (frames * shards_rate(&sh) >= 1.0)
+            {
+                resolved_total += error;
+                resolved++;
+            }
+        }
+        printf("Mean absolute error: %f, max absolute error: %f over %d points\n", points > 0 ? total / points : 0.0, worst, points);
+        printf("Mean absolute error at %d or more frames: %f over %d points\n", (int)(1.0 / shards_rate(&sh) + 0.999),
+               resolved > 0 ? resolved_total / resolved : 0.0, resolved);
+        stack_distance_free(&exact);
+    }
+    printf("Total Execution Time: %f seconds\n", latency_ns(end_time - start_time) / 1e9);
+    shards_free(&sh);
+    return 0;
+}
+
+// Threshold a fixed-size sampler of max_pages pages settles on over a whole trace
+uint32_t sample_budget_threshold(const uint32_t *pages, int n, int max_pages)
+{
+    Shards sh;
+    if (shards_init(&sh, sample_threshold_of(sample_rate), max_pages) != 0)
+        return sample_threshold_of(sample_rate);
+    for (int i = 0; i < n; i++)
+        shards_access(&sh, (int)pages[i]);
+    uint32_t threshold = sh.threshold;
+    shards_free(&sh);
+    return threshold;
+}
+
+// Replace the in-memory trace by its sampled refs for the policies in algos[]
+// Policies cannot change size mid-run, so a fixed-size budget is first turned into the rate
+// it would end at. Page tables are then scaled by that rate (see scaled_frames()).
+int sample_trace()
+{
+    uint32_t threshold = sample_size > 0 ? sample_budget_threshold(trace_pages, num_refs, sample_size)
+                                         : sample_threshold_of(sample_rate);
+    uint32_t *pages = malloc(sizeof(uint32_t) * (num_refs > 0 ? num_refs : 1));
+    if (!pages)
+    {
+        fprintf(stderr, "Memory allocation failed for sampled trace\n");
+        return -1;
+    }
+    uint32_t *sizes = trace_sizes != NULL ? malloc(sizeof(uint32_t) * (num_refs > 0 ? num_refs : 1)) : NULL;
+    if (trace_sizes != NULL && !sizes)
+    {
+        fprintf(stderr, "Memory allocation failed for sampled trace\n");
+        free(pages);
+        return -1;
+    }
+    int n = 0;
+    for (int i = 0; i < num_refs; i++)
+    {
+        if (shards_hash((int)trace_pages[i]) < threshold)
+        {
+            if (sizes)
+                sizes[n] = trace_sizes[i];
+            pages[n++] = trace_pages[i];
+        }
+    }
+    if (sizes)
+    {
+        free(size_array); // the sizes of the whole trace are not needed again
+        trace_sizes = size_array = sizes;
+    }
+    frame_scale = (double)threshold / SHARDS_MODULUS;
+    printf("Sampled %d of %d refs at rate %f\n", n, num_refs, frame_scale);
+    if (sample_error)
+    {
+        exact_pages = trace_pages;
+        exact_refs = num_refs;
+    }
+    sample_array = pages;
+    trace_pages = pages;
+    num_refs = n;
+    return 0;
+}
+
+// A sampled trace touches about frame_scale of the pages, so it is replayed on a page table
+// scaled down by the same rate to estimate the full-size hit ratio
+int scaled_frames(int frames)
+{
+    int scaled = (int)(frames * frame_scale + 0.5);
+    return scaled > 0 ? scaled : 1;
+}
+
+// CLOCK Page Replacement Algorithm
+static inline int clockStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int fault = 0;
+    /* Find target (hit), empty page slot (miss), or victim to evict (miss) */
+    int i = frameFind(arrays, size, data->page_ref);
+    if (i < 0 && arrays->used < size)
+    {
+        i = arrays->used++;
+        arrays->page[i] = data->page_ref;
+        fault = 1;
+    }
+    else if (i < 0) // Use the hand to find our victim
+    {
+        // meta is 0 for a referenced frame, the hand clears it to 1 as it passes
+        while (arrays->meta[arrays->hand] == 0)
+        {
+            arrays->meta[arrays->hand] = 1;
+            arrays->hand = arrays->hand + 1 == size ? 0 : arrays->hand + 1;
+        }
+        i = arrays->hand;
+        add_victim_page(data, i, arrays->page[i]);
+        arrays->page[i] = data->page_ref;
+        fault = 1;
+    }
+    arrays->meta[i] = 0; // Found or loaded the page, mark it referenced
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+int CLOCK(Algorithm_Data *data)
+{
+    return clockStep(data, data->arrays.size);
+}
+
+// GCLOCK (generalized CLOCK) Page Replacement Algorithm
+// meta counts hits up to GCLOCK_MAX, and the hand takes one off each frame it passes, so a frame
+// survives a lap per hit instead of one lap in all. A hit is still one scan and an increment.
+static inline int gclockStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int i = frameFind(arrays, size, data->page_ref);
+    if (i >= 0)
+    {
+        if (arrays->meta[i] < GCLOCK_MAX)
+            arrays->meta[i]++;
+        data->hits++;
+        return 0;
+    }
+    if (arrays->used < size)
+        i = arrays->used++;
+    else
+    {
+        while (arrays->meta[arrays->hand] > 0)
+        {
+            arrays->meta[arrays->hand]--;
+            arrays->hand = arrays->hand + 1 == size ? 0 : arrays->hand + 1;
+        }
+        i = arrays->hand;
+        add_victim_page(data, i, arrays->page[i]);
+        arrays->hand = arrays->hand + 1 == size ? 0 : arrays->hand + 1;
+    }
+    arrays->page[i] = data->page_ref;
+    arrays->meta[i] = 1;
+    data->misses++;
+    return 1;
+}
+
+int GCLOCK(Algorithm_Data *data)
+{
+    return gclockStep(data, data->arrays.size);
+}
+
+// NFU Page Replacement Algorithm
+static inline int nfuStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int fault = 0;
+    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
+    int i = frameFind(arrays, size, data->page_ref);
+    if (i >= 0)
+    { // The page was found! Hit!
+        arrays->meta[i]++;
+    }
+    else
+    {
+        i = arrays->used < size ? arrays->used++ : frameArgmin(arrays, size);
+        if (arrays->page[i] != -1) // It's a miss, kill our victim (the frame used fewest times)
+            add_victim_page(data, i, arrays->page[i]);
+        arrays->page[i] = data->page_ref;
+        arrays->meta[i] = 0;
+        fault = 1;
+    }
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+int NFU(Algorithm_Data *data)
+{
+    return nfuStep(data, data->arrays.size);
+}
+
+// AGING Page Replacement Algorithm
+static inline int agingStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int fault = 0;
+    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
+    int i = frameFind(arrays, size, data->page_ref);
+    // Every other resident frame ages by one step
+    uint32_t kept = i >= 0 ? arrays->meta[i] : 0;
+    frameHalve(arrays, size);
+    if (i >= 0)
+    { // The page was found! Hit!
+        arrays->meta[i] = kept + 10000000;
+    }
+    else
+    {
+        i = arrays->used < size ? arrays->used++ : frameArgmin(arrays, size);
+        if (arrays->page[i] != -1) // It's a miss, kill our victim (the frame used least lately)
+            add_victim_page(data, i, arrays->page[i]);
+        arrays->page[i] = data->page_ref;
+        arrays->meta[i] = 0;
+        fault = 1;
+    }
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+int AGING(Algorithm_Data *data)
+{
+    return agingStep(data, data->arrays.size);
+}
+
+// MRU(Most-recently-used) Page Replacement Algorithm
+int MRU(Algorithm_Data *data)
+{
+    Frame *framep = page_map_get(&data->page_map, data->page_ref);
+    int fault = 0;
+
+    if (framep == NULL)
+    {
+        // Page fault occurred, use a free frame if available, otherwise replace the MRU frame
+        framep = data->order.tqh_first;
+        if (framep->page != -1)
+            framep = TAILQ_LAST(&data->order, Frame_Queue);
+        recency_load(data, framep);
+        fault = 1;
+    }
+    recency_touch(data, framep);
+    framep->time = current_tick(data);
+
+    if (fault == 1)
+        data->misses++;
+    else
+        data->hits++;
+    return fault;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Renumber the resident stamps by rank, equal stamps to equal ranks, and count from a base
+// that puts tick just past them. Every comparison frameArgmin makes comes out the same.
+static void nruRebase(Frame_Arrays *arrays, uint64_t tick)
+{
+    uint64_t *order = malloc(sizeof(uint64_t) * (arrays->used > 0 ? arrays->used : 1));
+    if (!order)
+    {
+        fprintf(stderr, "Failed to allocate memory for NRU stamps\n");
+        exit(1);
+    }
+    for (int i = 0; i < arrays->used; i++)
+        order[i] = (uint64_t)arrays->meta[i] << 32 | (uint32_t)i;
+    qsort(order, arrays->used, sizeof(uint64_t), compare_u64);
+    uint32_t rank = 0;
+    for (int k = 0; k < arrays->used; k++)
+    {
+        if (k > 0 && order[k] >> 32 != order[k - 1] >> 32)
+            rank++;
+        arrays->meta[(uint32_t)order[k]] = rank;
+    }
+    free(order);
+    arrays->base = tick - (uint64_t)arrays->used;
+}
+
+// NRU's stamp of the current tick, rebased once every 2^32 ticks (or after a --warm's tick_base)
+static inline uint32_t nruStamp(Algorithm_Data *data)
+{
+    uint64_t tick = current_tick(data);
+    if (__builtin_expect(tick - data->arrays.base > UINT32_MAX, 0))
+        nruRebase(&data->arrays, tick);
+    return (uint32_t)(tick - data->arrays.base);
+}
+
+// NRU(Not Recently Used) Page Replacement Algorithm
+static inline int nruStep(Algorithm_Data *data, int size)
+{
+    Frame_Arrays *arrays = &data->arrays;
+    int i = frameFind(arrays, size, data->page_ref);
+    if (i >= 0)
+    {
+        // Page hit, update its tick
+        arrays->meta[i] = nruStamp(data);
+        data->hits++;
+        return 0; // No fault occurred
+    }
+
+    // Page fault occurred, use a free frame if available, otherwise replace the NRU frame
+    data->misses++;
+    i = arrays->used < size ? arrays->used++ : frameArgmin(arrays, size);
+    if (arrays->page[i] != -1)
+        add_victim_page(data, i, arrays->page[i]); // Add the NRU frame to the victim list
+    arrays->page[i] = data->page_ref;              // Replace with the new page
+    arrays->meta[i] = nruStamp(data);              // Set the time for the new frame
+    return 1;
+}
+
+int NRU(Algorithm_Data *data)
+{
+    return nruStep(data, data->arrays.size);
+}
+
+// MFU(Most Frequently Used) Page Replacement Algorithm
+int MFU(Algorithm_Data *data)
+{
+    Frame *framep = lfu_get(&data->lfu, data->page_ref);
+    if (framep != NULL)
+    {
+        // Page hit
+        lfu_touch(&data->lfu, framep); // Increment the usage count
+        data->hits++;
+        return 0; // No fault occurred
+    }
+
+    // Page fault occurred, use a free frame if available, otherwise replace the most used page
+    data->misses++;
+    if (data->lfu.size == data->lfu.capacity)
+    {
+        Frame *victim = lfu_most(&data->lfu);
+        add_victim(data, victim); // Add the victim to the victim list
+        lfu_remove(&data->lfu, victim);
+    }
+    lfu_insert(&data->lfu, data->page_ref); // The new page starts with a usage count of 1
+    return 1;
+}
+
+// LFU (Least Frequently Used) page replacement algorithm
+int LFU(Algorithm_Data *data) {
+    // Check if page is in frames and update frequency
+    Frame *framep = lfu_get(&data->lfu, data->page_ref);
+    if (framep != NULL) {
+        lfu_touch(&data->lfu, framep);
+        data->hits++;
+        return 0;
+    }
+
+    // If page not found, handle page fault: use a free frame, else replace the least
+    // frequently used frame
+    data->misses++;
+    if (data->lfu.size == data->lfu.capacity) {
+        Frame *leastFrequentFrame = lfu_least(&data->lfu);
+        // Add the old page to the victim list
+        add_victim(data, leastFrequentFrame);
+        lfu_remove(&data->lfu, leastFrequentFrame);
+    }
+    framep = lfu_insert(&data->lfu, data->page_ref); // Frequency 1 for the new page
+    framep->lastUsed = current_tick(data);
+    return 1; // Return 1 if there was a page fault, otherwise 0
+}
+
+
+
+
+
+
+// LFRU section
+
+// Check if a page is in the given partition
+int isPageInPartition(Partition *partition, int page)
+{
+    return page_map_get(&partition->map, page) != NULL;
+}
+
+// Update LRU information in a partition
+void updateLRU(Partition *partition, int page, uint64_t now)
+{
+    // Find the frame, update its last used time and move it to the most recent end
+    Frame *framep = page_map_get(&partition->map, page);
+    if (framep == NULL)
+        return;
+    framep->lastUsed = now;
+    TAILQ_REMOVE(&partition->order, framep, order);
+    TAILQ_INSERT_TAIL(&partition->order, framep, order);
+}
+
+// Update LFU information in the LFU partition
+void updateLFU(Lfu *partition, int page)
+{
+    // Find the frame and increment its frequency count
+    Frame *framep = lfu_get(partition, page);
+    if (framep != NULL)
+        lfu_touch(partition, framep);
+}
+
+// Function to check if a page is in either partition
+int checkPageInPartitions(LFRU_Data *lfru_data, int page, uint64_t now)
+{
+    // Check in privileged partition using LRU logic
+    if (isPageInPartition(&lfru_data->privileged, page))
+    {
+        // Update LRU information for the page
+        updateLRU(&lfru_data->privileged, page, now);
+        return 1; // Page found in privileged partition
+    }
+
+    // Check in unprivileged partition using LFU logic
+    if (lfu_get(&lfru_data->unprivileged, page) != NULL)
+    {
+        // Update LFU information for the page
+        updateLFU(&lfru_data->unprivileged, page);
+        return 1; // Page found in unprivileged partition
+    }
+
+    return 0; // Page not found in either partition
+}
+
+// Function to update access information for a page
+void updateAccessInfo(LFRU_Data *lfru_data, int page, uint64_t now)
+{
+    // Update LRU information in the privileged partition
+    updateLRU(&lfru_data->privileged, page, now);
+
+    // Update LFU information in the unprivileged partition
+    updateLFU(&lfru_data->unprivileged, page);
+}
+
+// Evict a page using the LFU policy, if the partition is full
+int evictLFU(Lfu *partition)
+{
+    if (partition->size < partition->capacity || partition->capacity == 0)
+        return -1; // Indicates no page had to be evicted
+
+    Frame *framep = lfu_least(partition);
+    int evictedPage = framep->page;
+    lfu_remove(partition, framep); // Mark as empty
+    return evictedPage;
+}
+
+// Demote the most recently used page from the LRU partition
+int demoteLRU(Partition *partition)
+{
+    Frame *framep = TAILQ_LAST(&partition->order, Frame_Queue);
+    if (framep == NULL)
+        return -1; // Indicates no page was demoted, likely an error
+
+    int demotedPage = framep->page;
+    TAILQ_REMOVE(&partition->order, framep, order);
+    page_map_remove(&partition->map, demotedPage);
+    framep->page = -1; // Mark as empty
+    TAILQ_INSERT_TAIL(&partition->free, framep, order);
+    return demotedPage;
+}
+
+// Insert a page into a free frame of the partition
+void insertIntoPartition(Partition *partition, int page, uint64_t now)
+{
+    Frame *framep = TAILQ_FIRST(&partition->free);
+    if (framep == NULL)
+        return;
+    TAILQ_REMOVE(&partition->free, framep, order);
+    framep->page = page;
+    framep->lastUsed = now;
+    framep->frequency = 1;
+    TAILQ_INSERT_TAIL(&partition->order, framep, order);
+    page_map_put(&partition->map, page, framep);
+}
+
+// Check if there is space in the partition
+int hasSpace(Partition *partition)
+{
+    return !TAILQ_EMPTY(&partition->free);
+}
+
+// Function to handle the insertion of a new page
+void handlePageInsertion(Algorithm_Data *data, LFRU_Data *lfru_data, int page, uint64_t now)
+{
+    // Check if there's space in the privileged partition
+    if (hasSpace(&lfru_data->privileged))
+    {
+        insertIntoPartition(&lfru_data->privileged, page, now);
+    }
+    else
+    {
+        // Evict a page from the unprivileged partition using LFU
+        int evictedPage = evictLFU(&lfru_data->unprivileged);
+        if (evictedPage != -1)
+            add_victim_page(data, -1, evictedPage);
+
+        // Move a page from privileged to unprivileged, it is dropped if that has no frames
+        int demotedPage = demoteLRU(&lfru_data->privileged);
+        if (demotedPage != -1 && lfu_insert(&lfru_data->unprivileged, demotedPage) == NULL)
+            add_victim_page(data, -1, demotedPage);
+
+        // Insert the new page into the privileged partition
+        insertIntoPartition(&lfru_data->privileged, page, now);
+    }
+}
+
+// LFRU (Least Frequently Recently Used) algorithm
+int LFRU(Algorithm_Data *data)
+{
+    LFRU_Data *lfru_data = (LFRU_Data *)data->extra; // Assuming extra is used to store LFRU specific data
+
+    // Check for the page in both partitions
+    int pageFound = checkPageInPartitions(lfru_data, data->page_ref, current_tick(data));
+    if (pageFound)
+    {
+        // Page found, update access info
+        updateAccessInfo(lfru_data, data->page_ref, current_tick(data));
+        data->hits++;
+        return 0; // No page fault
+    }
+
+    // Page fault handling
+    data->misses++;
+
+    // Evict a page if necessary and insert the new page
+    handlePageInsertion(data, lfru_data, data->page_ref, current_tick(data));
+
+    return 1; // Page fault occurred
+}
+
+// Checkpoint hook for LFRU, the LFU partition's frames are page_table frames
+void checkpointLFRU(Checkpoint *cp, Algorithm_Data *data)
+{
+    LFRU_Data *lfru_data = data->extra;
+    checkpoint_match(cp, lfru_data->privileged.size, "--lfru-ratio");
+    checkpoint_page_map(cp, &lfru_data->privileged.map);
+    checkpoint_queue(cp, &lfru_data->privileged.order, 0);
+    checkpoint_queue(cp, &lfru_data->privileged.free, 0);
+    checkpoint_lfu(cp, &lfru_data->unprivileged);
+}
+
+// Ghost list section
+// ARC, 2Q, LIRS and W-TinyLFU keep resident pages in the page_table frames and remember some
+// evicted pages in ghost frames, which hold a page number but no data. Every list is a TAILQ and
+// every lookup goes through one page map, so each ref costs O(1).
+
+// Set up data's page_table frames, all free, and a pool of ghosts ghost frames
+int ghost_cache_init(Ghost_Cache *gc, Algorithm_Data *data, int ghosts)
+{
+    memset(gc, 0, sizeof(Ghost_Cache));
+    gc->num_ghosts = ghosts;
+    gc->ghosts = malloc(sizeof(Frame) * (ghosts > 0 ? ghosts : 1));
+    if (!gc->ghosts || page_map_init(&gc->map, data->num_frames + ghosts) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for ghost lists\n");
+        free(gc->ghosts);
+        gc->ghosts = NULL;
+        return -1;
+    }
+    for (int i = 0; i < GHOST_CACHE_LISTS; ++i)
+        TAILQ_INIT(&gc->lists[i]);
+    TAILQ_INIT(&gc->free);
+    TAILQ_INIT(&gc->spare);
+    for (int i = 0; i < data->num_frames; ++i)
+    {
+        data->frame_arena[i].extra = -1;
+        TAILQ_INSERT_TAIL(&gc->free, &data->frame_arena[i], order);
+    }
+    for (int i = 0; i < ghosts; ++i)
+    {
+        init_empty_frame(&gc->ghosts[i], -1);
+        gc->ghosts[i].extra = -1;
+        TAILQ_INSERT_TAIL(&gc->spare, &gc->ghosts[i], order);
+    }
+    gc->capacity = data->num_frames;
+    return 0;
+}
+
+// Resident or ghost frame of page, NULL if the page is not tracked
+Frame *ghost_cache_get(Ghost_Cache *gc, int page)
+{
+    return page_map_get(&gc->map, page);
+}
+
+// Load page into a free page_table frame, NULL if every frame holds a page
+Frame *ghost_cache_load(Ghost_Cache *gc, int page)
+{
+    Frame *framep = TAILQ_FIRST(&gc->free);
+    if (framep == NULL)
+        return NULL;
+    TAILQ_REMOVE(&gc->free, framep, order);
+    framep->page = page;
+    framep->extra = -1;
+    page_map_put(&gc->map, page, framep);
+    gc->resident++;
+    return framep;
+}
+
+// Evict the page of a resident frame and free the frame
+void ghost_cache_evict(Algorithm_Data *data, Ghost_Cache *gc, Frame *framep)
+{
+    if (debug)
+        printf("Victim selected: %d, Page: %d\n", framep->index, framep->page);
+    add_victim(data, framep);
+    page_map_remove(&gc->map, framep->page);
+    framep->page = -1;
+    TAILQ_INSERT_TAIL(&gc->free, framep, order);
+    gc->resident--;
+}
+
+// Remember page in a ghost frame, NULL if none is spare
+Frame *ghost_cache_remember(Ghost_Cache *gc, int page)
+{
+    Frame *ghost = TAILQ_FIRST(&gc->spare);
+    if (ghost == NULL)
+        return NULL;
+    TAILQ_REMOVE(&gc->spare, ghost, order);
+    ghost->page = page;
+    ghost->extra = -1;
+    page_map_put(&gc->map, page, ghost);
+    return ghost;
+}
+
+void ghost_cache_forget(Ghost_Cache *gc, Frame *ghost)
+{
+    page_map_remove(&gc->map, ghost->page);
+    ghost->page = -1;
+    TAILQ_INSERT_TAIL(&gc->spare, ghost, order);
+}
+
+// Take a frame off its list, if it is on one
+void ghost_cache_unlist(Ghost_Cache *gc, Frame *framep)
+{
+    if (framep->extra < 0)
+        return;
+    TAILQ_REMOVE(&gc->lists[framep->extra], framep, order);
+    gc->sizes[framep->extra]--;
+    framep->extra = -1;
+}
+
+// Move a frame to the tail (newest end) of list
+void ghost_cache_move(Ghost_Cache *gc, Frame *framep, int list)
+{
+    ghost_cache_unlist(gc, framep);
+    TAILQ_INSERT_TAIL(&gc->lists[list], framep, order);
+    gc->sizes[list]++;
+    framep->extra = list;
+}
+
+void ghost_cache_free(Ghost_Cache *gc)
+{
+    page_map_free(&gc->map);
+    free(gc->ghosts);
+    gc->ghosts = NULL;
+}
+
+// Frees the data of ARC, 2Q or LIRS, whose first member is their Ghost_Cache
+void freeGhostPolicy(void *extra)
+{
+    if (!extra)
+        return;
+    ghost_cache_free((Ghost_Cache *)extra);
+    free(extra);
+}
+
+// Allocate a policy's data, whose first member is a Ghost_Cache with ghosts ghost frames
+static void *ghost_policy_create(Algorithm_Data *data, size_t size, int ghosts)
+{
+    void *extra = calloc(1, size);
+    if (!extra || ghost_cache_init((Ghost_Cache *)extra, data, ghosts) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for algorithm data\n");
+        exit(1);
+    }
+    data->extra = extra;
+    data->free_extra = &freeGhostPolicy;
+    return extra;
+}
+
+// Setup hook for ARC, T1 and T2 share the frames and B1 and B2 at most as many ghosts
+void initializeARC(Algorithm_Data *data)
+{
+    ghost_policy_create(data, sizeof(ARC_Data), data->num_frames);
+}
+
+void checkpointARC(Checkpoint *cp, Algorithm_Data *data)
+{
+    ARC_Data *arc = data->extra;
+    checkpoint_ghost_cache(cp, &arc->cache);
+    CHECKPOINT(cp, arc->p);
+}
+
+// Move the oldest page of T1 or T2 to the matching ghost list (REPLACE in the ARC paper)
+static void arcReplace(Algorithm_Data *data, ARC_Data *arc, int in_b2)
+{
+    Ghost_Cache *gc = &arc->cache;
+    int t1 = gc->sizes[ARC_T1];
+    int from = (t1 > 0 && (t1 > arc->p || (in_b2 && t1 == arc->p))) ? ARC_T1 : ARC_T2;
+    Frame *framep = TAILQ_FIRST(&gc->lists[from]);
+    int page = framep->page;
+    ghost_cache_unlist(gc, framep);
+    ghost_cache_evict(data, gc, framep);
+    Frame *ghost = ghost_cache_remember(gc, page);
+    if (ghost != NULL)
+        ghost_cache_move(gc, ghost, from == ARC_T1 ? ARC_B1 : ARC_B2);
+}
+
+// ARC (Adaptive Replacement Cache) Page Replacement Algorithm
+// T1 holds pages seen once and T2 pages seen again. A hit on a ghost in B1 (B2) means T1 (T2)
+// was too small, so the target size p of T1 moves towards it.
+int ARC(Algorithm_Data *data)
+{
+    ARC_Data *arc = data->extra;
+    Ghost_Cache *gc = &arc->cache;
+    int c = gc->capacity;
+    Frame *framep = ghost_cache_get(gc, data->page_ref);
+    if (framep != NULL && framep->index >= 0)
+    { // Resident, the page is now frequent
+        ghost_cache_move(gc, framep, ARC_T2);
+        framep->time = current_tick(data);
+        data->hits++;
+        return 0;
+    }
+
+    data->misses++;
+    int b1 = gc->sizes[ARC_B1], b2 = gc->sizes[ARC_B2];
+    int list = ARC_T1;
+    if (framep != NULL)
+    { // Ghost hit, adapt p and bring the page back into T2
+        int in_b2 = framep->extra == ARC_B2;
+        int delta = in_b2 ? b1 / b2 : b2 / b1;
+        if (delta < 1)
+            delta = 1;
+        if (in_b2)
+            arc->p = arc->p > delta ? arc->p - delta : 0;
+        else
+            arc->p = arc->p + delta < c ? arc->p + delta : c;
+        ghost_cache_unlist(gc, framep);
+        ghost_cache_forget(gc, framep);
+        if (gc->resident == c)
+            arcReplace(data, arc, in_b2);
+        list = ARC_T2;
+    }
+    else if (gc->sizes[ARC_T1] + b1 == c)
+    { // L1 (T1 and B1) is full
+        if (gc->sizes[ARC_T1] < c)
+        {
+            Frame *oldest = TAILQ_FIRST(&gc->lists[ARC_B1]);
+            ghost_cache_unlist(gc, oldest);
+            ghost_cache_forget(gc, oldest);
+            if (gc->resident == c)
+                arcReplace(data, arc, 0);
+        }
+        else
+        {
+            Frame *oldest = TAILQ_FIRST(&gc->lists[ARC_T1]);
+            ghost_cache_unlist(gc, oldest);
+            ghost_cache_evict(data, gc, oldest);
+        }
+    }
+    else if (gc->resident + b1 + b2 >= c)
+    {
+        if (gc->resident + b1 + b2 == 2 * c)
+        {
+            Frame *oldest = TAILQ_FIRST(&gc->lists[ARC_B2]);
+            ghost_cache_unlist(gc, oldest);
+            ghost_cache_forget(gc, oldest);
+        }
+        if (gc->resident == c)
+            arcReplace(data, arc, 0);
+    }
+    framep = ghost_cache_load(gc, data->page_ref);
+    ghost_cache_move(gc, framep, list);
+    framep->time = current_tick(data);
+    return 1;
+}
+
+// Setup hook for 2Q, A1in gets a quarter of the frames and A1out remembers half as many pages
+void initializeTwoQ(Algorithm_Data *data)
+{
+    int kout = data->num_frames / 2 > 1 ? data->num_frames / 2 : 1;
+    TWOQ_Data *twoq = ghost_policy_create(data, sizeof(TWOQ_Data), kout);
+    twoq->kin = data->num_frames / 4 > 1 ? data->num_frames / 4 : 1;
+    twoq->kout = kout;
+}
+
+void checkpointTwoQ(Checkpoint *cp, Algorithm_Data *data)
+{
+    TWOQ_Data *twoq = data->extra;
+    checkpoint_ghost_cache(cp, &twoq->cache);
+    CHECKPOINT(cp, twoq->kin);
+    CHECKPOINT(cp, twoq->kout);
+}
+
+// 2Q Page Replacement Algorithm (the full version with A1in, A1out and Am)
+// New pages wait in the A1in FIFO, and only a page referenced again after it left A1in, while
+// A1out still remembers it, is admitted to the Am LRU. One pass over many pages cannot flush Am.
+int TWOQ(Algorithm_Data *data)
+{
+    TWOQ_Data *twoq = data->extra;
+    Ghost_Cache *gc = &twoq->cache;
+    Frame *framep = ghost_cache_get(gc, data->page_ref);
+    if (framep != NULL && framep->index >= 0)
+    { // Resident, a hit in A1in leaves its FIFO order alone
+        if (framep->extra == TWOQ_AM)
+            ghost_cache_move(gc, framep, TWOQ_AM);
+        framep->time = current_tick(data);
+        data->hits++;
+        return 0;
+    }
+
+    data->misses++;
+    int list = TWOQ_A1IN;
+    if (framep != NULL)
+    { // Remembered by A1out, the page goes to Am
+        ghost_cache_unlist(gc, framep);
+        ghost_cache_forget(gc, framep);
+        list = TWOQ_AM;
+    }
+    if (gc->resident == gc->capacity)
+    { // Reclaim a frame, from A1in while it is over kin, else from Am
+        if (gc->sizes[TWOQ_A1IN] > twoq->kin || gc->sizes[TWOQ_AM] == 0)
+        {
+            Frame *oldest = TAILQ_FIRST(&gc->lists[TWOQ_A1IN]);
+            int page = oldest->page;
+            ghost_cache_unlist(gc, oldest);
+            ghost_cache_evict(data, gc, oldest);
+            if (gc->sizes[TWOQ_A1OUT] >= twoq->kout)
+            {
+                Frame *ghost = TAILQ_FIRST(&gc->lists[TWOQ_A1OUT]);
+                ghost_cache_unlist(gc, ghost);
+                ghost_cache_forget(gc, ghost);
+            }
+            ghost_cache_move(gc, ghost_cache_remember(gc, page), TWOQ_A1OUT);
+        }
+        else
+        {
+            Frame *oldest = TAILQ_FIRST(&gc->lists[TWOQ_AM]);
+            ghost_cache_unlist(gc, oldest);
+            ghost_cache_evict(data, gc, oldest);
+        }
+    }
+    framep = ghost_cache_load(gc, data->page_ref);
+    ghost_cache_move(gc, framep, list);
+    framep->time = current_tick(data);
+    return 1;
+}
+
+// Setup hook for LIRS, 1% of the frames (at least one) hold resident HIR pages
+// S keeps at most num_frames ghosts, the oldest is forgotten first
+void initializeLIRS(Algorithm_Data *data)
+{
+    LIRS_Data *lirs = ghost_policy_create(data, sizeof(LIRS_Data), data->num_frames);
+    int hir = data->num_frames / 100 > 1 ? data->num_frames / 100 : 1;
+    lirs->lir_max = data->num_frames - hir;
+    TAILQ_INIT(&lirs->stack);
+    TAILQ_INIT(&lirs->queue);
+    TAILQ_INIT(&lirs->ghosts);
+}
+
+// Checkpoint hook for LIRS, S and both queues run over the ghost cache's frames
+void checkpointLIRS(Checkpoint *cp, Algorithm_Data *data)
+{
+    LIRS_Data *lirs = data->extra;
+    checkpoint_ghost_cache(cp, &lirs->cache);
+    checkpoint_queue(cp, &lirs->stack, 0);
+    checkpoint_queue(cp, &lirs->queue, 1);
+    checkpoint_queue(cp, &lirs->ghosts, 1);
+    CHECKPOINT(cp, lirs->lir_size);
+    CHECKPOINT(cp, lirs->lir_max);
+}
+
+// Drop HIR pages off the bottom of S until a LIR page is at the bottom (stack pruning)
+static void lirsPrune(LIRS_Data *lirs)
+{
+    Frame *bottom;
+    while ((bottom = TAILQ_FIRST(&lirs->stack)) != NULL && bottom->extra != LIRS_LIR)
+    {
+        TAILQ_REMOVE(&lirs->stack, bottom, order);
+        if (bottom->extra == LIRS_GHOST)
+        {
+            TAILQ_REMOVE(&lirs->ghosts, bottom, queue);
+            ghost_cache_forget(&lirs->cache, bottom);
+        }
+        else
+            bottom->extra = LIRS_HIR; // Still resident, on Q only
+    }
+}
+
+// Turn the LIR pages at the bottom of S into resident HIR pages until at most lir_max are LIR
+static void lirsDemote(LIRS_Data *lirs)
+{
+    while (lirs->lir_size > lirs->lir_max)
+    {
+        lirsPrune(lirs); // S may not be pruned while it has no LIR page
+        Frame *bottom = TAILQ_FIRST(&lirs->stack);
+        TAILQ_REMOVE(&lirs->stack, bottom, order);
+        bottom->extra = LIRS_HIR;
+        TAILQ_INSERT_TAIL(&lirs->queue, bottom, queue);
+        lirs->lir_size--;
+    }
+    lirsPrune(lirs);
+}
+
+// Evict the resident HIR page at the front of Q, leaving a ghost in its place if it is on S
+static void lirsEvict(Algorithm_Data *data, LIRS_Data *lirs)
+{
+    Ghost_Cache *gc = &lirs->cache;
+    Frame *victim = TAILQ_FIRST(&lirs->queue);
+    TAILQ_REMOVE(&lirs->queue, victim, queue);
+    if (victim->extra != LIRS_HIR_S)
+    {
+        ghost_cache_evict(data, gc, victim);
+        return;
+    }
+    if (TAILQ_EMPTY(&gc->spare))
+    { // Out of ghosts, forget the oldest (never the bottom of S, which is LIR)
+        Frame *oldest = TAILQ_FIRST(&lirs->ghosts);
+        TAILQ_REMOVE(&lirs->ghosts, oldest, queue);
+        TAILQ_REMOVE(&lirs->stack, oldest, order);
+        ghost_cache_forget(gc, oldest);
+    }
+    Frame *below = TAILQ_PREV(victim, Frame_Queue, order);
+    int page = victim->page;
+    TAILQ_REMOVE(&lirs->stack, victim, order);
+    ghost_cache_evict(data, gc, victim);
+    Frame *ghost = ghost_cache_remember(gc, page);
+    ghost->extra = LIRS_GHOST;
+    if (below != NULL)
+        TAILQ_INSERT_AFTER(&lirs->stack, below, ghost, order);
+    else
+        TAILQ_INSERT_HEAD(&lirs->stack, ghost, order);
+    TAILQ_INSERT_TAIL(&lirs->ghosts, ghost, queue);
+}
+
+// LIRS (Low Inter-reference Recency Set) Page Replacement Algorithm
+// Pages whose last two uses were close together (LIR) get almost every frame. The rest (HIR)
+// share the few left over in FIFO order Q, and a HIR page reused while it is still on the
+// recency stack S, resident or not, replaces the LIR page at the bottom of S.
+int LIRS(Algorithm_Data *data)
+{
+    LIRS_Data *lirs = data->extra;
+    Ghost_Cache *gc = &lirs->cache;
+    Frame *framep = ghost_cache_get(gc, data->page_ref);
+    if (framep != NULL && framep->extra != LIRS_GHOST)
+    {
+        if (framep->extra == LIRS_HIR)
+        { // Not on S, back on top of S and to the end of Q
+            TAILQ_INSERT_TAIL(&lirs->stack, framep, order);
+            TAILQ_REMOVE(&lirs->queue, framep, queue);
+            TAILQ_INSERT_TAIL(&lirs->queue, framep, queue);
+            framep->extra = LIRS_HIR_S;
+        }
+        else
+        {
+            TAILQ_REMOVE(&lirs->stack, framep, order);
+            TAILQ_INSERT_TAIL(&lirs->stack, framep, order);
+            if (framep->extra == LIRS_HIR_S)
+            { // Reused while on S, it becomes LIR
+                TAILQ_REMOVE(&lirs->queue, framep, queue);
+                framep->extra = LIRS_LIR;
+                lirs->lir_size++;
+                lirsDemote(lirs);
+            }
+            lirsPrune(lirs);
+        }
+        framep->time = current_tick(data);
+        data->hits++;
+        return 0;
+    }
+
+    data->misses++;
+    int reused = framep != NULL;
+    if (reused)
+    { // A ghost on S, its frame takes the ghost's place at the top of S
+        TAILQ_REMOVE(&lirs->stack, framep, order);
+        TAILQ_REMOVE(&lirs->ghosts, framep, queue);
+        ghost_cache_forget(gc, framep);
+    }
+    if (gc->resident == gc->capacity)
+        lirsEvict(data, lirs);
+    framep = ghost_cache_load(gc, data->page_ref);
+    TAILQ_INSERT_TAIL(&lirs->stack, framep, order);
+    if (reused || lirs->lir_size < lirs->lir_max)
+    { // LIR pages fill the cache first
+        framep->extra = LIRS_LIR;
+        lirs->lir_size++;
+        lirsDemote(lirs);
+    }
+    else
+    {
+        framep->extra = LIRS_HIR_S;
+        TAILQ_INSERT_TAIL(&lirs->queue, framep, queue);
+    }
+    framep->time = current_tick(data);
+    return 1;
+}
+
+// Count-Min Sketch section
+
+// Allocate counters for about expected distinct pages, halved every 10 * expected increments
+int sketch_init(Count_Min_Sketch *sketch, int expected)
+{
+    unsigned int width = 16;
+    while (width < 2u * (unsigned int)expected)
+        width <<= 1;
+    sketch->counters = calloc((size_t)width * SKETCH_DEPTH, sizeof(uint8_t));
+    if (!sketch->counters)
+        return -1;
+    sketch->mask = width - 1;
+    sketch->additions = 0;
+    sketch->sample_size = 10 * (expected > 0 ? expected : 1);
+    return 0;
+}
+
+// Counter of page in row, rows index by double hashing one 64-bit hash
+static uint8_t *sketch_counter(const Count_Min_Sketch *sketch, uint64_t hash, int row)
+{
+    uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1;
+    return &sketch->counters[(size_t)row * (sketch->mask + 1) + ((h1 + (uint32_t)row * h2) & sketch->mask)];
+}
+
+// Count one use of page, halving every counter once sample_size uses were counted (aging)
+void sketch_increment(Count_Min_Sketch *sketch, int page)
+{
+    uint64_t hash = splitmix64((uint32_t)page);
+    int added = 0;
+    for (int row = 0; row < SKETCH_DEPTH; ++row)
+    {
+        uint8_t *counter = sketch_counter(sketch, hash, row);
+        if (*counter < SKETCH_MAX)
+        {
+            (*counter)++;
+            added = 1;
+        }
+    }
+    if (added && ++sketch->additions >= sketch->sample_size)
+    {
+        size_t n = (size_t)(sketch->mask + 1) * SKETCH_DEPTH;
+        for (size_t i = 0; i < n; ++i)
+            sketch->counters[i] >>= 1;
+        sketch->additions /= 2;
+    }
+}
+
+// Estimated recent uses of page, the smallest of its counters
+int sketch_estimate(const Count_Min_Sketch *sketch, int page)
+{
+    uint64_t hash = splitmix64((uint32_t)page);
+    int estimate = SKETCH_MAX;
+    for (int row = 0; row < SKETCH_DEPTH; ++row)
+    {
+        int count = *sketch_counter(sketch, hash, row);
+        if (count < estimate)
+            estimate = count;
+    }
+    return estimate;
+}
+
+void sketch_free(Count_Min_Sketch *sketch)
+{
+    free(sketch->counters);
+    sketch->counters = NULL;
+}
+
+// Setup hook for W-TinyLFU, a 1% LRU window in front of an SLRU main cache that is 80% protected
+void initializeTinyLFU(Algorithm_Data *data)
+{
+    TinyLFU_Data *tlfu = calloc(1, sizeof(TinyLFU_Data));
+    if (!tlfu || ghost_cache_init(&tlfu->cache, data, 0) != 0 || sketch_init(&tlfu->sketch, data->num_frames) != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory for W-TinyLFU data\n");
+        exit(1);
+    }
+    tlfu->window_max = data->num_frames / 100 > 1 ? data->num_frames / 100 : 1;
+    tlfu->main_max = data->num_frames - tlfu->window_max;
+    tlfu->protected_max = (int)(tlfu->main_max * 0.8);
+    data->extra = tlfu;
+    data->free_extra = &freeTinyLFU;
+}
+
+void freeTinyLFU(void *extra)
+{
+    TinyLFU_Data *tlfu = extra;
+    if (!tlfu)
+        return;
+    ghost_cache_free(&tlfu->cache);
+    sketch_free(&tlfu->sketch);
+    free(tlfu);
+}
+
+void checkpointTinyLFU(Checkpoint *cp, Algorithm_Data *data)
+{
+    TinyLFU_Data *tlfu = data->extra;
+    Count_Min_Sketch *sketch = &tlfu->sketch;
+    checkpoint_ghost_cache(cp, &tlfu->cache);
+    checkpoint_match(cp, sketch->mask, "sketch width");
+    if (!cp->failed)
+        checkpoint_bytes(cp, sketch->counters, (size_t)(sketch->mask + 1) * SKETCH_DEPTH);
+    CHECKPOINT(cp, sketch->additions);
+    CHECKPOINT(cp, sketch->sample_size);
+    CHECKPOINT(cp, tlfu->window_max);
+    CHECKPOINT(cp, tlfu->main_max);
+    CHECKPOINT(cp, tlfu->protected_max);
+}
+
+// W-TinyLFU Page Replacement Algorithm
+// Every miss enters a small LRU window. The page the window pushes out joins the main SLRU only
+// if the sketch has seen it more often than the page main would evict for it, so pages used once
+// cannot displace frequent ones, while the window still catches short bursts of reuse.
+int WTINYLFU(Algorithm_Data *data)
+{
+    TinyLFU_Data *tlfu = data->extra;
+    Ghost_Cache *gc = &tlfu->cache;
+    sketch_increment(&tlfu->sketch, data->page_ref);
+    Frame *framep = ghost_cache_get(gc, data->page_ref);
+    if (framep != NULL)
+    {
+        if (framep->extra == TLFU_WINDOW)
+            ghost_cache_move(gc, framep, TLFU_WINDOW);
+        else
+        { // A hit in main is protected, pushing the oldest protected page back to probation
+            ghost_cache_move(gc, framep, TLFU_PROTECTED);
+            if (gc->sizes[TLFU_PROTECTED] > tlfu->protected_max)
+                ghost_cache_move(gc, TAILQ_FIRST(&gc->lists[TLFU_PROTECTED]), TLFU_PROBATION);
+        }
+        framep->time = current_tick(data);
+        data->hits++;
+        return 0;
+    }
+
+    data->misses++;
+    if (gc->sizes[TLFU_WINDOW] >= tlfu->window_max)
+    { // The window is full, its oldest page is a candidate for main
+        Frame *candidate = TAILQ_FIRST(&gc->lists[TLFU_WINDOW]);
+        if (gc->sizes[TLFU_PROBATION] + gc->sizes[TLFU_PROTECTED] < tlfu->main_max)
+            ghost_cache_move(gc, candidate, TLFU_PROBATION);
+        else
+        {
+            Frame *victim = TAILQ_FIRST(&gc->lists[TLFU_PROBATION]);
+            if (victim == NULL)
+                victim = TAILQ_FIRST(&gc->lists[TLFU_PROTECTED]);
+            if (victim != NULL && sketch_estimate(&tlfu->sketch, candidate->page) >
+                                      sketch_estimate(&tlfu->sketch, victim->page))
+            {
+                ghost_cache_move(gc, candidate, TLFU_PROBATION);
+                candidate = victim;
+            }
+            ghost_cache_unlist(gc, candidate);
+            ghost_cache_evict(data, gc, candidate);
+        }
+    }
+    framep = ghost_cache_load(gc, data->page_ref);
+    ghost_cache_move(gc, framep, TLFU_WINDOW);
+    framep->time = current_tick(data);
+    return 1;
+}
+
+// Setup hook for CLOCK-Pro, non-resident cold pages are bounded by num_frames
+void initializeClockPro(Algorithm_Data *data)
+{
+    CLOCKPRO_Data *cp = ghost_policy_create(data, sizeof(CLOCKPRO_Data), data->num_frames);
+    TAILQ_INIT(&cp->clock);
+    cp->cold_target = 1;
+}
+
+// Checkpoint hook for CLOCK-Pro, the clock and its hands run over the ghost cache's frames
+void checkpointClockPro(Checkpoint *cp, Algorithm_Data *data)
+{
+    CLOCKPRO_Data *clockpro = data->extra;
+    checkpoint_ghost_cache(cp, &clockpro->cache);
+    checkpoint_queue(cp, &clockpro->clock, 0);
+    checkpoint_frame(cp, &clockpro->hand_hot);
+    checkpoint_frame(cp, &clockpro->hand_cold);
+    checkpoint_frame(cp, &clockpro->hand_test);
+    CHECKPOINT(cp, clockpro->hot);
+    CHECKPOINT(cp, clockpro->cold);
+    CHECKPOINT(cp, clockpro->cold_target);
+}
+
+// Page after framep on the clock, wrapping around
+static Frame *clockproNext(CLOCKPRO_Data *cp, Frame *framep)
+{
+    Frame *next = TAILQ_NEXT(framep, order);
+    return next != NULL ? next : TAILQ_FIRST(&cp->clock);
+}
+
+// Take a page off the clock, moving any hand on it to the next page
+static void clockproUnlink(CLOCKPRO_Data *cp, Frame *framep)
+{
+    Frame *next = clockproNext(cp, framep);
+    if (next == framep)
+        next = NULL; // it was the only page
+    if (cp->hand_hot == framep)
+        cp->hand_hot = next;
+    if (cp->hand_cold == framep)
+        cp->hand_cold = next;
+    if (cp->hand_test == framep)
+        cp->hand_test = next;
+    TAILQ_REMOVE(&cp->clock, framep, order);
+}
+
+// Put a page at the list head, right behind HAND_hot, so every hand reaches it last
+static void clockproInsert(CLOCKPRO_Data *cp, Frame *framep)
+{
+    if (cp->hand_hot == NULL)
+    {
+        TAILQ_INSERT_TAIL(&cp->clock, framep, order);
+        cp->hand_hot = cp->hand_cold = cp->hand_test = framep;
+        return;
+    }
+    TAILQ_INSERT_BEFORE(cp->hand_hot, framep, order);
+}
+
+// End the test period of a cold page without a reuse, the cold share was too large
+// A non-resident page has nothing left to tell and leaves the clock
+static void clockproEndTest(CLOCKPRO_Data *cp, Frame *framep)
+{
+    framep->extra &= ~CLOCKPRO_TEST;
+    if (cp->cold_target > 1)
+        cp->cold_target--;
+    if (framep->index < 0)
+    {
+        clockproUnlink(cp, framep);
+        ghost_cache_forget(&cp->cache, framep);
+    }
+}
+
+// Run HAND_hot until one hot page turns cold, ending the test periods it passes
+static void clockproRunHot(CLOCKPRO_Data *cp)
+{
+    for (;;)
+    {
+        Frame *framep = cp->hand_hot;
+        cp->hand_hot = clockproNext(cp, framep);
+        if (framep->extra & CLOCKPRO_HOT)
+        {
+            if (framep->extra & CLOCKPRO_REF)
+                framep->extra &= ~CLOCKPRO_REF;
+            else
+            {
+                framep->extra = 0; // cold, resident, outside any test period
+                cp->hot--;
+                cp->cold++;
+                return;
+            }
+        }
+        else if (framep->extra & CLOCKPRO_TEST)
+            clockproEndTest(cp, framep);
+    }
+}
+
+// Run HAND_test until one non-resident page leaves the clock
+static void clockproRunTest(CLOCKPRO_Data *cp)
+{
+    for (;;)
+    {
+        Frame *framep = cp->hand_test;
+        cp->hand_test = clockproNext(cp, framep);
+        if (!(framep->extra & CLOCKPRO_HOT) && (framep->extra & CLOCKPRO_TEST))
+        {
+            int resident = framep->index >= 0;
+            clockproEndTest(cp, framep);
+            if (!resident)
+                return;
+        }
+    }
+}
+
+// Swap an evicted cold page for a ghost in the same place on the clock, hands included
+static void clockproKeepGhost(Algorithm_Data *data, CLOCKPRO_Data *cp, Frame *framep)
+{
+    Frame *prev = TAILQ_PREV(framep, Frame_Queue, order);
+    int page = framep->page;
+    int on_hot = cp->hand_hot == framep, on_cold = cp->hand_cold == framep, on_test = cp->hand_test == framep;
+    TAILQ_REMOVE(&cp->clock, framep, order);
+    ghost_cache_evict(data, &cp->cache, framep);
+    Frame *ghost = ghost_cache_remember(&cp->cache, page);
+    ghost->extra = CLOCKPRO_TEST;
+    if (prev != NULL)
+        TAILQ_INSERT_AFTER(&cp->clock, prev, ghost, order);
+    else
+        TAILQ_INSERT_HEAD(&cp->clock, ghost, order);
+    if (on_hot)
+        cp->hand_hot = ghost;
+    if (on_cold)
+        cp->hand_cold = ghost;
+    if (on_test)
+        cp->hand_test = ghost;
+}
+
+// Run HAND_cold until it evicts a cold resident page
+// A referenced cold page in its test period turns hot, one outside it starts a new test period
+static void clockproRunCold(Algorithm_Data *data, CLOCKPRO_Data *cp)
+{
+    for (;;)
+    {
+        Frame *framep = cp->hand_cold;
+        cp->hand_cold = clockproNext(cp, framep);
+        if ((framep->extra & CLOCKPRO_HOT) || framep->index < 0)
+            continue;
+        if (framep->extra & CLOCKPRO_REF)
+        {
+            clockproUnlink(cp, framep);
+            if (framep->extra & CLOCKPRO_TEST)
+            {
+                framep->extra = CLOCKPRO_HOT;
+                cp->cold--;
+                cp->hot++;
+            }
+            else
+                framep->extra = CLOCKPRO_TEST;
+            clockproInsert(cp, framep);
+            while (cp->hot > cp->cache.capacity - cp->cold_target)
+                clockproRunHot(cp);
+            continue;
+        }
+        // Unreferenced, evict it. In its test period it stays on the clock as a ghost.
+        if (framep->extra & CLOCKPRO_TEST)
+            clockproKeepGhost(data, cp, framep);
+        else
+        {
+            clockproUnlink(cp, framep);
+            ghost_cache_evict(data, &cp->cache, framep);
+        }
+        cp->cold--;
+        return;
+    }
 }
 
+// CLOCK-Pro Page Replacement Algorithm
+// One clock holds hot pages, cold resident pages and recently evicted cold pages still in their
+// test period. A cold page reused within its test period has a reuse distance shorter than the
+// oldest hot page's and turns hot, and such reuses grow the cold share of the frames while test
+// periods that run out shrink it. A hit only sets the reference bit, like CLOCK.
+int CLOCKPRO(Algorithm_Data *data)
+{
+    CLOCKPRO_Data *cp = data->extra;
+    Ghost_Cache *gc = &cp->cache;
+    Frame *framep = ghost_cache_get(gc, data->page_ref);
+    if (framep != NULL && framep->index >= 0)
+    {
+        framep->extra |= CLOCKPRO_REF;
+        framep->time = current_tick(data);
+        data->hits++;
+        return 0;
+    }
 
+    data->misses++;
+    int hot = framep != NULL;
+    if (hot)
+    { // Reused in its test period, after the cold share let it go
+        if (cp->cold_target < gc->capacity)
+            cp->cold_target++;
+        clockproUnlink(cp, framep);
+        ghost_cache_forget(gc, framep);
+    }
+    else if (TAILQ_EMPTY(&gc->spare))
+        clockproRunTest(cp); // Room for the ghost an eviction may leave
+    if (gc->resident == gc->capacity)
+        clockproRunCold(data, cp);
+    framep = ghost_cache_load(gc, data->page_ref);
+    framep->extra = hot ? CLOCKPRO_HOT : CLOCKPRO_TEST;
+    if (hot)
+        cp->hot++;
+    else
+        cp->cold++;
+    clockproInsert(cp, framep);
+    while (cp->hot > gc->capacity - cp->cold_target)
+        clockproRunHot(cp);
+    framep->time = current_tick(data);
+    return 1;
+}
 
-
-// Add victim frame evicted from page table to list of victims
-int add_victim(struct Frame_List *victim_list, struct Frame *frame)
+// Function to print results after algo is run
+int print_help(const char *binary)
 {
-    if (debug)
-        printf("Victim index: %d, Page: %d\n", frame->index, frame->page);
-    struct Frame *victim = malloc(sizeof(Frame));
-    *victim = *frame;
-    victim->index = 1;
-    LIST_INSERT_HEAD(victim_list, victim, frames);
+    printf("usage: %s input_file algorithm num_frames show_process [debug] [options]\n", binary);
+    printf("   input file    - input test file\n");
+    printf("   algorithm    - page algorithm to use {LRU, CLOCK, AGING, OPTIMAL, ARC, 2Q, LIRS, W-TinyLFU, CLOCK-Pro, ...},\n");
+    printf("                  a comma list such as LRU,ARC,2Q, or a one-letter code ('a' runs all)\n");
+    printf("   num_frames   - number of page frames {int > 0}\n");
+    printf("   show_process - print page table after each ref is processed {1 or 0}\n");
+    printf("   debug        - verbose debugging output {1 or 0}\n");
+    printf("options:\n");
+    printf("   --stream     - page every ref in file order with bounded memory (no %d ref cap)\n", max_page_calls);
+    printf("   --dense      - number the trace's pages 0, 1, 2... in first-seen order, so per-page arrays\n");
+    printf("                  (OPTIMAL, --mrc) fit the distinct pages and sparse pages are all tracked\n");
+    printf("   --ingest-threads N - threads parsing a text trace (default one per core and MiB of text)\n");
+    printf("   --window N   - refs OPTIMAL-W (and OPTIMAL when streaming) may look ahead (default %d)\n", STREAM_DEFAULT_WINDOW);
+    printf("   --prefetch P - pair every online algorithm with a prefetcher: seq[:D] (next D pages on a miss)\n");
+    printf("                  or stride[:D] (D pages along a repeated stride), reports useful and wasted prefetches\n");
+    printf("   --batch N    - replay blocks of N refs through each algorithm in turn, timed per block\n");
+    printf("   --frames S   - sweep frame counts, e.g. 1..65536:pow2, 16..256:16 or 8,16,32 (ignores num_frames)\n");
+    printf("   --threads N  - run algorithms (or sweep jobs) in parallel on N worker threads\n");
+    printf("   --mrc        - LRU hit ratio for every frame count (or --frames) from one stack distance pass\n");
+    printf("   --sample-rate R  - SHARDS: keep refs to a hashed R of the pages, scale frames (or distances) by R\n");
+    printf("   --sample-size S  - SHARDS: fixed budget of S sampled pages, the rate drops to fit it\n");
+    printf("   --sample-error   - also run exactly and report the error of the sampled results\n");
+    printf("   --simd K     - frame scan kernels: auto (default), avx512, avx2, neon or scalar\n");
+    printf("   --lfru-ratio R - share of LFRU frames in its LRU partition, the rest are LFU (default %.2f)\n", LFRU_DEFAULT_RATIO);
+    printf("   --pid-aware  - key refs by (pid, page), so processes never share a page\n");
+    printf("   --tenants M  - per-pid results: global (one shared page table) or static[:PID=W,...] (a page\n");
+    printf("                  table per pid sized by weight W, default 1), implies --pid-aware\n");
+    printf("   --ucp-interval N - refs between UCP repartitions (default 16 * num_frames)\n");
+    printf("   --assoc W    - set-associative: num_frames lines in sets of W ways, each set replaced on its own\n");
+    printf("   --line-size B - divide refs (e.g. byte addresses) into blocks of B, a power of two\n");
+    printf("   --set-index I - how --assoc maps blocks to sets: bits (low bits, default) or hash\n");
+    printf("   --frame-bytes B - cache num_frames * B bytes of objects sized by the trace's third column,\n");
+    printf("                  with the size-aware algorithms (SIZE-LRU, GDSF, LRU-2) only\n");
+    printf("   --concurrent T - benchmark lock-free CLOCK against a mutex LRU and a sharded LRU on 1, 2, 4...\n");
+    printf("                  T threads, the trace split over them by pid (ignores algorithm)\n");
+    printf("   --seed N     - seed of the generated workloads (default 1)\n");
+    printf("   --gen-refs N - refs of a generated workload (default %d)\n", gen_refs);
+    printf("   --gen-pages N - distinct pages of a generated workload (default %d)\n", gen_pages);
+    printf("   --bench FILE - write hit ratio, ns/ref and peak RSS of every algorithm x frame count to FILE,\n");
+    printf("                  JSON if it ends in .json, else CSV (frames from --frames, else num_frames / 4, x1, x4)\n");
+    printf("   --output FILE - write the final stats to FILE, JSON if it ends in .json, else CSV\n");
+    printf("   --interval K - every K refs, write each algorithm's hit ratio, evictions and ns/ref over the last\n");
+    printf("                  K refs to --interval-out FILE (default intervals.csv, JSON if it ends in .json)\n");
+    printf("   --latency    - print ns/ref and p50/p99/p999 hit and miss path latencies per algorithm\n");
+    printf("   --latency-sample N - batched and parallel runs time one ref in N for the --latency percentiles (default %d)\n", latency_sample);
+    printf("   --victims M  - victim history: off (count only, default), ring[:N] (last N, default %d) or pool (all)\n", victim_capacity);
+    printf("   --adaptive L - candidates of ADAPTIVE, which follows whichever is missing least on sampled\n");
+    printf("                  leader caches (default %s)\n", ADAPTIVE_DEFAULT);
+    printf("   --adaptive-epoch N - sampled refs between ADAPTIVE's decisions (default %d)\n", adaptive_epoch);
+    printf("   --shadow N   - classify misses as compulsory, capacity or policy (page evicted within the last N\n");
+    printf("                  refs) and print hit and miss counts by reuse distance for every algorithm\n");
+    printf("   --checkpoint FILE - save every selected algorithm's state to FILE at the end of the run\n");
+    printf("   --checkpoint-every K - also save it every K refs, replacing FILE atomically\n");
+    printf("   --checkpoint-at N - stop once N refs of the trace are paged and save there\n");
+    printf("   --resume FILE - continue from a checkpoint of the same trace and options\n");
+    printf("   --warm FILE  - start from a checkpoint's caches with zeroed counts, replaying the trace from its start\n");
+    printf("input_file may be a generated workload: gen:uniform, gen:zipf[:ALPHA], gen:scan[:LOOP], gen:shift[:WSS],\n");
+    printf("gen:mix, a comma list of them (with --bench) or gen:suite (%s)\n", BENCH_SUITE);
+    printf("binary traces are detected automatically and replayed in full from an mmap\n");
+    printf("convert: %s --convert input_file output_file [--varint] [--dense] [--ingest-threads N]\n", binary);
     return 0;
 }
 
-// OPTIMAL Page Replacement Algorithm
-int OPTIMAL(Algorithm_Data *data)
-{
-    Frame *framep = data->page_table.lh_first, *victim = NULL;
-    int fault = 0;
+// UCP section
+// Utility-based cache partitioning (Qureshi & Patt) over one shared page table. Each tenant
+// keeps its own LRU list, and a utility monitor (UMON) per tenant records the LRU stack
+// distance of its refs as if it had the whole cache. Every interval refs the frames are
+// redivided in units by a lookahead greedy over those miss curves, then an eviction comes
+// from the missing tenant while it holds its quota, else from the tenant most over its own.
 
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
+// Make room for tenant state up to tenant, -1 if out of memory
+static int ucpReserve(Algorithm_Data *data, UCP_Data *ucp, int tenant)
+{
+    if (tenant < ucp->tenants)
+        return 0;
+    int size = tenant + 1;
+    struct Frame_Queue **lru = realloc(ucp->lru, sizeof(struct Frame_Queue *) * size);
+    if (lru)
+        ucp->lru = lru;
+    int *occupancy = lru ? realloc(ucp->occupancy, sizeof(int) * size) : NULL;
+    if (occupancy)
+        ucp->occupancy = occupancy;
+    int *quota = occupancy ? realloc(ucp->quota, sizeof(int) * size) : NULL;
+    if (quota)
+        ucp->quota = quota;
+    Stack_Distance *monitors = quota ? realloc(ucp->monitors, sizeof(Stack_Distance) * size) : NULL;
+    if (!monitors)
     {
-        framep = framep->frames.le_next;
+        fprintf(stderr, "Failed to allocate memory for UCP tenants\n");
+        return -1;
     }
-
-    if (framep == NULL)
+    ucp->monitors = monitors;
+    for (int t = ucp->tenants; t < size; t++)
     {
-        size_t i, j;
-        int *optimum_find_test = malloc(sizeof(int) * page_ref_upper_bound);
-        if (optimum_find_test == NULL)
-        {
-            fprintf(stderr, "Memory allocation failed for optimum_find_test\n");
-            return -1; // or handle the error as suitable
-        }
-
-        for (i = 0; i < page_ref_upper_bound; ++i)
+        // Queue heads are allocated one by one, a TAILQ head must not move
+        // Monitors only steer partitions between tenants, without them UCP is LRU
+        ucp->lru[t] = malloc(sizeof(struct Frame_Queue));
+        memset(&ucp->monitors[t], 0, sizeof(Stack_Distance));
+        if (!ucp->lru[t] || (tenant_mode != TENANT_OFF && stack_distance_init(&ucp->monitors[t], 2 * data->num_frames) != 0))
         {
-            optimum_find_test[i] = -1;
+            free(ucp->lru[t]);
+            return -1;
         }
+        TAILQ_INIT(ucp->lru[t]);
+        ucp->occupancy[t] = 0;
+        ucp->quota[t] = 0;
+        ucp->tenants++;
+    }
+    // A tenant the partition has not measured yet would get no frames, share them until it has
+    ucp->partitioned = 0;
+    return 0;
+}
 
-        Page_Ref *page = page_refs.lh_first;
-        int all_found = 0;
-        j = 0;
+// Refs of tenant that would hit with units units of unit frames each, from its UMON
+static double ucpUtility(const UCP_Data *ucp, int tenant, int units, int unit)
+{
+    const Stack_Distance *sd = &ucp->monitors[tenant];
+    double hits = 0;
+    for (int d = 1; d <= units * unit && d < sd->hist_size; d++)
+        hits += (double)sd->hist[d];
+    return hits;
+}
 
-        while (page != NULL && !all_found)
+// Lookahead partitioning: repeatedly hand the tenant with the best hits per unit the units
+// that earn it, which sees past the flat stretches of a miss curve that a plain greedy stops at
+static void ucpRepartition(Algorithm_Data *data, UCP_Data *ucp)
+{
+    int tenants = ucp->tenants;
+    int units = data->num_frames < UCP_UNITS ? data->num_frames : UCP_UNITS;
+    int unit = data->num_frames / units;
+    int balance = units;
+    int *alloc = ucp->quota;
+    for (int t = 0; t < tenants; t++)
+    {
+        alloc[t] = tenants <= units ? 1 : 0;
+        balance -= alloc[t];
+    }
+    while (balance > 0)
+    {
+        int winner = -1, winner_units = 0;
+        double best = 0;
+        for (int t = 0; t < tenants; t++)
         {
-            if (page->page_num < page_ref_upper_bound)
-            {
-                if (optimum_find_test[page->page_num] == -1)
-                {
-                    optimum_find_test[page->page_num] = j++;
-                }
-            }
-            page = page->pages.le_next;
-
-            all_found = 1;
-            for (i = 0; i < page_ref_upper_bound; ++i)
+            double base = ucpUtility(ucp, t, alloc[t], unit);
+            for (int k = 1; k <= balance; k++)
             {
-                if (optimum_find_test[i] == -1)
+                double gain = (ucpUtility(ucp, t, alloc[t] + k, unit) - base) / k;
+                if (gain > best)
                 {
-                    all_found = 0;
-                    break;
+                    best = gain;
+                    winner = t;
+                    winner_units = k;
                 }
             }
         }
+        if (winner == -1)
+            break; // No tenant gains from more frames
+        alloc[winner] += winner_units;
+        balance -= winner_units;
+    }
+    // Units no tenant wants are spread evenly
+    for (int t = 0; balance > 0; t = (t + 1) % tenants, balance--)
+        alloc[t]++;
+    int largest = 0;
+    for (int t = 0; t < tenants; t++)
+    {
+        alloc[t] *= unit;
+        if (alloc[t] > alloc[largest])
+            largest = t;
+    }
+    alloc[largest] += data->num_frames - units * unit; // frames that do not fill a unit
+    for (int t = 0; t < tenants; t++)
+    {
+        if (t < data->num_tenants)
+            data->tenants[t].frames = alloc[t];
+        // Age the monitors so the next partition follows recent behaviour
+        Stack_Distance *sd = &ucp->monitors[t];
+        for (int d = 0; d < sd->hist_size; d++)
+            sd->hist[d] >>= 1;
+    }
+    ucp->partitioned = 1;
+}
 
-        framep = data->page_table.lh_first;
-        while (framep != NULL)
+// Tenant to evict from when tenant misses in a full cache
+static int ucpVictimTenant(const UCP_Data *ucp, int tenant)
+{
+    int victim = -1, over = 0;
+    if (ucp->partitioned)
+    {
+        if (ucp->occupancy[tenant] > 0 && ucp->occupancy[tenant] >= ucp->quota[tenant])
+            return tenant;
+        for (int t = 0; t < ucp->tenants; t++)
         {
-            if (victim == NULL || (framep->page < page_ref_upper_bound && optimum_find_test[framep->page] > optimum_find_test[victim->page]))
+            if (ucp->occupancy[t] - ucp->quota[t] > over)
             {
-                victim = framep;
+                over = ucp->occupancy[t] - ucp->quota[t];
+                victim = t;
             }
-            framep = framep->frames.le_next;
-        }
-
-        if (victim != NULL)
-        {
-            if (debug)
-                printf("Victim selected: %d, Page: %d\n", victim->index, victim->page);
-            add_victim(&data->victim_list, victim);
-            victim->page = last_page_ref;
-            time(&victim->time);
-            victim->extra = counter;
-            fault = 1;
         }
-
-        free(optimum_find_test);
-    }
-    else if (framep->page == -1)
-    { // Use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = counter;
-        fault = 1;
-    }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra = counter;
+        if (victim != -1)
+            return victim;
     }
-    if (debug)
+    // Until the first partition the cache is one LRU: the oldest of the tenants' LRU pages
+    uint64_t oldest = UINT64_MAX;
+    for (int t = 0; t < ucp->tenants; t++)
     {
-        printf("Page Ref: %d\n", last_page_ref);
-        for (framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
-            printf("Slot: %d, Page: %d, Time used: %d\n", framep->index, framep->page, framep->extra);
+        Frame *head = ucp->lru[t]->tqh_first;
+        if (head != NULL && head->time < oldest)
+        {
+            oldest = head->time;
+            victim = t;
+        }
     }
-    if (fault == 1)
-        data->misses++;
-    else
-        data->hits++;
-
-    return fault;
+    return victim;
 }
 
-// int RANDOM(Algorithm_Data *data)
-int RANDOM(Algorithm_Data *data)
+void initializeUCP(Algorithm_Data *data)
 {
-    struct Frame *framep = data->page_table.lh_first,
-                 *victim = NULL;
-    int rand_victim = rand() % num_frames;
-    int fault = 0;
-    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
-    {
-        if (framep->index == rand_victim) // rand
-            victim = framep;
-        framep = framep->frames.le_next;
-    }
-    if (framep == NULL)
-    { // It's a miss, kill our victim
-        if (debug)
-            printf("Victim selected: %d, Page: %d\n", victim->index, victim->page);
-        add_victim(&data->victim_list, victim);
-        victim->page = last_page_ref;
-        time(&victim->time);
-        victim->extra = counter;
-        fault = 1;
-    }
-    else if (framep->page == -1)
-    { // Use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = counter;
-        fault = 1;
-    }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra = counter;
-    }
-    if (debug)
+    UCP_Data *ucp = calloc(1, sizeof(UCP_Data));
+    if (!ucp || page_map_init(&data->page_map, data->num_frames) != 0)
     {
-        printf("Page Ref: %d\n", last_page_ref);
-        for (framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
-            printf("Slot: %d, Page: %d, Time used: %d\n", framep->index, framep->page, framep->extra);
+        free(ucp);
+        return;
     }
-    if (fault == 1)
-        data->misses++;
-    else
-        data->hits++;
-    return fault;
+    TAILQ_INIT(&ucp->free);
+    for (Frame *framep = data->page_table.lh_first; framep != NULL; framep = framep->frames.le_next)
+        TAILQ_INSERT_TAIL(&ucp->free, framep, order);
+    ucp->interval = ucp_interval > 0 ? ucp_interval : 16 * data->num_frames;
+    data->extra = ucp;
+    data->free_extra = &freeUCP;
+    if (ucpReserve(data, ucp, 0) != 0)
+        exit(1);
 }
 
-// FIFO Page Replacement Algorithm
-int FIFO(Algorithm_Data *data)
+void freeUCP(void *extra)
 {
-    struct Frame *framep = data->page_table.lh_first,
-                 *victim = NULL;
-    int fault = 0;
-    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
+    UCP_Data *ucp = extra;
+    for (int t = 0; t < ucp->tenants; t++)
     {
-        if (victim == NULL || framep->time > victim->time)
-        { // No victim yet or frame older than victim
-            victim = framep;
-        }
-        framep = framep->frames.le_next;
-    }
-    /* Make a decision */
-    if (framep == NULL)
-    { // It's a miss, kill our victim
-        if (debug)
-            printf("Victim selected: %d, Page: %d\n", victim->index, victim->page);
-        add_victim(&data->victim_list, victim);
-        victim->page = last_page_ref;
-        time(&victim->time);
-        victim->extra = counter;
-        fault = 1;
-    }
-    else if (framep->page == -1)
-    { // Can use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = counter;
-        fault = 1;
+        free(ucp->lru[t]);
+        stack_distance_free(&ucp->monitors[t]);
     }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra = counter;
-    }
-    if (fault == 1)
-        data->misses++;
-    else
-        data->hits++;
-    return fault;
+    free(ucp->lru);
+    free(ucp->occupancy);
+    free(ucp->quota);
+    free(ucp->monitors);
+    free(ucp);
 }
 
-// LRU Page Replacement Algorithm
-int LRU(Algorithm_Data *data)
+// Checkpoint hook for UCP, state for as many tenants as were saved is reserved first
+void checkpointUCP(Checkpoint *cp, Algorithm_Data *data)
 {
-    struct Frame *framep = data->page_table.lh_first,
-                 *victim = NULL;
-    int fault = 0;
-    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
+    UCP_Data *ucp = data->extra;
+    int tenants = ucp->tenants;
+    checkpoint_match(cp, ucp->interval, "--ucp-interval");
+    CHECKPOINT(cp, tenants);
+    if (cp->loading && !cp->failed && (tenants < 1 || ucpReserve(data, ucp, tenants - 1) != 0))
+        checkpoint_fail(cp, "UCP tenants");
+    for (int t = 0; t < ucp->tenants && !cp->failed; t++)
     {
-        if (victim == NULL || framep->time < victim->time)
-            victim = framep; // No victim yet or frame older than victim
-        framep = framep->frames.le_next;
-    }
-    /* Make a decision */
-    if (framep == NULL)
-    { // It's a miss, kill our victim
-        if (debug)
-            printf("Victim selected: %d, Page: %d\n", victim->index, victim->page);
-        add_victim(&data->victim_list, victim);
-        victim->page = last_page_ref;
-        time(&victim->time);
-        victim->extra = counter;
-        fault = 1;
+        checkpoint_queue(cp, ucp->lru[t], 0);
+        checkpoint_stack_distance(cp, &ucp->monitors[t]);
     }
-    else if (framep->page == -1)
-    { // Can use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = counter;
-        fault = 1;
-    }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra = counter;
-    }
-    if (fault == 1)
-        data->misses++;
-    else
-        data->hits++;
-    return fault;
+    if (cp->failed)
+        return;
+    checkpoint_bytes(cp, ucp->occupancy, sizeof(int) * ucp->tenants);
+    checkpoint_bytes(cp, ucp->quota, sizeof(int) * ucp->tenants);
+    checkpoint_queue(cp, &ucp->free, 0);
+    CHECKPOINT(cp, ucp->partitioned);
+    CHECKPOINT(cp, ucp->refs);
 }
 
-// CLOCK Page Replacement Algorithm
-int CLOCK(Algorithm_Data *data)
+// UCP Page Replacement Algorithm
+// Without --tenants every ref is tenant 0 and UCP is LRU
+int UCP(Algorithm_Data *data)
 {
-    static Frame *clock_hand = NULL; // Clock needs a hand
-    Frame *framep = data->page_table.lh_first;
+    UCP_Data *ucp = data->extra;
+    int tenant = data->tenant;
+    if (ucpReserve(data, ucp, tenant) != 0)
+        exit(1);
+    if (tenant_mode != TENANT_OFF)
+        stack_distance_access(&ucp->monitors[tenant], data->page_ref);
+    Frame *framep = page_map_get(&data->page_map, data->page_ref);
     int fault = 0;
-    /* Forward traversal. */
-    /* Find target (hit), empty page slot (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
-        framep = framep->frames.le_next;
-    /* Make a decision */
     if (framep != NULL)
     {
-        if (framep->page == -1)
+        TAILQ_REMOVE(ucp->lru[framep->extra], framep, order);
+    }
+    else
+    { // It's a miss, use a free frame or the LRU page of the victim tenant
+        framep = ucp->free.tqh_first;
+        if (framep != NULL)
         {
-            framep->page = last_page_ref;
-            framep->extra = 0;
-            fault = 1;
+            TAILQ_REMOVE(&ucp->free, framep, order);
         }
         else
-        { // Found the page, update its R bit to 0
-            framep->extra = 0;
-        }
-    }
-    else // Use the hand to find our victim
-    {
-        while (clock_hand == NULL || clock_hand->extra == 0)
         {
-            if (clock_hand == NULL)
-            {
-                clock_hand = data->page_table.lh_first;
-            }
-            else
-            {
-                clock_hand->extra = 1;
-                clock_hand = clock_hand->frames.le_next;
-            }
+            int victim = ucpVictimTenant(ucp, tenant);
+            framep = ucp->lru[victim]->tqh_first;
+            TAILQ_REMOVE(ucp->lru[victim], framep, order);
+            ucp->occupancy[victim]--;
+            if (debug)
+                printf("Victim selected: %d, Page: %d\n", framep->index, framep->page);
+            add_victim(data, framep);
+            page_map_remove(&data->page_map, framep->page);
         }
-        add_victim(&data->victim_list, clock_hand);
-        clock_hand->page = last_page_ref;
-        clock_hand->extra = 0;
+        framep->page = data->page_ref;
+        framep->extra = tenant;
+        page_map_put(&data->page_map, data->page_ref, framep);
+        ucp->occupancy[tenant]++;
         fault = 1;
     }
+    TAILQ_INSERT_TAIL(ucp->lru[framep->extra], framep, order);
+    framep->time = current_tick(data);
+    if (++ucp->refs >= ucp->interval)
+    {
+        ucpRepartition(data, ucp);
+        ucp->refs = 0;
+    }
     if (fault == 1)
         data->misses++;
     else
@@ -701,532 +8136,1030 @@ int CLOCK(Algorithm_Data *data)
     return fault;
 }
 
-// NFU Page Replacement Algorithm
-int NFU(Algorithm_Data *data)
+// Set-associative section
+// With --assoc the num_frames lines form sets of assoc_ways ways and a block only ever
+// competes with the blocks of its own set. Policies in algos[] run one partition per set,
+// the set-local ones below keep every set in one compact block instead, like hardware.
+// Without --assoc the set-local policies see a single fully associative set.
+
+// Set of a block: its low bits, or a hash of it with --set-index hash
+int set_of(int block, int sets)
 {
-    struct Frame *framep = data->page_table.lh_first,
-                 *victim = NULL;
-    int fault = 0;
-    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
+    if (set_index_mode == SET_INDEX_HASH)
+        return (int)(splitmix64((uint32_t)block) % (uint64_t)sets);
+    return block & (sets - 1);
+}
+
+int set_cache_init(Set_Cache *sc, int sets, int ways)
+{
+    memset(sc, 0, sizeof(Set_Cache));
+    sc->num_sets = sets;
+    sc->ways = ways;
+    for (sc->leaves = 1; sc->leaves < ways; sc->leaves <<= 1)
+        ;
+    int bytes = (2 + ways) * (int)sizeof(int) + ways + sc->leaves - 1;
+    sc->stride = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    sc->psel = DRRIP_PSEL_MAX / 2;
+    sc->blocks = aligned_alloc(CACHE_LINE, (size_t)sc->stride * sets);
+    if (!sc->blocks)
     {
-        if (victim == NULL || framep->extra < victim->extra)
-            victim = framep; // No victim or frame used fewer times
-        framep = framep->frames.le_next;
-    }
-    /* Make a decision */
-    if (framep == NULL)
-    { // It's a miss, kill our victim
-        add_victim(&data->victim_list, victim);
-        victim->page = last_page_ref;
-        time(&victim->time);
-        victim->extra = 0;
-        fault = 1;
+        fprintf(stderr, "Failed to allocate memory for set-associative cache\n");
+        return -1;
     }
-    else if (framep->page == -1)
-    { // Can use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = 0;
-        fault = 1;
-    }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra++;
-    }
-    if (fault == 1)
-        data->misses++;
-    else
-        data->hits++;
-    return fault;
+    memset(sc->blocks, 0, (size_t)sc->stride * sets);
+    return 0;
 }
 
-// AGING Page Replacement Algorithm
-int AGING(Algorithm_Data *data)
+unsigned char *set_cache_set(const Set_Cache *sc, int set)
 {
-    struct Frame *framep = data->page_table.lh_first,
-                 *victim = NULL;
-    int fault = 0;
-    /* Find target (hit), empty page index (miss), or victim to evict (miss) */
-    while (framep != NULL && framep->page > -1 && framep->page != last_page_ref)
+    return sc->blocks + (size_t)sc->stride * set;
+}
+
+// Layout of a set block, see Set_Cache
+#define SET_USED(set) (((int *)(set))[0])
+#define SET_MARKED(set) (((int *)(set))[1])
+#define SET_TAGS(set) ((int *)(set) + 2)
+#define SET_STATE(sc, set) ((set) + (2 + (sc)->ways) * sizeof(int))
+#define SET_TREE(sc, set) (SET_STATE(sc, set) + (sc)->ways)
+
+int set_cache_find(unsigned char *set, int block)
+{
+    return find_page_kernel(SET_TAGS(set), SET_USED(set), block);
+}
+
+void set_cache_free(Set_Cache *sc)
+{
+    free(sc->blocks);
+    memset(sc, 0, sizeof(Set_Cache));
+}
+
+void initializeSetCache(Algorithm_Data *data)
+{
+    Set_Cache *sc = malloc(sizeof(Set_Cache));
+    int ways = assoc_ways > 0 ? assoc_ways : data->num_frames;
+    if (!sc || set_cache_init(sc, data->num_frames / ways, ways) != 0)
     {
-        framep->extra /= 2;
-        if (victim == NULL || framep->extra < victim->extra)
-            victim = framep; // No victim or frame used rel less
-        framep = framep->frames.le_next;
+        free(sc);
+        exit(1);
     }
-    /* Make a decision */
-    if (framep == NULL)
-    { // It's a miss, kill our victim
-        add_victim(&data->victim_list, victim);
-        victim->page = last_page_ref;
-        time(&victim->time);
-        victim->extra = 0;
-        fault = 1;
-    }
-    else if (framep->page == -1)
-    { // Can use free page table index
-        framep->page = last_page_ref;
-        time(&framep->time);
-        framep->extra = 0;
-        fault = 1;
+    data->extra = sc;
+    data->free_extra = &freeSetCache;
+}
+
+void freeSetCache(void *extra)
+{
+    set_cache_free(extra);
+    free(extra);
+}
+
+// Checkpoint hook for the set-local policies, every set block is saved as it is
+void checkpointSetCache(Checkpoint *cp, Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    checkpoint_match(cp, sc->num_sets, "--assoc");
+    checkpoint_match(cp, sc->ways, "--assoc");
+    checkpoint_match(cp, sc->stride, "set layout");
+    if (!cp->failed)
+        checkpoint_bytes(cp, sc->blocks, (size_t)sc->stride * sc->num_sets);
+    CHECKPOINT(cp, sc->psel);
+    CHECKPOINT(cp, sc->inserts);
+}
+
+// Put data->page_ref in set: an invalid way while the set fills, else the victim policy's way
+static int setCacheLoad(Algorithm_Data *data, Set_Cache *sc, unsigned char *set, int (*victim)(Set_Cache *, unsigned char *))
+{
+    int *tags = SET_TAGS(set);
+    int way;
+    if (SET_USED(set) < sc->ways)
+    {
+        way = SET_USED(set)++;
     }
-    else if (framep->page == last_page_ref)
-    { // The page was found! Hit!
-        time(&framep->time);
-        framep->extra = framep->extra + 10000000;
-        while (framep->frames.le_next != NULL)
-        {
-            framep = framep->frames.le_next;
-            framep->extra /= 2;
-        }
+    else
+    {
+        way = victim(sc, set);
+        int line = (int)((set - sc->blocks) / sc->stride) * sc->ways + way;
+        if (debug)
+            printf("Victim selected: %d, Page: %d\n", line, tags[way]);
+        add_victim_page(data, line, tags[way]);
     }
-    if (fault == 1)
+    tags[way] = data->page_ref;
+    return way;
+}
+
+static int setCacheCount(Algorithm_Data *data, int fault)
+{
+    if (fault)
         data->misses++;
     else
         data->hits++;
     return fault;
 }
 
-// MRU(Most-recently-used) Page Replacement Algorithm
-int MRU(Algorithm_Data *data)
+// Tree-PLRU: each node's byte points at the half holding the pseudo least recent way
+// (0 left, 1 right). Leaves past ways, when ways is not a power of two, are never chosen.
+static void plruTouch(Set_Cache *sc, unsigned char *set, int way)
 {
-    Frame *framep = data->page_table.lh_first, *mru_frame = NULL, *freeFrame = NULL;
-    int fault = 0;
-
-    // Iterate through the frames to find the MRU frame and check for page hits
-    while (framep != NULL)
+    unsigned char *tree = SET_TREE(sc, set);
+    for (int node = 0, lo = 0, span = sc->leaves; span > 1; span >>= 1)
     {
-        if (framep->page == last_page_ref)
+        int half = span >> 1;
+        if (way < lo + half)
         {
-            // Page hit, update its time
-            time(&framep->time);
-            data->hits++;
-            return 0; // No fault occurred
+            tree[node] = 1;
+            node = 2 * node + 1;
+        }
+        else
+        {
+            tree[node] = 0;
+            node = 2 * node + 2;
+            lo += half;
         }
+    }
+}
 
-        if (framep->page == -1 && freeFrame == NULL)
+static int plruVictim(Set_Cache *sc, unsigned char *set)
+{
+    unsigned char *tree = SET_TREE(sc, set);
+    int node = 0, lo = 0;
+    for (int span = sc->leaves; span > 1; span >>= 1)
+    {
+        int half = span >> 1;
+        if (tree[node] && lo + half < sc->ways)
         {
-            freeFrame = framep; // Found a free frame
+            node = 2 * node + 2;
+            lo += half;
         }
-        else if (mru_frame == NULL || framep->time > mru_frame->time)
+        else
         {
-            mru_frame = framep; // Update MRU frame
+            node = 2 * node + 1;
         }
+    }
+    return lo;
+}
+
+// Bit-PLRU: an MRU bit per way, the last one set clears the others. The victim is the first clear way,
+// or way 0 in a one-way set, whose only bit stays set
+static void bitPlruTouch(Set_Cache *sc, unsigned char *set, int way)
+{
+    unsigned char *mru = SET_STATE(sc, set);
+    if (mru[way])
+        return;
+    mru[way] = 1;
+    if (++SET_MARKED(set) < sc->ways)
+        return;
+    memset(mru, 0, sc->ways);
+    mru[way] = 1;
+    SET_MARKED(set) = 1;
+}
+
+static int bitPlruVictim(Set_Cache *sc, unsigned char *set)
+{
+    unsigned char *mru = SET_STATE(sc, set);
+    int way = 0;
+    while (way < sc->ways - 1 && mru[way])
+        way++;
+    return way;
+}
+
+// RRIP: the victim is the first way predicted to be re-referenced furthest away (RRPV max),
+// after everyone has aged just enough for one to get there
+static int rripVictimMax(Set_Cache *sc, unsigned char *set, int max)
+{
+    unsigned char *rrpv = SET_STATE(sc, set);
+    int oldest = 0;
+    for (int way = 0; way < sc->ways; way++)
+    {
+        if (rrpv[way] >= max)
+            return way;
+        if (rrpv[way] > rrpv[oldest])
+            oldest = way;
+    }
+    int age = max - rrpv[oldest];
+    for (int way = 0; way < sc->ways; way++)
+        rrpv[way] += age;
+    return oldest;
+}
+
+static int rripVictim(Set_Cache *sc, unsigned char *set)
+{
+    return rripVictimMax(sc, set, RRIP_MAX);
+}
 
-        framep = framep->frames.le_next;
-    }
+static int nruVictim(Set_Cache *sc, unsigned char *set)
+{
+    return rripVictimMax(sc, set, 1);
+}
 
-    // Page fault occurred, no match found in page table
-    data->misses++;
-    fault = 1;
+// BRRIP insertion: distant, but one in BRRIP_EPSILON long like SRRIP so a working set larger
+// than the set still keeps some blocks
+static int brripInsertion(Set_Cache *sc)
+{
+    return sc->inserts++ % BRRIP_EPSILON == 0 ? RRIP_MAX - 1 : RRIP_MAX;
+}
 
-    // Use a free frame if available, otherwise replace the MRU frame
-    if (freeFrame != NULL)
+// RRIP family driver, hits are predicted near-immediate (RRPV 0)
+static int rripRef(Algorithm_Data *data, Set_Cache *sc, unsigned char *set, int brrip)
+{
+    int way = set_cache_find(set, data->page_ref);
+    int fault = way < 0;
+    unsigned char *rrpv = SET_STATE(sc, set);
+    if (fault)
     {
-        freeFrame->page = last_page_ref; // Use the free frame
-        time(&freeFrame->time);          // Set the time for the new frame
+        way = setCacheLoad(data, sc, set, &rripVictim);
+        rrpv[way] = brrip ? brripInsertion(sc) : RRIP_MAX - 1;
     }
-    else if (mru_frame != NULL)
+    else
     {
-        add_victim(&data->victim_list, mru_frame); // Add the MRU frame to the victim list
-        mru_frame->page = last_page_ref;           // Replace with the new page
-        time(&mru_frame->time);                    // Update the time for the MRU frame
+        rrpv[way] = 0;
     }
+    return setCacheCount(data, fault);
+}
 
-    return fault;
+// Tree-PLRU Page Replacement Algorithm
+int PLRU(Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    unsigned char *set = set_cache_set(sc, set_of(data->page_ref, sc->num_sets));
+    int way = set_cache_find(set, data->page_ref);
+    int fault = way < 0;
+    if (fault)
+        way = setCacheLoad(data, sc, set, &plruVictim);
+    plruTouch(sc, set, way);
+    return setCacheCount(data, fault);
 }
 
-// NRU(Not Recently Used) Page Replacement Algorithm
-int NRU(Algorithm_Data *data)
+// Bit-PLRU (MRU bits) Page Replacement Algorithm
+int BITPLRU(Algorithm_Data *data)
 {
-    Frame *framep = data->page_table.lh_first, *nru_frame = NULL, *freeFrame = NULL;
-    int fault = 0;
+    Set_Cache *sc = data->extra;
+    unsigned char *set = set_cache_set(sc, set_of(data->page_ref, sc->num_sets));
+    int way = set_cache_find(set, data->page_ref);
+    int fault = way < 0;
+    if (fault)
+        way = setCacheLoad(data, sc, set, &bitPlruVictim);
+    bitPlruTouch(sc, set, way);
+    return setCacheCount(data, fault);
+}
 
-    // Iterate through the frames to find the NRU frame and check for page hits
-    while (framep != NULL)
-    {
-        if (framep->page == last_page_ref)
-        {
-            // Page hit, update its time
-            time(&framep->time);
-            data->hits++;
-            return 0; // No fault occurred
-        }
+// SRRIP Page Replacement Algorithm (Jaleel et al.), new blocks are inserted at a long
+// re-reference interval so a scan ages out before the blocks that were reused
+int SRRIP(Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    return rripRef(data, sc, set_cache_set(sc, set_of(data->page_ref, sc->num_sets)), 0);
+}
 
-        if (framep->page == -1 && freeFrame == NULL)
-        {
-            freeFrame = framep; // Found a free frame
-        }
-        else if (nru_frame == NULL || framep->time < nru_frame->time)
-        {
-            nru_frame = framep; // Update NRU frame
-        }
+// BRRIP Page Replacement Algorithm, thrash resistant: most new blocks are inserted distant
+int BRRIP(Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    return rripRef(data, sc, set_cache_set(sc, set_of(data->page_ref, sc->num_sets)), 1);
+}
 
-        framep = framep->frames.le_next;
-    }
+// DRRIP Page Replacement Algorithm
+// Set dueling: DRRIP_LEADERS sets always use SRRIP and as many BRRIP, their misses steer PSEL,
+// and the follower sets insert like whichever leader group is missing less
+int DRRIP(Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    int s = set_of(data->page_ref, sc->num_sets);
+    int spacing = sc->num_sets / DRRIP_LEADERS > 2 ? sc->num_sets / DRRIP_LEADERS : 2;
+    int leader = s % spacing; // 0 leads for SRRIP, 1 for BRRIP
+    int brrip = leader == 1 || (leader > 1 && sc->psel > DRRIP_PSEL_MAX / 2);
+    int fault = rripRef(data, sc, set_cache_set(sc, s), brrip);
+    if (fault && leader == 0 && sc->psel < DRRIP_PSEL_MAX)
+        sc->psel++;
+    else if (fault && leader == 1 && sc->psel > 0)
+        sc->psel--;
+    return fault;
+}
 
-    // Page fault occurred, no match found in page table
-    data->misses++;
-    fault = 1;
+// Hardware NRU Page Replacement Algorithm, one not-recently-used bit per way (RRIP with
+// a 1-bit RRPV): a ref clears it, and when no way has it set every way gets it back
+int HWNRU(Algorithm_Data *data)
+{
+    Set_Cache *sc = data->extra;
+    unsigned char *set = set_cache_set(sc, set_of(data->page_ref, sc->num_sets));
+    int way = set_cache_find(set, data->page_ref);
+    int fault = way < 0;
+    if (fault)
+        way = setCacheLoad(data, sc, set, &nruVictim);
+    SET_STATE(sc, set)[way] = 0;
+    return setCacheCount(data, fault);
+}
 
-    // Use a free frame if available, otherwise replace the NRU frame
-    if (freeFrame != NULL)
-    {
-        freeFrame->page = last_page_ref; // Use the free frame
-        time(&freeFrame->time);          // Set the time for the new frame
-    }
-    else if (nru_frame != NULL)
+// Object size section
+// Objects of any size share a byte budget and the victims are evicted until the new object
+// fits, an object larger than the whole cache is never admitted. Without --frame-bytes each
+// object costs one of num_frames frames, so the same policies also run as object caches.
+
+void initializeSizeCache(Algorithm_Data *data)
+{
+    Size_Data *sd = calloc(1, sizeof(Size_Data));
+    if (!sd || page_map_init(&sd->map, 1024) != 0)
     {
-        add_victim(&data->victim_list, nru_frame); // Add the NRU frame to the victim list
-        nru_frame->page = last_page_ref;           // Replace with the new page
-        time(&nru_frame->time);                    // Update the time for the NRU frame
+        fprintf(stderr, "Failed to allocate memory for size-aware cache\n");
+        exit(1);
     }
-
-    return fault;
+    TAILQ_INIT(&sd->free);
+    TAILQ_INIT(&sd->lru);
+    sd->capacity = frame_bytes > 0 ? (uint64_t)data->num_frames * frame_bytes : (uint64_t)data->num_frames;
+    data->extra = sd;
+    data->free_extra = &freeSizeCache;
 }
 
-// MFU(Most Frequently Used) Page Replacement Algorithm
-int MFU(Algorithm_Data *data)
+void freeSizeCache(void *extra)
 {
-    Frame *framep = data->page_table.lh_first, *victim = NULL, *freeFrame = NULL;
-    int fault = 0;
-
-    // Iterate through the page table to find either a hit, a free frame, or a potential victim.
-    while (framep != NULL)
+    Size_Data *sd = extra;
+    while (sd->blocks != NULL)
     {
-        if (framep->page == last_page_ref)
-        {
-            // Page hit
-            framep->extra++; // Increment the usage count
-            data->hits++;
-            return 0; // No fault occurred
-        }
+        Frame_Block *block = sd->blocks;
+        sd->blocks = block->next;
+        free(block);
+    }
+    page_map_free(&sd->map);
+    free(sd->heap);
+    free(sd);
+}
 
-        if (framep->page == -1 && freeFrame == NULL)
-        {
-            freeFrame = framep; // Found a free frame
-        }
-        else if (victim == NULL || framep->extra > victim->extra)
+// Checkpoint hook for the size-aware policies, each frame block is a pool of its own
+void checkpointSizeCache(Checkpoint *cp, Algorithm_Data *data)
+{
+    Size_Data *sd = data->extra;
+    int blocks = 0;
+    for (Frame_Block *block = sd->blocks; !cp->loading && block != NULL; block = block->next)
+        blocks++;
+    checkpoint_match(cp, sd->capacity, "--frame-bytes");
+    CHECKPOINT(cp, blocks);
+    CHECKPOINT(cp, sd->block_used);
+    for (int b = 0; cp->loading && !cp->failed && b < blocks; b++)
+    { // Blocks are listed newest first, the order they were saved in
+        Frame_Block *block = malloc(sizeof(Frame_Block));
+        if (!block)
         {
-            // Select the most frequently used page as the victim
-            victim = framep;
+            fprintf(stderr, "Failed to allocate memory for size-aware cache\n");
+            exit(1);
         }
-
-        framep = framep->frames.le_next;
+        block->next = sd->blocks;
+        sd->blocks = block;
     }
-
-    // Page fault occurred, no match found in page table
-    data->misses++;
-    fault = 1;
-
-    // Use a free frame if available, otherwise replace the victim
-    if (freeFrame != NULL)
+    for (Frame_Block *block = sd->blocks; block != NULL && !cp->failed; block = block->next)
     {
-        freeFrame->page = last_page_ref; // Use the free frame
-        freeFrame->extra = 1;            // Initialize the usage count for the new page
+        int used = block == sd->blocks ? sd->block_used : VICTIM_POOL_BLOCK;
+        checkpoint_pool(cp, block->frames, used);
+        checkpoint_frames(cp, block->frames, used);
     }
-    else if (victim != NULL)
+    checkpoint_page_map(cp, &sd->map);
+    checkpoint_queue(cp, &sd->free, 0);
+    checkpoint_queue(cp, &sd->lru, 0);
+    int heap_size = sd->heap_size;
+    CHECKPOINT(cp, heap_size);
+    if (cp->loading && !cp->failed && heap_size < 0)
+        checkpoint_fail(cp, "a size-aware heap");
+    if (cp->loading && !cp->failed && heap_size > sd->heap_capacity)
     {
-        add_victim(&data->victim_list, victim); // Add the victim to the victim list
-        victim->page = last_page_ref;           // Replace with the new page
-        victim->extra = 1;                      // Reset the usage count for the new page
+        Size_Entry *heap = realloc(sd->heap, sizeof(Size_Entry) * heap_size);
+        if (!heap)
+        {
+            fprintf(stderr, "Failed to allocate memory for size-aware cache\n");
+            exit(1);
+        }
+        sd->heap = heap;
+        sd->heap_capacity = heap_size;
     }
-
-    return fault;
+    sd->heap_size = heap_size;
+    for (int i = 0; i < sd->heap_size && !cp->failed; i++)
+    {
+        CHECKPOINT(cp, sd->heap[i].key);
+        CHECKPOINT(cp, sd->heap[i].tie);
+        checkpoint_frame(cp, &sd->heap[i].frame);
+    }
+    CHECKPOINT(cp, sd->objects);
+    CHECKPOINT(cp, sd->used);
+    CHECKPOINT(cp, sd->inflation);
 }
 
-// helper function for LRU and LFRU
-int currentTime()
+// 1 if entry a leaves before entry b
+static int sizeEntryBefore(const Size_Entry *a, const Size_Entry *b)
 {
-    static int time = 0;
-    return time++;
+    return a->key < b->key || (a->key == b->key && a->tie < b->tie);
 }
 
-// LFU (Least Frequently Used) page replacement algorithm
-int LFU(Algorithm_Data *data) {
-    // Assuming `last_page_ref` is the page reference to be accessed
-    int pageRef = last_page_ref; // Replace with actual page reference variable
-    Frame *framep = data->page_table.lh_first;
-    Frame *leastFrequentFrame = NULL;
-    int found = 0;
+static void sizeHeapSwap(Size_Data *sd, int a, int b)
+{
+    Size_Entry tmp = sd->heap[a];
+    sd->heap[a] = sd->heap[b];
+    sd->heap[b] = tmp;
+    sd->heap[a].frame->extra = a;
+    sd->heap[b].frame->extra = b;
+}
 
-    // Check if page is in frames and update frequency
-    while (framep != NULL) {
-        if (framep->page == pageRef) {
-            framep->frequency++;
-            found = 1;
-            data->hits++;
-            break;
-        }
-        framep = framep->frames.le_next;
+// Restore the min-heap around pos after its entry changed
+static void sizeHeapFix(Size_Data *sd, int pos)
+{
+    while (pos > 0 && sizeEntryBefore(&sd->heap[pos], &sd->heap[(pos - 1) / 2]))
+    {
+        sizeHeapSwap(sd, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
     }
-
-    // If page not found, handle page fault
-    if (!found) {
-        data->misses++;
-        framep = data->page_table.lh_first;
-
-        // Find the least frequently used frame
-        while (framep != NULL) {
-            if (leastFrequentFrame == NULL || framep->frequency < leastFrequentFrame->frequency) {
-                leastFrequentFrame = framep;
-            }
-            framep = framep->frames.le_next;
-        }
-
-        // Replace the least frequently used page
-        if (leastFrequentFrame != NULL) {
-            // Add the old page to the victim list
-            add_victim(&data->victim_list, leastFrequentFrame);
-
-            leastFrequentFrame->page = pageRef;
-            leastFrequentFrame->frequency = 1; // Reset frequency for the new page
-            // Reset last used time if needed
-            leastFrequentFrame->lastUsed = currentTime(); // Assuming currentTime() is a function to get the current time
-        }
+    for (;;)
+    {
+        int left = 2 * pos + 1, right = left + 1, first = pos;
+        if (left < sd->heap_size && sizeEntryBefore(&sd->heap[left], &sd->heap[first]))
+            first = left;
+        if (right < sd->heap_size && sizeEntryBefore(&sd->heap[right], &sd->heap[first]))
+            first = right;
+        if (first == pos)
+            break;
+        sizeHeapSwap(sd, pos, first);
+        pos = first;
     }
-
-    return !found; // Return 1 if there was a page fault, otherwise 0
 }
 
+// Heap entry of a held frame, its key set by sizeKey()
+static void sizeKey(Size_Data *sd, int policy, Frame *framep)
+{
+    Size_Entry *entry = &sd->heap[framep->extra];
+    if (policy == SIZE_GDSF)
+        entry->key = sd->inflation + (double)framep->frequency / (double)framep->size;
+    else
+        entry->key = (double)framep->lastUsed;
+    entry->tie = framep->time;
+    sizeHeapFix(sd, framep->extra);
+}
 
-
-
-
-
-// LFRU section
-
-// Check if a page is in the given partition
-int isPageInPartition(Partition *partition, int page)
+// A free frame, from an evicted object or a new block
+static Frame *sizeFrame(Size_Data *sd)
 {
-    for (int i = 0; i < partition->size; i++)
+    Frame *framep = sd->free.tqh_first;
+    if (framep != NULL)
+    {
+        TAILQ_REMOVE(&sd->free, framep, order);
+        return framep;
+    }
+    if (sd->blocks == NULL || sd->block_used == VICTIM_POOL_BLOCK)
     {
-        if (partition->frames[i].page == page)
+        Frame_Block *block = malloc(sizeof(Frame_Block));
+        if (!block)
         {
-            return 1;
+            fprintf(stderr, "Failed to allocate memory for size-aware cache\n");
+            exit(1);
         }
+        block->next = sd->blocks;
+        sd->blocks = block;
+        sd->block_used = 0;
     }
-    return 0;
+    framep = &sd->blocks->frames[sd->block_used];
+    init_empty_frame(framep, sd->objects);
+    sd->block_used++;
+    return framep;
 }
 
-// Update LRU information in a partition
-void updateLRU(Partition *partition, int page)
+// Drop a held object, as a victim unless it is being replaced by a new version
+static void sizeRemove(Algorithm_Data *data, Size_Data *sd, int policy, Frame *framep, int victim)
 {
-    // Find the frame and update its last used time
-    for (int i = 0; i < partition->size; i++)
+    if (policy == SIZE_LRU)
     {
-        if (partition->frames[i].page == page)
-        {
-            partition->frames[i].lastUsed = currentTime(); // currentTime() is a function to get current time
-            break;
-        }
+        TAILQ_REMOVE(&sd->lru, framep, order);
     }
+    else
+    {
+        int pos = framep->extra;
+        if (policy == SIZE_GDSF && victim)
+            sd->inflation = sd->heap[pos].key;
+        sizeHeapSwap(sd, pos, --sd->heap_size);
+        if (pos < sd->heap_size)
+            sizeHeapFix(sd, pos);
+    }
+    if (victim)
+    {
+        if (debug)
+            printf("Victim selected: %d, Page: %d\n", framep->index, framep->page);
+        add_victim(data, framep);
+    }
+    page_map_remove(&sd->map, framep->page);
+    sd->used -= framep->size;
+    sd->objects--;
+    TAILQ_INSERT_TAIL(&sd->free, framep, order);
 }
 
-// Update LFU information in a partition
-void updateLFU(Partition *partition, int page)
+// Page data->page_ref, of data->size bytes, with one of the size-aware policies
+static int sizeRef(Algorithm_Data *data, int policy)
 {
-    // Find the frame and increment its frequency count
-    for (int i = 0; i < partition->size; i++)
+    Size_Data *sd = data->extra;
+    uint32_t cost = frame_bytes > 0 ? data->size : 1;
+    Frame *framep = page_map_get(&sd->map, data->page_ref);
+    if (framep != NULL && framep->size != cost)
+    { // A new version of the object, it has to be fetched again
+        sizeRemove(data, sd, policy, framep, 0);
+        framep = NULL;
+    }
+    if (framep != NULL)
     {
-        if (partition->frames[i].page == page)
+        framep->frequency++;
+        framep->lastUsed = framep->time;
+        framep->time = current_tick(data);
+        if (policy == SIZE_LRU)
         {
-            partition->frames[i].frequency++;
-            break;
+            TAILQ_REMOVE(&sd->lru, framep, order);
+            TAILQ_INSERT_TAIL(&sd->lru, framep, order);
+        }
+        else
+        {
+            sizeKey(sd, policy, framep);
         }
+        data->hits++;
+        return 0;
     }
-}
 
-// Function to check if a page is in either partition
-int checkPageInPartitions(LFRU_Data *lfru_data, int page)
-{
-    // Check in privileged partition using LRU logic
-    if (isPageInPartition(&lfru_data->privileged, page))
+    data->misses++;
+    if (cost > sd->capacity)
+        return 1; // Never fits, not admitted
+    while (sd->used + cost > sd->capacity)
+        sizeRemove(data, sd, policy, policy == SIZE_LRU ? sd->lru.tqh_first : sd->heap[0].frame, 1);
+    if (page_map_reserve(&sd->map, sd->objects + 1) != 0)
+        exit(1);
+    framep = sizeFrame(sd);
+    framep->page = data->page_ref;
+    framep->size = cost;
+    framep->frequency = 1;
+    framep->lastUsed = 0;
+    framep->time = current_tick(data);
+    page_map_put(&sd->map, data->page_ref, framep);
+    sd->used += cost;
+    sd->objects++;
+    if (policy == SIZE_LRU)
     {
-        // Update LRU information for the page
-        updateLRU(&lfru_data->privileged, page);
-        return 1; // Page found in privileged partition
+        TAILQ_INSERT_TAIL(&sd->lru, framep, order);
+        return 1;
     }
-
-    // Check in unprivileged partition using LFU logic
-    if (isPageInPartition(&lfru_data->unprivileged, page))
+    if (sd->heap_size == sd->heap_capacity)
     {
-        // Update LFU information for the page
-        updateLFU(&lfru_data->unprivileged, page);
-        return 1; // Page found in unprivileged partition
+        int capacity = sd->heap_capacity > 0 ? sd->heap_capacity * 2 : 1024;
+        Size_Entry *heap = realloc(sd->heap, sizeof(Size_Entry) * capacity);
+        if (!heap)
+        {
+            fprintf(stderr, "Failed to allocate memory for size-aware cache\n");
+            exit(1);
+        }
+        sd->heap = heap;
+        sd->heap_capacity = capacity;
     }
-
-    return 0; // Page not found in either partition
+    framep->extra = sd->heap_size;
+    sd->heap[sd->heap_size++].frame = framep;
+    sizeKey(sd, policy, framep);
+    return 1;
 }
 
-// Function to update access information for a page
-void updateAccessInfo(LFRU_Data *lfru_data, int page)
+// Size-aware LRU Page Replacement Algorithm, evicts least recently used objects until the new one fits
+int SIZELRU(Algorithm_Data *data)
 {
-    // Update LRU information in the privileged partition
-    updateLRU(&lfru_data->privileged, page);
+    return sizeRef(data, SIZE_LRU);
+}
 
-    // Update LFU information in the unprivileged partition
-    updateLFU(&lfru_data->unprivileged, page);
+// GDSF Page Replacement Algorithm (Greedy-Dual-Size-Frequency, Cherkasova)
+// An object's priority is L + frequency / size, where the inflation L is the priority of the
+// last victim, so small popular objects stay and objects not touched lately age out
+int GDSF(Algorithm_Data *data)
+{
+    return sizeRef(data, SIZE_GDSF);
 }
 
-// Evict a page using the LFU policy
-int evictLFU(Partition *partition)
+// LRU-2 Page Replacement Algorithm (O'Neil et al.), size-aware
+// Evicts the object whose second to last ref is oldest (objects seen once first, in LRU order)
+// until the new object fits. History is kept only while an object is held.
+int LRU2(Algorithm_Data *data)
 {
-    int leastFrequent = INT_MAX;
-    int idxToEvict = -1;
+    return sizeRef(data, SIZE_LRU2);
+}
+
+// Adaptive section
+// ADAPTIVE duels its candidates the way DRRIP duels SRRIP and BRRIP, with pages in place of
+// sets: each candidate runs a leader cache that sees only the refs to a hashed sample of the
+// pages, on a page table scaled down by the same rate. Every adaptive_epoch sampled refs the
+// leaders' misses are folded into decaying scores, and the real cache switches to a candidate
+// only once it has beaten the current one by ADAPTIVE_MARGIN for ADAPTIVE_PATIENCE epochs.
 
-    for (int i = 0; i < partition->size; i++)
+// Fill adaptive_candidates from a comma list of policy names
+int parse_adaptive(const char *spec)
+{
+    char names[256];
+    snprintf(names, sizeof(names), "%s", spec);
+    num_adaptive_candidates = 0;
+    for (char *save = NULL, *name = strtok_r(names, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
     {
-        if (partition->frames[i].frequency < leastFrequent)
+        size_t i = 0;
+        while (i < sizeof(algos) / sizeof(Algorithm) && strcasecmp(name, algos[i].label) != 0)
+            i++;
+        // The candidates page one fully associative table of unit sized refs, seen as they come
+        if (i == sizeof(algos) / sizeof(Algorithm) || algos[i].flags != 0 || algos[i].algo == &ADAPTIVE)
+        {
+            printf("%s cannot be an --adaptive candidate\n", name);
+            return -1;
+        }
+        if (num_adaptive_candidates == ADAPTIVE_MAX_CANDIDATES)
         {
-            leastFrequent = partition->frames[i].frequency;
-            idxToEvict = i;
+            printf("--adaptive takes at most %d candidates\n", ADAPTIVE_MAX_CANDIDATES);
+            return -1;
         }
+        adaptive_candidates[num_adaptive_candidates++] = (int)i;
     }
-
-    if (idxToEvict != -1)
+    if (num_adaptive_candidates < 2)
     {
-        int evictedPage = partition->frames[idxToEvict].page;
-        partition->frames[idxToEvict].page = -1; // Mark as empty
-        return evictedPage;
+        printf("--adaptive needs at least 2 candidates\n");
+        return -1;
     }
+    return 0;
+}
 
-    return -1; // Indicates no page was evicted, likely an error
+// A page table run by candidate algo, outside setup_algo_data() so it is never partitioned
+static Algorithm_Data *adaptiveCache(const Algorithm *algo, int frames)
+{
+    Algorithm_Data *cache = create_algo_data_store(frames, !(algo->flags & ALGO_OWN_FRAMES));
+    if (algo->setup != NULL)
+        algo->setup(cache);
+    return cache;
 }
 
-// Demote the most recently used page from the LRU partition
-int demoteLRU(Partition *partition)
+// The real cache's evictions are the adaptive cache's, for its victims, prefetcher and shadow
+static void adaptiveEvicted(void *arg, int page)
 {
-    int mostRecent = 0;
-    int idxToDemote = -1;
+    Frame victim;
+    init_empty_frame(&victim, 0);
+    victim.page = page;
+    add_victim(arg, &victim);
+}
 
-    for (int i = 0; i < partition->size; i++)
+void initializeAdaptive(Algorithm_Data *data)
+{
+    if (num_adaptive_candidates == 0 && parse_adaptive(ADAPTIVE_DEFAULT) != 0)
+        exit(1);
+    Adaptive_Data *ad = calloc(1, sizeof(Adaptive_Data));
+    int frames = data->num_frames;
+    if (!ad || !(ad->history = malloc(sizeof(uint32_t) * ADAPTIVE_HISTORY * frames)))
     {
-        if (partition->frames[i].lastUsed > mostRecent)
-        {
-            mostRecent = partition->frames[i].lastUsed;
-            idxToDemote = i;
-        }
+        fprintf(stderr, "Failed to allocate memory for adaptive policy\n");
+        exit(1);
     }
-
-    if (idxToDemote != -1)
+    // Small caches sample more pages, so every leader keeps enough frames to tell policies apart
+    double rate = frames * ADAPTIVE_SAMPLE_RATE < ADAPTIVE_MIN_LEADER_FRAMES ? (double)ADAPTIVE_MIN_LEADER_FRAMES / frames
+                                                                           : ADAPTIVE_SAMPLE_RATE;
+    ad->threshold = sample_threshold_of(rate < 1.0 ? rate : 1.0);
+    int leader_frames = (int)(frames * ((double)ad->threshold / SHARDS_MODULUS) + 0.5);
+    ad->num_candidates = num_adaptive_candidates;
+    for (int c = 0; c < ad->num_candidates; c++)
     {
-        int demotedPage = partition->frames[idxToDemote].page;
-        partition->frames[idxToDemote].page = -1; // Mark as empty
-        return demotedPage;
+        ad->ids[c] = adaptive_candidates[c];
+        ad->candidates[c] = algos[adaptive_candidates[c]];
+        ad->leaders[c] = adaptiveCache(&ad->candidates[c], leader_frames > 0 ? leader_frames : 1);
     }
-
-    return -1; // Indicates no page was demoted, likely an error
+    ad->real = adaptiveCache(&ad->candidates[0], frames);
+    ad->real->evict_hook = &adaptiveEvicted;
+    ad->real->evict_arg = data;
+    ad->challenger = -1;
+    ad->history_size = ADAPTIVE_HISTORY * frames;
+    data->extra = ad;
+    data->free_extra = &freeAdaptive;
 }
 
-// Insert a page into the partition
-void insertIntoPartition(Partition *partition, int page)
+void freeAdaptive(void *extra)
 {
-    // Find an empty frame or replace based on the policy
-    for (int i = 0; i < partition->size; i++)
-    {
-        if (partition->frames[i].page == -1)
-        {
-            partition->frames[i].page = page;
-            partition->frames[i].lastUsed = currentTime();
-            partition->frames[i].frequency = 1;
-            break;
-        }
-    }
+    Adaptive_Data *ad = extra;
+    for (int c = 0; c < ad->num_candidates; c++)
+        destroy_algo_data_store(ad->leaders[c]);
+    destroy_algo_data_store(ad->real);
+    free(ad->history);
+    free(ad);
 }
 
-// Check if there is space in the partition
-int hasSpace(Partition *partition)
+// Move the real cache to candidate to. With warm set, the new policy first replays the last
+// history_size refs, so it starts out holding about what it would hold had it run all along.
+static void adaptiveFollow(Algorithm_Data *data, Adaptive_Data *ad, int to, int warm)
 {
-    for (int i = 0; i < partition->size; i++)
+    Algorithm_Data *real = adaptiveCache(&ad->candidates[to], data->num_frames);
+    uint64_t replay = !warm ? 0 : ad->history_count < (uint64_t)ad->history_size ? ad->history_count : (uint64_t)ad->history_size;
+    for (uint64_t i = replay; i > 0; i--)
     {
-        if (partition->frames[i].page == -1)
-        { // Assuming -1 indicates an empty frame
-            return 1;
-        }
+        int64_t position = data->position - (int64_t)(i - 1);
+        real->page_ref = (int)ad->history[(ad->history_count - i) % ad->history_size];
+        real->position = position > 0 ? position : 0;
+        ad->candidates[to].algo(real);
     }
-    return 0;
+    real->evict_hook = &adaptiveEvicted;
+    real->evict_arg = data;
+    destroy_algo_data_store(ad->real);
+    ad->real = real;
+    ad->current = to;
 }
 
-// Function to handle the insertion of a new page
-void handlePageInsertion(LFRU_Data *lfru_data, int page)
+// Page a sampled ref through every leader, and end the epoch once adaptive_epoch have been
+static void adaptiveDuel(Algorithm_Data *data, Adaptive_Data *ad)
 {
-    // Check if there's space in the privileged partition
-    if (hasSpace(&lfru_data->privileged))
+    uint64_t start = latency_now();
+    for (int c = 0; c < ad->num_candidates; c++)
     {
-        insertIntoPartition(&lfru_data->privileged, page);
+        Algorithm_Data *leader = ad->leaders[c];
+        leader->page_ref = data->page_ref;
+        leader->position = data->position;
+        ad->epoch_misses[c] += ad->candidates[c].algo(leader);
     }
-    else
+    if (++ad->samples >= adaptive_epoch)
     {
-        // Evict a page from the unprivileged partition using LFU
-        int evictedPage = evictLFU(&lfru_data->unprivileged);
-
-        // Move a page from privileged to unprivileged
-        int demotedPage = demoteLRU(&lfru_data->privileged);
-        insertIntoPartition(&lfru_data->unprivileged, demotedPage);
-
-        // Insert the new page into the privileged partition
-        insertIntoPartition(&lfru_data->privileged, page);
+        int best = ad->current;
+        for (int c = 0; c < ad->num_candidates; c++)
+        {
+            ad->score[c] = ad->score[c] / 2 + ad->epoch_misses[c];
+            ad->epoch_misses[c] = 0;
+            if (ad->score[c] < ad->score[best])
+                best = c;
+        }
+        if (best != ad->current && ad->score[best] < ad->score[ad->current] * (1.0 - ADAPTIVE_MARGIN))
+        {
+            ad->streak = best == ad->challenger ? ad->streak + 1 : 1;
+            ad->challenger = best;
+        }
+        else
+        {
+            ad->streak = 0;
+            ad->challenger = -1;
+        }
+        if (ad->streak >= ADAPTIVE_PATIENCE)
+        {
+            adaptiveFollow(data, ad, best, 1);
+            ad->switches++;
+            ad->streak = 0;
+            ad->challenger = -1;
+        }
+        ad->samples = 0;
+        ad->epochs++;
     }
+    ad->overhead_ticks += latency_now() - start;
 }
 
-// LFRU (Least Frequently Recently Used) algorithm
-int LFRU(Algorithm_Data *data)
+// Checkpoint hook for ADAPTIVE, the real cache and the leaders are saved like top-level caches
+void checkpointAdaptive(Checkpoint *cp, Algorithm_Data *data)
 {
-    LFRU_Data *lfru_data = (LFRU_Data *)data->extra; // Assuming extra is used to store LFRU specific data
+    Adaptive_Data *ad = data->extra;
+    checkpoint_match(cp, ad->num_candidates, "--adaptive");
+    for (int c = 0; c < ad->num_candidates; c++)
+        checkpoint_match(cp, ad->ids[c], "--adaptive");
+    checkpoint_match(cp, ad->threshold, "the adaptive sample rate");
+    checkpoint_match(cp, ad->history_size, "frames");
+    int current = ad->current;
+    CHECKPOINT(cp, current);
+    if (cp->loading && !cp->failed && (current < 0 || current >= ad->num_candidates))
+        checkpoint_fail(cp, "the adaptive policy");
+    if (cp->failed)
+        return;
+    if (current != ad->current)
+        adaptiveFollow(data, ad, current, 0);
+    CHECKPOINT(cp, ad->score);
+    CHECKPOINT(cp, ad->epoch_misses);
+    CHECKPOINT(cp, ad->refs_on);
+    CHECKPOINT(cp, ad->samples);
+    CHECKPOINT(cp, ad->challenger);
+    CHECKPOINT(cp, ad->streak);
+    CHECKPOINT(cp, ad->history_count);
+    CHECKPOINT(cp, ad->epochs);
+    CHECKPOINT(cp, ad->switches);
+    checkpoint_bytes(cp, ad->history, sizeof(uint32_t) * ad->history_size);
+    uint64_t overhead_ns = (uint64_t)latency_ns(ad->overhead_ticks);
+    CHECKPOINT(cp, overhead_ns);
+    if (cp->loading)
+        ad->overhead_ticks = (uint64_t)(overhead_ns / latency_ns_per_tick);
+    checkpoint_algo_data(cp, &ad->candidates[ad->current], ad->real);
+    for (int c = 0; c < ad->num_candidates && !cp->failed; c++)
+        checkpoint_algo_data(cp, &ad->candidates[c], ad->leaders[c]);
+}
 
-    // Check for the page in both partitions
-    int pageFound = checkPageInPartitions(lfru_data, last_page_ref);
-    if (pageFound)
-    {
-        // Page found, update access info
-        updateAccessInfo(lfru_data, last_page_ref);
+// ADAPTIVE Page Replacement Algorithm
+// Pages every ref through the real cache with the policy winning the duel of the leaders
+int ADAPTIVE(Algorithm_Data *data)
+{
+    Adaptive_Data *ad = data->extra;
+    Algorithm_Data *real = ad->real;
+    real->page_ref = data->page_ref;
+    real->position = data->position;
+    int fault = ad->candidates[ad->current].algo(real);
+    ad->refs_on[ad->current]++;
+    ad->history[ad->history_count++ % ad->history_size] = (uint32_t)data->page_ref;
+    if (shards_hash(data->page_ref) < ad->threshold)
+        adaptiveDuel(data, ad);
+    if (fault == 1)
+        data->misses++;
+    else
         data->hits++;
-        return 0; // No page fault
+    return fault;
+}
+
+// Switches, the share of refs paged by each candidate and the time the leaders took, summed
+// over the partitions of a partitioned cache
+int print_adaptive(const Algorithm_Data *data)
+{
+    int parts = data->num_partitions > 0 ? data->num_partitions : 1;
+    const Adaptive_Data *first = data->num_partitions > 0 ? data->partitions[0]->extra : data->extra;
+    uint64_t switches = 0, epochs = 0, overhead = 0, refs = 0, refs_on[ADAPTIVE_MAX_CANDIDATES] = {0};
+    for (int p = 0; p < parts; p++)
+    {
+        const Adaptive_Data *ad = data->num_partitions > 0 ? data->partitions[p]->extra : data->extra;
+        switches += ad->switches;
+        epochs += ad->epochs;
+        overhead += ad->overhead_ticks;
+        for (int c = 0; c < ad->num_candidates; c++)
+        {
+            refs_on[c] += ad->refs_on[c];
+            refs += ad->refs_on[c];
+        }
     }
+    printf("  Adaptive: %llu switches in %llu epochs", (unsigned long long)switches, (unsigned long long)epochs);
+    if (data->num_partitions == 0)
+        printf(", now %s", first->candidates[first->current].label);
+    printf(", refs paged by");
+    for (int c = 0; c < first->num_candidates; c++)
+        printf(" %s %.1f%%", first->candidates[c].label, refs > 0 ? 100.0 * refs_on[c] / refs : 0.0);
+    printf("\n  Leaders: %.2f%% of pages sampled, %.1f ns/ref overhead (%.1f%% of the execution time)\n",
+           100.0 * first->threshold / SHARDS_MODULUS, refs > 0 ? latency_ns(overhead) / refs : 0.0,
+           data->exec_ticks > 0 ? 100.0 * overhead / data->exec_ticks : 0.0);
+    return 0;
+}
 
-    // Page fault handling
-    data->misses++;
+#ifdef CRA_SPECIALIZE
+// Specialized replay section
+// One replay loop per policy with the policy and its helpers flattened into it, so a block is
+// replayed without a call through algo->algo per ref. The frame-array policies also get loops
+// for common frame counts, where every scan has a constant trip count.
+#define REPLAY_LOOP(name, step)                                                          \
+    __attribute__((flatten)) static void name(Algorithm_Data *data, const uint32_t *block, \
+                                              int n, int64_t start)                      \
+    {                                                                                    \
+        for (int i = 0; i < n; i++)                                                      \
+        {                                                                                \
+            data->page_ref = (int)block[i];                                              \
+            data->position = start + i;                                                  \
+            step;                                                                        \
+        }                                                                                \
+    }
+#define REPLAY_POLICY(algo) REPLAY_LOOP(replay_##algo, algo(data))
+#define REPLAY_SIZED(algo, step)                             \
+    REPLAY_LOOP(replay_##algo##_8, step(data, 8))            \
+    REPLAY_LOOP(replay_##algo##_16, step(data, 16))          \
+    REPLAY_LOOP(replay_##algo##_32, step(data, 32))          \
+    REPLAY_LOOP(replay_##algo##_64, step(data, 64))          \
+    REPLAY_POLICY(algo)
+#define REPLAY_ANY(algo) {&algo, 0, &replay_##algo}
+#define REPLAY_SIZES(algo)                                                            \
+    {&algo, 8, &replay_##algo##_8}, {&algo, 16, &replay_##algo##_16},                 \
+        {&algo, 32, &replay_##algo##_32}, {&algo, 64, &replay_##algo##_64}, REPLAY_ANY(algo)
 
-    // Evict a page if necessary and insert the new page
-    handlePageInsertion(lfru_data, last_page_ref);
+REPLAY_SIZED(RANDOM, randomStep)
+REPLAY_SIZED(CLOCK, clockStep)
+REPLAY_SIZED(GCLOCK, gclockStep)
+REPLAY_SIZED(NFU, nfuStep)
+REPLAY_SIZED(AGING, agingStep)
+REPLAY_SIZED(NRU, nruStep)
+REPLAY_POLICY(OPTIMAL)
+REPLAY_POLICY(FIFO)
+REPLAY_POLICY(LRU)
+REPLAY_POLICY(MRU)
+REPLAY_POLICY(MFU)
+REPLAY_POLICY(LFU)
+REPLAY_POLICY(LFRU)
+REPLAY_POLICY(ARC)
+REPLAY_POLICY(TWOQ)
+REPLAY_POLICY(LIRS)
+REPLAY_POLICY(WTINYLFU)
+REPLAY_POLICY(CLOCKPRO)
+REPLAY_POLICY(UCP)
+REPLAY_POLICY(PLRU)
+REPLAY_POLICY(BITPLRU)
+REPLAY_POLICY(SRRIP)
+REPLAY_POLICY(BRRIP)
+REPLAY_POLICY(DRRIP)
+REPLAY_POLICY(HWNRU)
+REPLAY_POLICY(SIZELRU)
+REPLAY_POLICY(GDSF)
+REPLAY_POLICY(LRU2)
 
-    return 1; // Page fault occurred
-}
+static const Replay_Kernel replay_kernels[] = {
+    REPLAY_SIZES(RANDOM), REPLAY_SIZES(CLOCK), REPLAY_SIZES(GCLOCK), REPLAY_SIZES(NFU),
+    REPLAY_SIZES(AGING), REPLAY_SIZES(NRU), REPLAY_ANY(OPTIMAL), REPLAY_ANY(FIFO),
+    REPLAY_ANY(LRU), REPLAY_ANY(MRU), REPLAY_ANY(MFU), REPLAY_ANY(LFU),
+    REPLAY_ANY(LFRU), REPLAY_ANY(ARC), REPLAY_ANY(TWOQ), REPLAY_ANY(LIRS),
+    REPLAY_ANY(WTINYLFU), REPLAY_ANY(CLOCKPRO), REPLAY_ANY(UCP), REPLAY_ANY(PLRU),
+    REPLAY_ANY(BITPLRU), REPLAY_ANY(SRRIP), REPLAY_ANY(BRRIP), REPLAY_ANY(DRRIP),
+    REPLAY_ANY(HWNRU), REPLAY_ANY(SIZELRU), REPLAY_ANY(GDSF), REPLAY_ANY(LRU2),
+};
 
-// Function to print results after algo is run
-int print_help(const char *binary)
+// Loop compiled for algo on frames frames, the sized loops come first in the table
+Replay_Fn replay_kernel(int (*algo)(Algorithm_Data *data), int frames)
 {
-    printf("usage: %s algorithm num_frames show_process debug\n", binary);
-    printf("   input file    - input test file\n");
-    printf("   algorithm    - page algorithm to use {LRU, CLOCK, AGING, OPTIMAL, RANDOM, FIFO}\n");
-    printf("   num_frames   - number of page frames {int > 0}\n");
-    printf("   show_process - print page table after each ref is processed {1 or 0}\n");
-    printf("   debug        - verbose debugging output {1 or 0}\n");
-    return 0;
+    for (size_t i = 0; i < sizeof(replay_kernels) / sizeof(replay_kernels[0]); i++)
+    {
+        if (replay_kernels[i].algo == algo && (replay_kernels[i].frames == 0 || replay_kernels[i].frames == frames))
+            return replay_kernels[i].replay;
+    }
+    return NULL;
 }
+#endif
 
 // Function to print results after algo is run
 int print_stats(Algorithm algo)
 {
     print_summary(algo);
-    print_list(algo.data->page_table.lh_first, "Frame #", "Page Ref");
+    for (int t = 0; t < algo.data->num_partitions; t++)
+    {
+        Algorithm_Data *part = algo.data->partitions[t];
+        if (assoc_ways > 0)
+            printf("Set %d\n", t);
+        else
+            printf("pid %d\n", tenant_pids[t]);
+        if (part->arrays.page != NULL)
+            print_frame_arrays(&part->arrays, "Meta");
+        else
+            print_list(part->page_table.lh_first, "Frame #", "Page Ref");
+    }
+    if (algo.data->num_partitions > 0)
+        return 0;
+    if (algo.data->free_extra == &freeSetCache)
+        print_set_cache(algo.data->extra);
+    else if (algo.data->arrays.page != NULL)
+        print_frame_arrays(&algo.data->arrays, "Meta");
+    else
+        print_list(algo.data->page_table.lh_first, "Frame #", "Page Ref");
     return 0;
 }
 
 // Function to print summary report of an Algorithm
 int print_summary(Algorithm algo) {
     printf("%s Algorithm\n", algo.label);
-    printf("Frames in Mem: %d, ", num_frames);
-    printf("Hits: %d, ", algo.data->hits);
-    printf("Misses: %d, ", algo.data->misses);
+    if (frame_bytes > 0)
+        printf("Bytes in Mem: %llu, ", (unsigned long long)algo.data->num_frames * frame_bytes);
+    else
+        printf("Frames in Mem: %d, ", algo.data->num_frames);
+    printf("Hits: %llu, ", (unsigned long long)algo.data->hits);
+    printf("Misses: %llu, ", (unsigned long long)algo.data->misses);
     printf("Hit Ratio: %f, ", (double)algo.data->hits/(double)(algo.data->hits + algo.data->misses));
-    printf("Total Execution Time: %f seconds\n", (double)algo.data->exec_time/CLOCKS_PER_SEC);
+    if (trace_has_sizes)
+        printf("Byte Hit Ratio: %f, ", (double)algo.data->byte_hits/(double)(algo.data->byte_hits + algo.data->byte_misses));
+    printf("Total Execution Time: %f seconds\n", latency_ns(algo.data->exec_ticks) / 1e9);
+    if (latency_report)
+        print_latency(algo.data);
+    if (algo.data->prefetch != NULL)
+        print_prefetch(algo.data->prefetch);
+    if (algo.data->shadow != NULL)
+        print_shadow(algo.data->shadow);
+    if (algo.algo == &ADAPTIVE)
+        print_adaptive(algo.data);
+    print_tenants(algo.data);
+    return 0;
+}
+
+
+// Print a struct-of-arrays page table
+int print_frame_arrays(const Frame_Arrays *arrays, const char *meta_label)
+{
+    int colsize = 9, labelsize = 10;
+    printf("%-*s: ", labelsize, "Frame #");
+    for (int i = 0; i < arrays->size; i++)
+        printf("%*d", colsize, i);
+    printf("\n%-*s: ", labelsize, "Page Ref");
+    for (int i = 0; i < arrays->size; i++)
+    {
+        if (arrays->page[i] == -1)
+            printf("%*s", colsize, "_");
+        else
+            printf("%*d", colsize, arrays->page[i]);
+    }
+    printf("\n%-*s: ", labelsize, meta_label);
+    for (int i = 0; i < arrays->size; i++)
+        printf("%*u", colsize, arrays->meta[i]);
+    printf("\n\n");
     return 0;
 }
 
+// Print each set's blocks, way by way, with the policy's state byte
+int print_set_cache(const Set_Cache *sc)
+{
+    int colsize = 9;
+    for (int s = 0; s < sc->num_sets; s++)
+    {
+        unsigned char *set = set_cache_set(sc, s);
+        printf("Set %-6d: ", s);
+        for (int way = 0; way < sc->ways; way++)
+        {
+            if (way < SET_USED(set))
+                printf("%*d", colsize, SET_TAGS(set)[way]);
+            else
+                printf("%*s", colsize, "_");
+        }
+        printf("\n%-10s: ", "State");
+        for (int way = 0; way < sc->ways; way++)
+            printf("%*u", colsize, SET_STATE(sc, set)[way]);
+        printf("\n");
+    }
+    printf("\n");
+    return 0;
+}
 
 // Print list
 int print_list(struct Frame *head, const char *index_label, const char *value_label)
@@ -1260,7 +9193,7 @@ int print_list(struct Frame *head, const char *index_label, const char *value_la
     printf("\n%-*s: ", labelsize, "Time");
     for (framep = head; framep != NULL; framep = framep->frames.le_next)
     {
-        printf("%*d ", colsize, (int32_t)(framep->time % 200000000));
+        printf("%*llu ", colsize, (unsigned long long)framep->time);
     }
     printf("\n\n");
     return 0;
@@ -1270,17 +9203,30 @@ int print_list(struct Frame *head, const char *index_label, const char *value_la
 int cleanup()
 {
     size_t i = 0;
+    if (stream_mode)
+        close_trace_stream(&trace_stream);
+    unmap_trace(&trace_map);
+    free(trace_array);
+    free(sample_array);
     for (i = 0; i < num_algos; i++)
     {
-        /* Clean up memory, delete the list */
-        while (algos[i].data->page_table.lh_first != NULL)
-        {
-            LIST_REMOVE(algos[i].data->page_table.lh_first, frames);
-        }
-        while (algos[i].data->victim_list.lh_first != NULL)
-        {
-            LIST_REMOVE(algos[i].data->victim_list.lh_first, frames);
-        }
+        /* Clean up memory, delete the lists */
+        destroy_algo_data_store(algos[i].data);
+        algos[i].data = NULL;
+    }
+    free(next_use_index);
+    free(prev_use_index);
+    free(sweep_frames);
+    free(trace_tenants);
+    free(size_array);
+    free(tenant_pids);
+    key_map_free(&ref_keys);
+    key_map_free(&tenant_map);
+    if (interval_file != NULL)
+    {
+        if (interval_json)
+            fprintf(interval_file, "\n]\n");
+        fclose(interval_file);
     }
     return 0;
 }
@@ -1,74 +1,826 @@
 #ifndef PAGEREPLACEMENTALGORITHM_H
 #define PAGEREPLACEMENTALGORITHM_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/queue.h>
+
 
 // Data structures
 // List for page tables and victim lists
-LIST_HEAD(Page_Ref_List, Page_Ref) page_refs;
-// List for page tables and victim lists
 LIST_HEAD(Frame_List, Frame);
+// Queue for recency/insertion order
+TAILQ_HEAD(Frame_Queue, Frame);
+// Queue of LFU frequency buckets
+TAILQ_HEAD(Freq_Buckets, Freq_Bucket);
 
 // struct to hold Frame info
 typedef struct Page_Ref {
     LIST_ENTRY(Page_Ref) pages; 
     int page_num;
     int pid;  // Add this line if you need the process ID
+    uint32_t size; // object bytes from the trace's optional third column, 1 if it has none
 } Page_Ref;
 
 
 
+// Binary trace format
+#define TRACE_MAGIC "CRATRACE"
+#define TRACE_VERSION 1
+#define TRACE_FLAG_VARINT 0x1   // arrays hold zigzag delta varints instead of uint32_t
+#define TRACE_FLAG_SIZES 0x2    // an object size array follows the pid array
+#define TRACE_FLAG_DENSE 0x4    // pages were remapped to 0, 1, 2... in first-seen order
+
+// Fixed header at the start of a binary trace
+typedef struct
+{
+        char magic[8];          // TRACE_MAGIC, not NUL terminated
+        uint32_t version;       // TRACE_VERSION
+        uint32_t flags;         // TRACE_FLAG_*
+        uint64_t num_refs;      // refs in the trace
+        uint64_t page_offset;   // file offset of the page array
+        uint64_t page_bytes;    // size of the page array
+        uint64_t pid_offset;    // file offset of the pid array
+        uint64_t pid_bytes;     // size of the pid array
+        uint64_t size_offset;   // file offset of the size array, with TRACE_FLAG_SIZES
+        uint64_t size_bytes;    // size of the size array
+} Trace_Header;
+
+// A binary trace mapped into memory
+typedef struct
+{
+        void *base;                     // mapping, NULL if nothing is mapped
+        size_t length;
+        Trace_Header *header;
+        const unsigned char *page_data; // start of the page array
+        const unsigned char *pid_data;  // start of the pid array
+        const unsigned char *size_data; // start of the size array, NULL without TRACE_FLAG_SIZES
+        uint32_t *decoded;              // pages decoded from varints, if they had to be
+        uint32_t *decoded_sizes;        // sizes decoded from varints, if they had to be
+} Trace_Map;
+
+// A text trace parsed into arrays, in file order
+typedef struct
+{
+        int *pids;
+        int *pages;
+        uint32_t *sizes;     // object bytes, 1 for lines without a size
+        int num_refs;
+        int capacity;        // refs the arrays have room for
+        int first_sized;     // index of the first ref whose line gave a size, -1 if none did
+} Text_Trace;
+
+// A newline-aligned slice of a text trace and the refs one ingest thread parsed from it
+typedef struct
+{
+        const char *begin, *end;
+        Text_Trace refs;
+        int stopped;         // 1 if a line that is not "pid page [size]" ended the trace in this slice
+        int failed;          // 1 if the refs did not fit in memory
+} Ingest_Chunk;
+
+// Text trace parsed on a reader thread while the simulation pages what it has handed over
+#define INGEST_BATCHES 4
+typedef struct
+{
+        FILE *file;
+        pthread_t thread;
+        pthread_mutex_t lock;
+        pthread_cond_t filled;              // signalled when a batch is handed over (or the trace ends)
+        pthread_cond_t drained;             // signalled when a batch is free to refill
+        Text_Trace batches[INGEST_BATCHES]; // batch k is in slot k % INGEST_BATCHES
+        int produced, consumed;             // batches handed over, batches given back
+        int done;                           // 1 once the reader reached the end of the trace
+        int stop;                           // 1 asks the reader to quit
+        int running;                        // 1 once the reader thread is started
+        int holding;                        // 1 while the simulation reads batch consumed
+        int next;                           // next ref of the held batch
+} Ingest_Pipe;
+
+// Growable open-addressing table from 64-bit keys to dense ids 0, 1, 2... in first-seen order
+typedef struct
+{
+        uint64_t *keys;
+        int *ids;            // id of each key, -1 marks an empty slot
+        unsigned int mask;   // capacity - 1, capacity is a power of two
+        int size;            // keys held, the next id handed out
+} Key_Map;
+
+// A value per page for any page number, such as the position it was last referenced at. Pages
+// under page_ref_upper_bound index an array, the others get a Key_Map id into a growable one
+typedef struct
+{
+        int64_t *near;       // value of each page under near_size
+        int near_size;       // page_ref_upper_bound when the table was set up
+        int64_t *far;        // value of each other page, by its id in far_ids
+        int far_size;        // entries allocated in far
+        Key_Map far_ids;     // id of each page at or past near_size (or negative)
+        int64_t empty;       // value of a page not set yet
+} Page_Values;
+
+// A parsed ref held in the streaming ring
+typedef struct
+{
+        int page_num;
+        int pid;
+        int64_t next_use; // position of the next ref to the same page, INT64_MAX if not seen yet
+        int64_t prev_use; // position of the previous ref to the same page, -1 if none (or not tracked)
+        int tenant;    // tenant index of pid, 0 when tenants are not tracked
+        uint32_t size; // object bytes, 1 if the trace gives none
+} Trace_Ref;
+
+// Chunked reader that streams a trace in file order
+typedef struct
+{
+        Ingest_Pipe *pipe; // text trace, NULL when reading a mapped binary trace
+        Trace_Map map;    // binary trace
+        const unsigned char *page_cursor, *pid_cursor, *size_cursor; // varint decode position in map
+        int64_t prev_page, prev_pid, prev_size;                      // last decoded values, varints are deltas
+        Trace_Ref *ring;  // parsed refs, indexed by position & (capacity - 1)
+        int capacity;     // ring size, a power of two > window + chunk
+        int window;       // refs of lookahead kept parsed past the current ref
+        int retain;       // refs already handed out that stay in the ring
+        int64_t head;     // position of the next ref to hand out
+        int64_t tail;     // position one past the last parsed ref
+        int eof;          // 1 once the file is exhausted
+        Page_Values last_seen; // last parsed position of each page, for next_use links (near is NULL if unlinked)
+        int64_t read;     // refs read from the file or map, including sampled out ones
+        uint32_t sample_threshold; // keep only refs with shards_hash(page) below this, 0 keeps all
+} Trace_Stream;
+
 // struct to hold Frame info
 typedef struct Frame
 {
         LIST_ENTRY(Frame) frames;  // frames node, next
         int index;                 // frame position in list... not really needed
         int page;                  // page frame points to, -1 is empty
-        time_t time;               // time added/accessed
+        uint64_t time;             // logical tick added/accessed, see current_tick()
         int extra;                 // extra field for per-algo use
-        int lastUsed;  // For LRU
+        uint64_t lastUsed; // For LRU
         int frequency; // For LFU
+        TAILQ_ENTRY(Frame) order;  // recency/insertion order, head is next to evict (LRU, FIFO, MRU)
+        struct Freq_Bucket *bucket; // LFU frequency bucket holding the frame, NULL if free
+        TAILQ_ENTRY(Frame) queue;  // second queue, for policies that keep a frame on two (LIRS)
+        uint32_t size;             // what the page costs the size-aware policies, bytes with --frame-bytes
 } Frame;
 
+// Open-addressing hash table from page to the frame holding it
+typedef struct
+{
+        int *keys;           // page numbers, -1 marks an empty slot
+        Frame **values;      // frame holding each page
+        unsigned int mask;   // capacity - 1, capacity is a power of two
+} Page_Map;
+
+// Frames with one use count, in the order they reached it (head first)
+typedef struct Freq_Bucket
+{
+        int frequency;
+        struct Frame_Queue frames;         // linked through Frame.order
+        TAILQ_ENTRY(Freq_Bucket) buckets;  // neighbours in ascending frequency, or the spare list
+} Freq_Bucket;
+
+// Constant-time LFU over caller-owned frames: a page map finds a frame, its bucket gives
+// its use count, and the first and last buckets hold the least and most used frames
+typedef struct
+{
+        Page_Map map;                 // page -> frame
+        struct Freq_Buckets buckets;  // ascending frequency
+        struct Freq_Buckets spare;    // unused buckets from pool
+        Freq_Bucket *pool;            // capacity + 1 buckets, enough for any set of counts
+        struct Frame_Queue free;      // frames holding no page
+        int size;                     // frames holding a page
+        int capacity;
+} Lfu;
+
+// Frames of a ghost-list policy (ARC, 2Q, LIRS, W-TinyLFU): the page_table frames hold resident
+// pages and a pool of ghost frames (index -1) remembers evicted pages by number only. Resident
+// and ghost pages share one map, and each sits on at most one of lists (Frame.extra is its list).
+#define GHOST_CACHE_LISTS 4
+typedef struct
+{
+        Page_Map map;                                 // page -> resident or ghost frame
+        struct Frame_Queue lists[GHOST_CACHE_LISTS];  // policy lists through Frame.order, head is oldest
+        int sizes[GHOST_CACHE_LISTS];
+        struct Frame_Queue free;                      // page_table frames holding no page
+        struct Frame_Queue spare;                     // ghost frames holding no page
+        Frame *ghosts;                                // ghost pool
+        int num_ghosts;                               // frames in the ghost pool
+        int resident;                                 // page_table frames holding a page
+        int capacity;                                 // page_table frames
+} Ghost_Cache;
+
+// Count-Min Sketch of 4-bit counts for TinyLFU admission, halved every sample_size increments
+#define SKETCH_DEPTH 4
+#define SKETCH_MAX 15
+typedef struct
+{
+        uint8_t *counters;     // SKETCH_DEPTH rows of width counters
+        unsigned int mask;     // width - 1, width is a power of two
+        int additions;         // increments since the last halving
+        int sample_size;
+} Count_Min_Sketch;
+
+// Struct-of-arrays page table carved from one arena, for policies that scan every frame
+// Frames fill in index order and are never emptied, so page[0...used-1] are resident
+typedef struct
+{
+        void *arena;         // one allocation holding page[] then meta[]
+        int *page;           // page held by each frame, -1 is empty
+        uint32_t *meta;      // the policy's one word of state per frame (counter, R bit, tick)
+        int size;            // frames
+        int used;            // frames holding a page
+        int hand;            // next frame a clock hand looks at
+        uint64_t base;       // tick NRU's stamps in meta count from, so they fit in 32 bits
+} Frame_Arrays;
+
+// Set-associative cache for the set-local policies, see --assoc
+// Each set is one block of whole cache lines: int used (ways filled, in way order), int marked
+// (bit-PLRU MRU bits set), int tags[ways] (block held, -1 invalid), uint8_t state[ways] (RRPV,
+// NRU or MRU bit), then one byte per tree-PLRU node. 8 ways fit a set in a single 64-byte line.
+#define CACHE_LINE 64
+#define SET_INDEX_BITS 0  // set = block mod sets, sets must be a power of two
+#define SET_INDEX_HASH 1  // set = hash(block) mod sets
+typedef struct
+{
+        unsigned char *blocks; // num_sets blocks of stride bytes, CACHE_LINE aligned
+        int num_sets;
+        int ways;
+        int stride;            // bytes per set, a multiple of CACHE_LINE
+        int leaves;            // ways rounded up to a power of two, tree-PLRU leaves
+        int psel;              // DRRIP policy selector, followers insert like BRRIP above DRRIP_PSEL_MAX / 2
+        unsigned int inserts;  // BRRIP insertions, every BRRIP_EPSILON-th one is not distant
+} Set_Cache;
+
+// Victim history modes, see add_victim()
+#define VICTIM_HISTORY_OFF 0   // count evictions only
+#define VICTIM_HISTORY_RING 1  // keep the last victim_capacity victims
+#define VICTIM_HISTORY_POOL 2  // keep every victim, carved from pooled blocks
+#define VICTIM_POOL_BLOCK 4096 // victims per pool block
+
+// Block of victim copies for VICTIM_HISTORY_POOL, freed all at once
+typedef struct Frame_Block {
+        struct Frame_Block *next;
+        Frame frames[VICTIM_POOL_BLOCK];
+} Frame_Block;
+
+// Victims evicted from a page table, recorded without a heap allocation per eviction
+typedef struct {
+        int mode;              // VICTIM_HISTORY_*
+        uint64_t count;        // evictions, counted in every mode
+        Frame *ring;           // VICTIM_HISTORY_RING: the victim of eviction n is ring[n % capacity]
+        int capacity;
+        Frame_Block *blocks;   // VICTIM_HISTORY_POOL: newest block first
+        int used;              // frames taken from the newest block
+} Victim_History;
+
+// Tenant modes, see --tenants
+#define TENANT_OFF 0     // refs are not told apart by pid
+#define TENANT_GLOBAL 1  // one shared page table, results broken down per pid
+#define TENANT_STATIC 2  // a page table per pid, sized by static weights
+
+// One tenant's share of an algorithm's results
+typedef struct {
+        uint64_t hits;
+        uint64_t misses;
+        int frames;            // frames the tenant was given, 0 if it shares them
+} Tenant_Stats;
+
+#define LATENCY_SUB_BITS 4 // HDR sub-buckets per power of two are 1 << this, so percentiles are within 1/16
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+// Log-linear (HDR) histogram of per-ref latencies in latency_now() ticks
+typedef struct {
+        uint64_t counts[LATENCY_BUCKETS]; // values below 1 << LATENCY_SUB_BITS are exact
+        uint64_t count;        // refs recorded
+        uint64_t total;        // sum of their ticks
+        uint64_t max;
+} Latency_Histogram;
+
 // struct to hold Algorithm data
+// Prefetch modes, see --prefetch
+#define PREFETCH_OFF 0
+#define PREFETCH_SEQUENTIAL 1 // on a miss, or the first hit to a prefetched page, fetch the next pages
+#define PREFETCH_STRIDE 2     // once two refs in a row are the same stride apart, fetch along it
+
+// Prefetcher paired with one policy, and the pages the policy holds
+typedef struct {
+        Page_Map held;         // held pages, mapped to &unused while prefetched but not hit yet
+        Frame used;            // map values, only their addresses matter
+        Frame unused;
+        int count;             // pages in held
+        int last_page;         // stride detector: the previous demand ref, -1 before the first
+        long stride;           // and the stride it was reached by
+        int confirmed;
+        uint64_t issued;       // pages prefetched
+        uint64_t useful;       // prefetched pages hit by a demand ref before they were evicted
+} Prefetcher;
+
+#define REUSE_BUCKETS 32 // reuse distance buckets, bucket b counts distances in [2^b, 2^(b+1))
+
+// Shadow instrumentation of one policy, see --shadow: a hashed ring of its last window evicted
+// pages tells why each miss happened, and reuse distances are counted for its hits and misses
 typedef struct {
-        int hits;                      // number of times page was found in page table
-        int misses;                    // number of times page wasn't found in page table
+        Page_Map map;          // page -> its ghost while it is among the last window evictions
+        Frame *ghosts;         // ring of the last window evicted pages, Frame.time is the eviction's position
+        int window;
+        uint64_t evictions;    // ghosts written, the next one goes to ghosts[evictions % window]
+        int64_t now;           // position of the ref being paged, the stamp of the evictions it causes
+        uint64_t compulsory;   // misses on the first ref to a page
+        uint64_t capacity;     // misses on a page evicted more than window refs ago
+        uint64_t policy;       // misses on a page evicted within the last window refs
+        uint64_t reuse_hits[REUSE_BUCKETS];   // by log2 of the refs since the previous ref to the page
+        uint64_t reuse_misses[REUSE_BUCKETS];
+} Miss_Shadow;
+
+typedef struct Algorithm_Data {
+        uint64_t hits;                 // number of times page was found in page table
+        uint64_t misses;               // number of times page wasn't found in page table
         struct Frame_List page_table;  // List to hold frames in page table
-        struct Frame_List victim_list; // List to hold frames that were replaced in page table
-        Frame *last_victim;            // Holds last frame used as a victim to make inserting to victim list faster
+        struct Frame_List victim_list; // Frames that were replaced in page table, newest first (VICTIM_HISTORY_POOL)
+        Frame *last_victim;            // Copy of the newest victim, NULL with VICTIM_HISTORY_OFF
         void *extra;                   // For storing additional data
-        clock_t exec_time; // Store execution time for performance analysis
+        uint64_t exec_ticks;           // latency_now() ticks spent paging, for performance analysis
+        Latency_Histogram *latency;    // [0] hit path, [1] miss path of the timed refs, NULL until one is
+        Page_Map page_map;             // page -> frame lookup, for algorithms set up with one
+        struct Frame_Queue order;      // recency/insertion order of frames, for algorithms set up with one
+        void (*free_extra)(void *extra); // Frees extra, NULL if free() is enough
+        // Per-run state, so runs can be swept in parallel
+        int num_frames;                // Frames in page_table
+        int page_ref;                  // Page ref being paged
+        int64_t position;              // Trace position of page_ref, 0...num_refs (or past INT_MAX streaming)
+        unsigned int rand_state;       // RANDOM seed, for rand_r()
+        Victim_History victims;        // what add_victim() records
+        Frame *frame_arena;            // page_table frames, one allocation
+        Frame_Arrays arrays;           // struct-of-arrays page table, for algorithms set up with one
+        Lfu lfu;                       // frequency buckets over page_table, for algorithms set up with them
+        int tenant;                    // tenant of page_ref, 0 when tenants are not tracked
+        Tenant_Stats *tenants;         // per-tenant results with --tenants, grown as tenants appear
+        int num_tenants;
+        struct Algorithm_Data **partitions; // per-tenant (--tenants static) or per-set (--assoc) page tables, NULL otherwise
+        int num_partitions;
+        uint32_t size;                 // object bytes of page_ref, 1 if the trace gives none
+        uint64_t byte_hits;            // bytes of the refs that hit, counted when the trace has sizes
+        uint64_t byte_misses;
+        void (*evict_hook)(void *arg, int page); // called by add_victim() with every evicted page, NULL if none
+        void *evict_arg;
+        Prefetcher *prefetch;          // --prefetch state, NULL without one (and for the offline policies)
+        Miss_Shadow *shadow;           // --shadow state, NULL without it, partitions report to their parent's by evict_hook
+        uint64_t interval_hits;        // hits, misses, evictions and ticks as of the last --interval row
+        uint64_t interval_misses;
+        uint64_t interval_evictions;
+        uint64_t interval_ticks;
 } Algorithm_Data;
 
+// Cursor over a checkpoint file. One visitor per piece of state saves it (loading 0) or loads
+// it (loading 1), frames are written as ids into the pools of the Algorithm_Data being visited.
+typedef struct {
+        FILE *file;
+        int loading;           // 1 reads the file into the state, 0 writes the state out
+        int failed;            // a short read or write, or state this run cannot take
+        const char *error;     // what failed, NULL for an I/O error
+        Frame **pools;         // frame pools, a frame's id is its index in the pools laid end to end
+        int *pool_sizes;
+        int num_pools;
+        int pool_capacity;
+} Checkpoint;
+#define CHECKPOINT(cp, field) checkpoint_bytes((cp), &(field), sizeof(field)) // save or load one variable
+
 // an Algorithm
 typedef struct {
         const char *label;                  // Algorithm name
         int (*algo)(Algorithm_Data *data);  // Pointer to algorithm function
         int selected;                       // Should algorithm be run, 1 or 0
         Algorithm_Data *data;               // Holds algorithm data to pass into algorithm function
+        void (*setup)(Algorithm_Data *data); // Optional per-algorithm setup run after the data store is created
+        int flags;                          // ALGO_* capabilities
+        void (*checkpoint)(Checkpoint *cp, Algorithm_Data *data); // Saves or loads what setup put in extra, NULL if nothing
 } Algorithm;
 
+#define ALGO_SET_LOCAL 0x1  // models --assoc sets itself, else it runs once per set
+#define ALGO_SIZE_AWARE 0x2 // evicts by object size, the only kind run with --frame-bytes
+#define ALGO_OFFLINE 0x4    // needs the refs still to come, so it cannot back a Policy_Cache
+#define ALGO_OWN_FRAMES 0x8 // keeps its frames outside page_table, so it gets no page table
+
+#define ADAPTIVE_MAX_CANDIDATES 8 // policies --adaptive may choose between
+
+// ADAPTIVE meta-policy, see --adaptive
+// Every candidate runs a leader cache fed only the refs to a hashed sample of the pages (the
+// leader sets of set dueling), and the real cache follows whichever leader misses least
+typedef struct {
+        Algorithm candidates[ADAPTIVE_MAX_CANDIDATES]; // copies, algos[] is reordered when the results are ranked
+        int ids[ADAPTIVE_MAX_CANDIDATES];          // algos[] index of each candidate as parsed
+        Algorithm_Data *leaders[ADAPTIVE_MAX_CANDIDATES]; // sampled cache of each candidate, frames scaled by the rate
+        double score[ADAPTIVE_MAX_CANDIDATES];     // leader misses, halved every epoch
+        int epoch_misses[ADAPTIVE_MAX_CANDIDATES]; // leader misses this epoch
+        uint64_t refs_on[ADAPTIVE_MAX_CANDIDATES]; // refs the real cache paged with each candidate
+        int num_candidates;
+        int current;             // candidate the real cache runs
+        Algorithm_Data *real;    // the real cache
+        uint32_t threshold;      // refs with shards_hash(page) below this also reach the leaders
+        int samples;             // sampled refs this epoch, the epoch ends at adaptive_epoch
+        int challenger;          // candidate ahead of current by ADAPTIVE_MARGIN, -1 if none
+        int streak;              // epochs in a row the challenger has been ahead
+        uint32_t *history;       // last history_size pages, replayed into the policy switched to
+        int history_size;
+        uint64_t history_count;  // pages written to history, the next goes to history[count % size]
+        uint64_t epochs;
+        uint64_t switches;
+        uint64_t overhead_ticks; // latency_now() ticks spent in the leaders and in switches
+} Adaptive_Data;
+
+#ifdef CRA_SPECIALIZE
+// A replay loop compiled for one policy, and for the frame-array policies one frame count
+typedef void (*Replay_Fn)(Algorithm_Data *data, const uint32_t *block, int n, int64_t start);
+typedef struct {
+        int (*algo)(Algorithm_Data *data);  // policy the loop runs
+        int frames;                         // frame count it was compiled for, 0 for any
+        Replay_Fn replay;                   // runs a block starting at trace position start
+} Replay_Kernel;
+#endif
+
+
+// Mattson stack distance analyzer for LRU, a Fenwick tree over last-access time slots
+typedef struct {
+        int *tree;           // Fenwick tree, 1 at the slot of each page's last access
+        int *page_at;        // page last accessed at each slot, -1 if it was accessed again since
+        Page_Values last;    // slot of each page's last access, -1 if never accessed
+        int capacity;        // time slots, compacted (and grown) when they run out
+        int now;             // next free time slot
+        uint64_t *hist;      // hist[d] = refs with stack distance d
+        int hist_size;
+        uint64_t refs;       // refs recorded
+        uint64_t cold;       // first accesses
+        uint64_t distinct;   // distinct pages seen
+} Stack_Distance;
+
+// SHARDS sampler, feeds refs whose page hash is under a threshold to a stack distance
+// analyzer and scales their distances back up by 1/rate
+typedef struct {
+        Stack_Distance sd;     // exact distances between sampled refs
+        uint32_t threshold;    // refs are kept while shards_hash(page) < threshold
+        int max_pages;         // fixed-size budget of tracked pages, 0 keeps the rate fixed
+        uint32_t *heap_hash;   // max-heap of tracked pages by hash, for the fixed-size budget
+        int *heap_page;
+        int heap_size;
+        double *hist;          // hist[d] = estimated refs with scaled stack distance d
+        int hist_size;
+        double weight;         // estimated refs represented by the sampled ones
+        double cold;           // estimated first accesses
+        uint64_t refs;         // refs offered, sampled or not
+        uint64_t sampled;      // refs that passed the threshold
+} Shards;
+
+// One (algorithm, frame count) run of a sweep
+typedef struct {
+        Algorithm algo;      // copy of an algos[] entry, data is private to the job
+        int frames;          // page table size
+        uint64_t hits;       // results, kept after the job's data is freed
+        uint64_t misses;
+        uint64_t byte_hits;
+        uint64_t byte_misses;
+        uint64_t evictions;
+        uint64_t exec_ticks;
+        uint64_t prefetches;   // pages prefetched with --prefetch, and how many were hit
+        uint64_t useful_prefetches;
+} Sweep_Job;
+
+// Jobs shared by the worker threads
+typedef struct {
+        Sweep_Job *jobs;
+        int num_jobs;
+        atomic_int next_job; // next job index to take
+} Sweep_Pool;
+
+// One policy instance fed keys by policy_cache_access() rather than refs from a trace
+typedef struct {
+        Algorithm algo;      // copy of an algos[] entry, data is private to the cache
+        int64_t accesses;    // keys accessed so far, the policy's logical time
+} Policy_Cache;
+
+// A Policy_Cache behind its own lock, on its own cache lines so shards never false-share
+typedef struct {
+        _Alignas(CACHE_LINE) pthread_mutex_t lock;
+        Policy_Cache *cache;
+} Cache_Shard;
+
+// Thread-safe front-end, keys are spread over the shards by hash
+typedef struct {
+        Cache_Shard *shards;
+        int num_shards;
+} Sharded_Cache;
+
+#define CCLOCK_EMPTY UINT64_MAX // free Concurrent_Clock index slot
+
+// CLOCK for concurrent use: a hit is a lock-free index probe and a relaxed store of the
+// reference bit, a miss takes the lock and runs the one sweeper
+typedef struct {
+        _Atomic uint64_t *index;   // page << 32 | frame, open addressing on the page hash, CCLOCK_EMPTY if free
+        uint32_t mask;             // index slots - 1, at least twice the frames
+        atomic_int *pages;         // page held by each frame, -1 if free
+        atomic_uchar *referenced;  // reference bit of each frame, only stored to while clear
+        int size;                  // frames
+        int used;                  // frames loaded so far, under lock
+        int hand;                  // under lock
+        pthread_mutex_t lock;      // serializes misses, which move the hand and write the index
+} Concurrent_Clock;
+
+#define CONCURRENT_CLOCK 0       // --concurrent benchmark caches
+#define CONCURRENT_LOCKED_LRU 1  // one Policy_Cache behind one mutex, the baseline
+#define CONCURRENT_SHARDED_LRU 2 // a Sharded_Cache
+#define CONCURRENT_KINDS 3
+
+// xoshiro256** generator, seeded through splitmix64 so any seed gives a full state
+typedef struct {
+        uint64_t s[4];
+} Rng;
+
+#define WORKLOAD_UNIFORM 0 // uniform over the pages
+#define WORKLOAD_ZIPF 1    // rank r drawn with probability proportional to r^-alpha
+#define WORKLOAD_SCAN 2    // a loop over the first pages, broken up by sequential scans of the rest
+#define WORKLOAD_SHIFT 3   // uniform over a working set that moves to fresh pages every phase
+#define WORKLOAD_MIX 4     // one tenant (pid) of each other kind, interleaved at random
+
+// Synthetic reference stream, see workload_init() for the specs
+typedef struct Workload {
+        int kind;              // WORKLOAD_*
+        int pid;               // pid of its refs
+        int base;              // first page
+        int pages;             // distinct pages, base...base + pages - 1
+        double alpha;          // zipf skew
+        double *cdf;           // zipf: cumulative probability of ranks 1...pages
+        int span;              // scan: loop pages, shift: working set pages
+        int phase_refs;        // shift: refs before the working set moves
+        uint64_t refs;         // refs made so far
+        int cursor;            // scan: next scanned page
+        Rng rng;
+        struct Workload *parts; // mix: one workload per tenant
+        int num_parts;
+} Workload;
+
+// One thread of a --concurrent benchmark run
+typedef struct {
+        const int *keys;           // the thread's share of the trace, in trace order
+        int n;
+        int kind;                  // CONCURRENT_*
+        void *cache;               // Concurrent_Clock, Policy_Cache or Sharded_Cache
+        pthread_mutex_t *lock;     // CONCURRENT_LOCKED_LRU's mutex
+        pthread_barrier_t *start;  // all threads start together
+        uint64_t hits;
+        uint64_t misses;
+} Concurrent_Worker;
+
 
 // Init/cleanup functions
 int init();                                 // init lists and variable, set up config defaults, and load configs
-void gen_page_refs();
+int parse_options(int argc, char *argv[]);  // parse --options after the positional arguments
+int parse_frame_spec(const char *spec);     // fill sweep_frames from a --frames spec
+int select_algorithms(const char *spec);    // select algos[] by name, a comma list of names or a code
+void gen_page_refs(const char *filename);   // load a text trace into the in-memory trace arrays
+int densify_trace();                        // number the in-memory trace's pages 0, 1, 2... for --dense
 Page_Ref* gen_ref();
-Algorithm_Data *create_algo_data_store();   // returns empty algorithm data
+Algorithm_Data *create_algo_data_store(int frames, int page_table); // empty algorithm data with frames frames, in page_table if page_table is 1
+Algorithm_Data *setup_algo_data(const Algorithm *algo, int frames); // data store set up for algo (or per-tenant partitions)
+void destroy_algo_data_store(Algorithm_Data *data); // frees algorithm data and its extra
 Frame *create_empty_frame(int index);       // returns empty frame
+void init_empty_frame(Frame *framep, int index); // resets a frame to empty
 int cleanup();                              // frees allocated memory
 
 
+// Streaming functions
+int open_trace_stream(Trace_Stream *stream, const char *filename, int window, int retain);
+int read_trace_stream(Trace_Stream *stream, int *pid, int *page, uint32_t *size);
+void fill_trace_stream(Trace_Stream *stream);                // parse up to one chunk into the ring
+int trace_stream_has_ref(Trace_Stream *stream);
+int trace_stream_get_ref(Trace_Stream *stream);
+int trace_stream_peek(Trace_Stream *stream, int64_t position); // page at position, -1 if not in ring
+int trace_stream_seek(Trace_Stream *stream, int64_t offset);  // skip to offset before the first ref, -1 past the end
+void close_trace_stream(Trace_Stream *stream);
+
+
+// Ingest functions
+int parse_trace_text(const char **cursor, const char *end, int *pid, int *page, uint32_t *size, int *sized);
+int check_page(int64_t page);                        // page as an int, exits if it is outside 0...INT_MAX
+int read_text_trace(const char *filename, Text_Trace *trace); // parse a whole text trace on ingest threads
+int text_trace_push(Text_Trace *trace, int pid, int page, uint32_t size);
+void text_trace_free(Text_Trace *trace);
+Ingest_Pipe *ingest_pipe_open(const char *filename);          // start parsing filename on a reader thread
+int ingest_pipe_next(Ingest_Pipe *pipe, int *pid, int *page, uint32_t *size); // 1 on success, 0 at the end
+void ingest_pipe_close(Ingest_Pipe *pipe);
+
+
+// Binary trace functions
+int convert_trace(const char *text_file, const char *binary_file, int compress, int dense);
+int map_trace(Trace_Map *map, const char *filename);   // 0 if mapped, 1 if not a binary trace, -1 on error
+void load_mapped_trace(Trace_Map *map);                // replay a mapped trace in full
+void unmap_trace(Trace_Map *map);
+int64_t decode_zigzag(const unsigned char **cursor);
+
+
+// Struct-of-arrays page table functions
+int frame_arrays_init(Frame_Arrays *arrays, int size);
+int frame_arrays_find(const Frame_Arrays *arrays, int page); // frame holding page, -1 if not resident
+int frame_arrays_argmin(const Frame_Arrays *arrays);         // first frame with the smallest meta
+int frame_arrays_argmax(const Frame_Arrays *arrays);         // first frame with the largest meta
+void frame_arrays_free(Frame_Arrays *arrays);
+int print_frame_arrays(const Frame_Arrays *arrays, const char *meta_label);
+
+
+// Set-associative cache functions
+int set_of(int block, int sets);                             // set a block maps to, see --set-index
+int set_cache_init(Set_Cache *sc, int sets, int ways);
+unsigned char *set_cache_set(const Set_Cache *sc, int set);
+int set_cache_find(unsigned char *set, int block); // way holding block, -1 if absent
+void set_cache_free(Set_Cache *sc);
+
+
+// SIMD kernels, first match (or extreme) wins ties like the scalar loops
+int simd_init(const char *name);                             // pick kernels, "auto" for the widest
+int find_page_scalar(const int *pages, int n, int page);      // index of page, -1 if absent
+int argmin_scalar(const uint32_t *values, int n);
+int argmax_scalar(const uint32_t *values, int n);
+void halve_scalar(uint32_t *values, int n);
+#if defined(__x86_64__) || defined(__i386__)
+int find_page_avx2(const int *pages, int n, int page);
+int argmin_avx2(const uint32_t *values, int n);
+int argmax_avx2(const uint32_t *values, int n);
+void halve_avx2(uint32_t *values, int n);
+int find_page_avx512(const int *pages, int n, int page);
+int argmin_avx512(const uint32_t *values, int n);
+int argmax_avx512(const uint32_t *values, int n);
+void halve_avx512(uint32_t *values, int n);
+#endif
+#if defined(__aarch64__)
+int find_page_neon(const int *pages, int n, int page);
+int argmin_neon(const uint32_t *values, int n);
+int argmax_neon(const uint32_t *values, int n);
+void halve_neon(uint32_t *values, int n);
+#endif
+
+
+// O(1) LFU functions
+int lfu_init(Lfu *lfu, Frame *frames, int capacity);  // frames[0...capacity-1] start free
+Frame *lfu_get(Lfu *lfu, int page);                  // frame holding page, NULL if not resident
+Frame *lfu_insert(Lfu *lfu, int page);               // load page with use count 1, NULL if full
+void lfu_touch(Lfu *lfu, Frame *frame);              // count one more use
+void lfu_remove(Lfu *lfu, Frame *frame);             // evict, the frame becomes free
+Frame *lfu_least(Lfu *lfu);                          // least used, earliest to reach its count
+Frame *lfu_most(Lfu *lfu);                           // most used, earliest to reach its count
+void lfu_free(Lfu *lfu);
+
+
+// Ghost list functions, a frame must be off its list before it is evicted or forgotten
+int ghost_cache_init(Ghost_Cache *gc, Algorithm_Data *data, int ghosts); // data's frames plus ghosts ghost frames
+Frame *ghost_cache_get(Ghost_Cache *gc, int page);               // resident or ghost frame of page, NULL if neither
+Frame *ghost_cache_load(Ghost_Cache *gc, int page);              // load page into a free frame, NULL if full
+void ghost_cache_evict(Algorithm_Data *data, Ghost_Cache *gc, Frame *framep); // free a resident frame
+Frame *ghost_cache_remember(Ghost_Cache *gc, int page);          // ghost for page, NULL if none is spare
+void ghost_cache_forget(Ghost_Cache *gc, Frame *ghost);          // drop a ghost
+void ghost_cache_move(Ghost_Cache *gc, Frame *framep, int list); // to the tail (newest end) of list
+void ghost_cache_unlist(Ghost_Cache *gc, Frame *framep);
+void ghost_cache_free(Ghost_Cache *gc);
+
+
+// Count-Min Sketch functions
+int sketch_init(Count_Min_Sketch *sketch, int expected);  // sized for expected distinct pages
+void sketch_increment(Count_Min_Sketch *sketch, int page);
+int sketch_estimate(const Count_Min_Sketch *sketch, int page);
+void sketch_free(Count_Min_Sketch *sketch);
+
+
+// Tenant functions
+int key_map_init(Key_Map *map, int expected);
+int key_map_id(Key_Map *map, uint64_t key);          // id of key, added if new, -1 if out of memory
+int key_map_find(const Key_Map *map, uint64_t key);  // id of key, -1 if absent
+void key_map_free(Key_Map *map);
+int page_values_init(Page_Values *values, int64_t empty);
+int64_t *page_values_at(Page_Values *values, int page); // value of page, added if new, NULL if out of memory
+int64_t page_values_get(const Page_Values *values, int page); // value of page, empty if never added
+void page_values_clear(Page_Values *values);          // set every page back to empty
+void page_values_free(Page_Values *values);
+int ref_key(int pid, int page);                      // key a ref is paged by, (pid, page) with --pid-aware
+int tenant_of(int pid);                              // tenant index of pid, added if new
+int tenant_at(int64_t position);                       // tenant of the ref at a trace position
+uint32_t size_at(int64_t position);                    // object size of the ref at a trace position
+int parse_tenant_mode(const char *spec);             // set tenant_mode from a --tenants spec
+int tenant_frames(int frames, int *shares);          // split frames over the tenants by weight
+void tenant_count(Algorithm_Data *data, int tenant, int fault);
+int page_data(Algorithm *algo, Algorithm_Data *data); // page data->page_ref, in its partition if any
+int print_tenants(const Algorithm_Data *data);
+
+
+// Page map functions
+int page_map_init(Page_Map *map, int expected);      // allocate a map sized for expected pages
+Frame *page_map_get(Page_Map *map, int page);        // frame holding page, NULL if not resident
+void page_map_put(Page_Map *map, int page, Frame *frame);
+void page_map_remove(Page_Map *map, int page);
+void page_map_free(Page_Map *map);
+int page_map_reserve(Page_Map *map, int expected);   // grow the map to hold expected pages
+
+
 // Control functions 
 int event_loop();                           // loops for each page call
 int page(int page_ref);                     // page all algos with page ref
+int has_ref();                              // 1 while there are page refs left to test
 int get_ref();                              // get next page ref however you like
-int add_victim(struct Frame_List *victim_list, struct Frame *frame); // add victim frame to a victim list
+int next_block(const uint32_t **block, uint32_t *buffer); // next batch_size refs, 0 at the end
+int replay_batches();                       // page all selected algos a block at a time
+int page_block(Algorithm *algo, const uint32_t *block, int n, int64_t start); // run one algo over a block
+int prefetch_page(Algorithm *algo, Algorithm_Data *data); // page a demand ref, then insert its prefetches
+#ifdef CRA_SPECIALIZE
+Replay_Fn replay_kernel(int (*algo)(Algorithm_Data *data), int frames); // NULL if no loop was compiled
+#endif
+
+
+// Library functions, each cache is independent of the trace and of every other cache
+Policy_Cache *policy_cache_create(const char *label, int frames); // NULL if no online policy has label
+int policy_cache_access(Policy_Cache *cache, int key); // 1 on a miss (key is now cached), 0 on a hit, -1 if key < 0
+void policy_cache_evict_hook(Policy_Cache *cache, void (*hook)(void *arg, int key), void *arg);
+void policy_cache_destroy(Policy_Cache *cache);
+Sharded_Cache *sharded_cache_create(const char *label, int frames, int shards); // frames split over shards
+int sharded_cache_access(Sharded_Cache *cache, int key); // policy_cache_access() under the key's shard lock
+void sharded_cache_evict_hook(Sharded_Cache *cache, void (*hook)(void *arg, int key), void *arg);
+void sharded_cache_stats(Sharded_Cache *cache, uint64_t *hits, uint64_t *misses);
+void sharded_cache_destroy(Sharded_Cache *cache);
+
+
+// Concurrent CLOCK functions
+int concurrent_clock_init(Concurrent_Clock *cc, int frames);
+int concurrent_clock_access(Concurrent_Clock *cc, int page); // 1 on a miss (page is now cached), 0 on a hit
+void concurrent_clock_free(Concurrent_Clock *cc);
+void *concurrent_worker(void *arg);         // pthread entry, replays a Concurrent_Worker's keys
+int run_concurrent();                       // --concurrent: scaling of the concurrent caches over the trace
+
+
+// Workload functions
+void rng_seed(Rng *rng, uint64_t seed);
+uint64_t rng_next(Rng *rng);
+uint32_t rng_below(Rng *rng, uint32_t n);   // uniform in 0...n-1
+double rng_double(Rng *rng);                // uniform in [0, 1)
+int workload_init(Workload *w, const char *spec, int pages, uint64_t seed); // -1 if spec is not a workload
+void workload_next(Workload *w, int *pid, int *page);
+void workload_free(Workload *w);
+int load_workload(const char *spec);        // generate gen_refs refs of spec as the in-memory trace
+int run_bench(const char *specs);           // --bench: every selected algo x frame count, as CSV or JSON
+
+
+// Results output functions
+FILE *open_output(const char *path, int *json);   // buffered, *json is 1 if path ends in .json
+uint64_t eviction_count(const Algorithm_Data *data); // evictions of data and its partitions
+int write_results();                              // --output: the selected algorithms' final stats
+int write_sweep_results(const Sweep_Job *jobs, int num_jobs); // --output for sweeps
+void interval_emit(Algorithm *algo, uint64_t ticks); // --interval row, ticks is algo's exec_ticks so far
+
+
+// Latency functions
+void latency_init();                        // calibrate latency_now() ticks against CLOCK_MONOTONIC
+uint64_t latency_now();                     // TSC on x86, else CLOCK_MONOTONIC nanoseconds
+double latency_ns(uint64_t ticks);          // ticks in nanoseconds
+uint64_t latency_net(uint64_t start);       // ticks since start, less the cost of reading the clock
+void latency_record(Algorithm_Data *data, int fault, uint64_t ticks); // add one timed ref to data's histograms
+uint64_t latency_percentile(const Latency_Histogram *hist, double q); // ticks under which q of the refs fall
+int print_latency(const Algorithm_Data *data); // ns/ref and hit/miss path percentiles
+
+// Prefetch functions
+int parse_prefetch(const char *spec);       // set prefetch_kind and prefetch_degree from a --prefetch spec
+Prefetcher *prefetcher_create(int frames);
+void prefetcher_free(Prefetcher *pf);
+void prefetch_evicted(void *arg, int page); // evict hook, forgets page
+int print_prefetch(const Prefetcher *pf);   // issued, useful and wasted prefetches
+
+// Shadow functions
+int build_prev_use_index();                 // one forward pass over the in-memory trace for --shadow
+int64_t prev_use_of(int64_t position);            // previous ref to the page referenced at position, -1 if none
+Miss_Shadow *miss_shadow_create(int window);
+void miss_shadow_free(Miss_Shadow *shadow);
+void shadow_evicted(void *arg, int page);   // evict hook, remembers page as a ghost
+void shadow_count(Miss_Shadow *shadow, int page, int64_t position, int fault); // classify a demand ref once it is paged
+int print_shadow(const Miss_Shadow *shadow);   // miss classes and the reuse distance histogram
+
+
+// Parallel functions
+void *sweep_worker(void *arg);              // pthread entry, runs pool jobs
+void run_sweep_job(Sweep_Job *job);         // replay the whole trace through a job
+int run_jobs(Sweep_Job *jobs, int num_jobs);
+int run_parallel();                         // selected algos as parallel jobs
+int run_sweep();                            // selected algos x sweep_frames
+int print_sweep(Sweep_Job *jobs, int num_jobs);
+uint64_t current_tick(Algorithm_Data *data); // logical time of the ref being paged
+int add_victim(Algorithm_Data *data, struct Frame *frame); // record a victim in data's victim history
+int add_victim_page(Algorithm_Data *data, int index, int page); // victim of a struct-of-arrays page table
+int parse_victim_mode(const char *spec);    // set victim_mode from a --victims spec
+int build_next_use_index();                 // one backward pass over page_refs for OPTIMAL
+int64_t next_use_of(int64_t position, int window); // next use of the page referenced at position, INT64_MAX past window
 
 
 // Output functions
 int print_help(const char *binary);           // prints help screen
 int print_list(struct Frame *head, const char* index_label, const char* value_label); // prints a list
 int print_stats(Algorithm algo);              // detailed stats
+int print_set_cache(const Set_Cache *sc);     // blocks and state of every set
 int print_summary(Algorithm algo);            // one line summary
 
 
@@ -85,5 +837,100 @@ int NRU(Algorithm_Data *data);
 int MFU(Algorithm_Data *data);
 int LFRU(Algorithm_Data *data);
 int LFU(Algorithm_Data *data);
+int ARC(Algorithm_Data *data);
+int TWOQ(Algorithm_Data *data);
+int LIRS(Algorithm_Data *data);
+int WTINYLFU(Algorithm_Data *data);
+int GCLOCK(Algorithm_Data *data);
+int CLOCKPRO(Algorithm_Data *data);
+int UCP(Algorithm_Data *data);
+int PLRU(Algorithm_Data *data);
+int BITPLRU(Algorithm_Data *data);
+int SRRIP(Algorithm_Data *data);
+int BRRIP(Algorithm_Data *data);
+int DRRIP(Algorithm_Data *data);
+int HWNRU(Algorithm_Data *data);
+int SIZELRU(Algorithm_Data *data);
+int GDSF(Algorithm_Data *data);
+int LRU2(Algorithm_Data *data);
+int ADAPTIVE(Algorithm_Data *data);
+int parse_adaptive(const char *spec);               // fill adaptive_candidates from a --adaptive list
+int print_adaptive(const Algorithm_Data *data);     // switches, refs per candidate and leader overhead
+
+// LRU stack distance functions
+int stack_distance_init(Stack_Distance *sd, int capacity);
+int stack_distance_access(Stack_Distance *sd, int page);     // stack distance of a ref, 0 if cold
+uint64_t stack_distance_hits(Stack_Distance *sd, int frames); // LRU hits with frames frames
+void stack_distance_free(Stack_Distance *sd);
+int print_hit_ratio_curve(Stack_Distance *sd);
+int run_stack_distance();                                    // --mrc over the whole trace
+void stack_distance_forget(Stack_Distance *sd, int page);    // stop tracking page
+
+// SHARDS sampling functions
+uint64_t splitmix64(uint64_t x);                             // 64-bit mixing finalizer
+uint32_t shards_hash(int page);                              // spatial hash in 0...SHARDS_MODULUS-1
+uint32_t sample_threshold_of(double rate);                   // hash threshold for a sampling rate
+int shards_init(Shards *sh, uint32_t threshold, int max_pages);
+int shards_access(Shards *sh, int page);                     // 1 if the ref was sampled
+double shards_rate(const Shards *sh);
+void shards_finish(Shards *sh);                              // apply the fixed-rate count correction
+double shards_hit_ratio(const Shards *sh, int frames);       // estimated LRU hit ratio
+void shards_free(Shards *sh);
+int run_shards();                                            // sampled --mrc
+uint32_t sample_budget_threshold(const uint32_t *pages, int n, int max_pages);
+int sample_trace();                                          // filter the in-memory trace
+int scaled_frames(int frames);                               // page table size for a sampled trace
+int print_sample_error(Sweep_Job *exact, Sweep_Job *sampled, int num_jobs);
+
+// Checkpoint functions
+int write_checkpoint(const char *path);     // selected algorithms and the trace position, replaced atomically
+int read_checkpoint(const char *path);      // restore into the selected algorithms, sets counter
+int checkpoint_refs_left();                 // refs before the next checkpoint is due, INT_MAX if none is
+void checkpoint_fail(Checkpoint *cp, const char *what); // record the first failure
+void checkpoint_bytes(Checkpoint *cp, void *bytes, size_t n); // save or load n raw bytes
+void checkpoint_match(Checkpoint *cp, int64_t value, const char *what); // fail if the saved value differs
+void checkpoint_pool(Checkpoint *cp, Frame *frames, int n);   // frames that ids may refer to
+void checkpoint_frame(Checkpoint *cp, Frame **framep);        // a frame pointer as an id, NULL is -1
+void checkpoint_frames(Checkpoint *cp, Frame *frames, int n); // frame contents, not their links
+void checkpoint_queue(Checkpoint *cp, struct Frame_Queue *queue, int second); // through order, or queue if second
+void checkpoint_page_map(Checkpoint *cp, Page_Map *map);
+
+// Algorithm checkpoint functions, for the state setup attaches to extra
+void checkpointOptimal(Checkpoint *cp, Algorithm_Data *data);
+void checkpointLFRU(Checkpoint *cp, Algorithm_Data *data);
+void checkpointARC(Checkpoint *cp, Algorithm_Data *data);
+void checkpointTwoQ(Checkpoint *cp, Algorithm_Data *data);
+void checkpointLIRS(Checkpoint *cp, Algorithm_Data *data);
+void checkpointTinyLFU(Checkpoint *cp, Algorithm_Data *data);
+void checkpointClockPro(Checkpoint *cp, Algorithm_Data *data);
+void checkpointUCP(Checkpoint *cp, Algorithm_Data *data);
+void checkpointSetCache(Checkpoint *cp, Algorithm_Data *data);
+void checkpointSizeCache(Checkpoint *cp, Algorithm_Data *data);
+void checkpointAdaptive(Checkpoint *cp, Algorithm_Data *data);
+
+// Algorithm setup functions
+void initializeOptimal(Algorithm_Data *data);
+void initializeOptimalWindow(Algorithm_Data *data);
+void initializeRecency(Algorithm_Data *data);
+void initializeLFRU(Algorithm_Data *data);
+void initializeFrameArrays(Algorithm_Data *data);
+void initializeFrequency(Algorithm_Data *data);
+void initializeARC(Algorithm_Data *data);
+void initializeTwoQ(Algorithm_Data *data);
+void initializeLIRS(Algorithm_Data *data);
+void initializeTinyLFU(Algorithm_Data *data);
+void initializeClockPro(Algorithm_Data *data);
+void initializeUCP(Algorithm_Data *data);
+void initializeSetCache(Algorithm_Data *data);
+void initializeSizeCache(Algorithm_Data *data);
+void initializeAdaptive(Algorithm_Data *data);
+void freeOptimal(void *extra);
+void freeLFRUPartitions(void *extra);
+void freeGhostPolicy(void *extra);
+void freeTinyLFU(void *extra);
+void freeUCP(void *extra);
+void freeSetCache(void *extra);
+void freeSizeCache(void *extra);
+void freeAdaptive(void *extra);
 
 #endif
@@ -0,0 +1,77 @@
+#!/bin/sh
+# Regression check: every way of running the same trace must report the same hits and misses.
+# Run from the repository root: sh testcases/check.sh (CC and CFLAGS are honoured)
+# Builds the default and the -DCRA_SPECIALIZE binaries, then over each sample trace compares
+#   the default run with --batch 1, --threads and the specialized build,
+#   a streamed text trace with its binary and varint conversions, in memory and streamed,
+#   --mrc with an LRU --frames sweep,
+#   a run resumed from a checkpoint with an uninterrupted one.
+# In memory text traces keep their last lines in reverse, so they are only compared among themselves.
+
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2}
+FRAMES=16
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failed=0
+
+$CC $CFLAGS -pthread CacheReplacementAlgorithm.c -o "$work/cra" -lm || exit 1
+$CC $CFLAGS -pthread -DCRA_SPECIALIZE CacheReplacementAlgorithm.c -o "$work/cra_specialize" -lm || exit 1
+
+# "ALGORITHM FRAMES HITS MISSES" for every result, sorted, from either the per-algorithm or the sweep layout
+results()
+{
+    awk '/ Algorithm$/ { name = $1; next }
+         /Frames in Mem: / { match($0, /Frames in Mem: [0-9]+, Hits: [0-9]+, Misses: [0-9]+/)
+                             split(substr($0, RSTART, RLENGTH), f, /[^0-9]+/); print name, f[2], f[3], f[4]; next }
+         NF >= 5 && $2 ~ /^[0-9]+$/ && $3 ~ /^[0-9]+$/ && $4 ~ /^[0-9]+$/ { print $1, $2, $3, $4 }' | sort
+}
+
+# same NAME EXPECTED ACTUAL: report whether two result files match
+same()
+{
+    if [ -s "$2" ] && cmp -s "$2" "$3"; then
+        echo "ok    $1"
+    else
+        echo "FAIL  $1"
+        diff "$2" "$3" | head -10
+        failed=1
+    fi
+}
+
+for trace in testcases/*.addrtrace testcases/*.txt; do
+    name=$(basename "$trace")
+    "$work/cra" --convert "$trace" "$work/plain.bin" > /dev/null || exit 1
+    "$work/cra" --convert "$trace" "$work/varint.bin" --varint > /dev/null || exit 1
+
+    "$work/cra" "$trace" a $FRAMES 0 0 2>&1 | results > "$work/expected"
+    "$work/cra" "$trace" a $FRAMES 0 0 --batch 1 2>&1 | results > "$work/actual"
+    same "$name --batch 1" "$work/expected" "$work/actual"
+    "$work/cra" "$trace" a $FRAMES 0 0 --threads 4 2>&1 | results > "$work/actual"
+    same "$name --threads 4" "$work/expected" "$work/actual"
+    "$work/cra_specialize" "$trace" a $FRAMES 0 0 2>&1 | results > "$work/actual"
+    same "$name -DCRA_SPECIALIZE" "$work/expected" "$work/actual"
+
+    "$work/cra" "$trace" a $FRAMES 0 0 --stream 2>&1 | results > "$work/expected"
+    for run in "plain.bin" "plain.bin --stream" "varint.bin" "varint.bin --stream"; do
+        set -- $run
+        "$work/cra" "$work/$1" a $FRAMES 0 0 $2 2>&1 | results > "$work/actual"
+        same "$name --stream vs $run" "$work/expected" "$work/actual"
+    done
+
+    "$work/cra" "$trace" LRU $FRAMES 0 0 --frames 1..256:pow2 2>&1 | results | awk '{ print $2, $3, $4 }' | sort > "$work/expected"
+    "$work/cra" "$trace" LRU $FRAMES 0 0 --frames 1..256:pow2 --mrc 2>&1 | awk '$1 ~ /^[0-9]+$/ && NF == 4 { print $1, $2, $3 }' | sort > "$work/actual"
+    same "$name --mrc vs LRU sweep" "$work/expected" "$work/actual"
+
+    for run in "$trace" "$work/plain.bin --stream" "$work/varint.bin --stream"; do
+        set -- $run
+        "$work/cra" "$1" a $FRAMES 0 0 $2 2>&1 | results > "$work/expected"
+        rm -f "$work/checkpoint"
+        "$work/cra" "$1" a $FRAMES 0 0 $2 --checkpoint "$work/checkpoint" --checkpoint-at 500 > /dev/null 2>&1
+        "$work/cra" "$1" a $FRAMES 0 0 $2 --resume "$work/checkpoint" 2>&1 | results > "$work/actual"
+        same "$name --resume $(basename "$1") $2" "$work/expected" "$work/actual"
+    done
+done
+
+[ $failed -eq 0 ] && echo "All checks passed" || echo "Some checks failed"
+exit $failed